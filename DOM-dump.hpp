@@ -12,8 +12,30 @@ namespace dump_as {
 
   using SerializeFn = std::function<void(const char*, size_t)>;
 
-  auto  Tags( SerializeFn, unsigned encode = codepages::codepage_utf8 ) -> mtc::api<IText>;
-  auto  Json( SerializeFn ) -> mtc::api<IText>;
+  /*
+    Options - the dumpers output is collected to the buffer of bufferSize
+    bytes and passed to the SerializeFn by the big chunks, bufferSize 0 means
+    unbuffered output; the compact output has no indentation, and the json
+    output has no line breaks and optional spaces.
+  */
+  struct Options
+  {
+    size_t  bufferSize = 0x10000;
+    bool    compact = false;
+  };
+
+  auto  Tags( SerializeFn, unsigned encode = codepages::codepage_utf8, const Options& = {} ) -> mtc::api<IText>;
+  auto  Json( SerializeFn, const Options& = {} ) -> mtc::api<IText>;
+
+  /*
+    Flush( dumper )
+
+    Finishes the dump: releases the dumper, so the closing tags are written
+    if it was the last reference, and passes the buffered output to the
+    SerializeFn, throwing its errors. The dumps with no Flush() pass the
+    buffered output when the last dumper is destroyed, ignoring the errors.
+  */
+  void  Flush( mtc::api<IText>& );
 
   template <class O>
   auto  MakeOutput( O* o ) -> SerializeFn
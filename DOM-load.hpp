@@ -2,6 +2,7 @@
 # define __DeliriX_DOM_load_hpp__
 # include "text-API.hpp"
 # include <mtc/serialize.h>
+# include <mtc/iBuffer.h>
 # include <functional>
 # include <stdexcept>
 # include <memory>
@@ -15,6 +16,17 @@ namespace load_as {
   void  Tags( mtc::api<IText>, std::function<char()> );
   void  Json( mtc::api<IText>, std::function<char()> );
 
+  /*
+    The loaders of the contiguous source scan the buffer directly, up to the
+    first '\0' if any, and pass the strings to AddBlock() as the references
+    to the buffer; the json strings with escapes are unescaped to the scratch
+    buffer reused for all the strings.
+  */
+  void  Tags( mtc::api<IText>, const std::string_view& );
+  void  Tags( mtc::api<IText>, const mtc::api<const mtc::IByteBuffer>& );
+  void  Json( mtc::api<IText>, const std::string_view& );
+  void  Json( mtc::api<IText>, const mtc::api<const mtc::IByteBuffer>& );
+
   template <class S>
   auto  MakeSource( S* s ) -> std::function<char()>
   {
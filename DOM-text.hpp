@@ -2,6 +2,8 @@
 # define __DeliriX_DOM_text_hpp__
 # include "text-API.hpp"
 # include <mtc/serialize.h>
+# include <memory>
+# include <mutex>
 
 namespace DeliriX
 {
@@ -61,24 +63,46 @@ namespace DeliriX
     auto  GetBlocks() const -> mtc::span<const Paragraph> override  {  return blocks;  }
     auto  GetMarkup() const -> mtc::span<const MarkupTag> override  {  return markup;  }
     auto  GetLength() const -> uint32_t override                    {  return length;  };
+    auto  GetBlockPos( uint32_t ) const -> BlockPos override;
+    auto  GetText( uint32_t, uint32_t ) const -> std::vector<TextChunk> override;
 
-  // elements access
-    auto  GetBlocks() -> std::vector<Paragraph>& {  return blocks;  }
-    auto  GetMarkup() -> std::vector<MarkupTag>& {  return markup;  }
+  // elements access; the blocks changed by the caller drop the offsets, got
+  // again once by the next index build
+    auto  GetBlocks() -> std::vector<Paragraph>& {  return tindex.reset(), blkoff.clear(), blocks;  }
+    auto  GetMarkup() -> std::vector<MarkupTag>& {  return tindex.reset(), markup;  }
 
   // modification
     void  clear();
 
+  // arena mode: the paragraphs added are allocated from the document-owned
+  // chunks of chunkSize bytes and released in one step with clear(); 0 turns
+  // the arena off
+    void  SetArena( size_t chunkSize = 0x10000 );
+
   // serialization
-    auto  GetBufLen() const -> size_t;
+    auto  GetBufLen( unsigned version = dump_v1 ) const -> size_t;
   template <class S>
     auto  FetchFrom( S* ) -> S*;
 
   protected:
-    std::vector<Paragraph>  blocks;
-    std::vector<MarkupTag>  markup;
-    Markup*                 nested = nullptr;
-    uint32_t                length = 0;
+    bool  FetchDump( std::function<bool( void*, size_t )> );
+    bool  FetchZ( const char*, size_t );
+
+  protected:
+    auto  GetArena() -> ParagraphArena* override  {  return arena.get();  }
+    auto  GetIndex() const -> std::shared_ptr<const TextIndex> override;
+
+  protected:
+    std::vector<Paragraph>          blocks;
+    std::vector<MarkupTag>          markup;
+    Markup*                         nested = nullptr;
+    uint32_t                        length = 0;
+    mutable std::vector<uint32_t>   blkoff;     // block start offsets, valid if sized as blocks
+    std::unique_ptr<ParagraphArena> arena;
+
+  // the structural index is built on demand and dropped on any change
+    mutable std::mutex                        mxlock;
+    mutable std::shared_ptr<const TextIndex>  tindex;
 
   };
 
@@ -87,43 +111,7 @@ namespace DeliriX
   template <class S>
   S*  Text::FetchFrom( S* s )
   {
-    size_t  length;
-
-    clear();
-
-  // get strings vector length value
-    if ( (s = ::FetchFrom( s, length )) != nullptr )  blocks.resize( length );
-      else return nullptr;
-
-  // get strings
-    for ( auto& str: blocks )
-    {
-      if ( !str.FetchFrom( [&]( void* p, size_t l ){  return (s = ::FetchFrom( s, p, l )) != nullptr;  } ) )
-        return s;
-      length += str.GetTextSize();
-    }
-
-    if ( (s = ::FetchFrom( s, length )) != nullptr )  markup.resize( length );
-      else return nullptr;
-
-    for ( auto& tag: markup )
-    {
-      size_t  taglen;
-
-      if ( (s = ::FetchFrom( s, taglen )) == nullptr )
-        return nullptr;
-
-      tag.tagKey.resize( taglen );
-
-      s = ::FetchFrom( ::FetchFrom( ::FetchFrom( s, (void*)tag.tagKey.c_str(), taglen ),
-        tag.uLower ),
-        tag.uUpper );
-
-      if ( s == nullptr )
-        return nullptr;
-    }
-
-    return s;
+    return FetchDump( [&]( void* p, size_t l ){  return (s = ::FetchFrom( s, p, l )) != nullptr;  } ) ? s : nullptr;
   }
 
 }
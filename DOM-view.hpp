@@ -0,0 +1,25 @@
+# if !defined( __DeliriX_DOM_view_hpp__ )
+# define __DeliriX_DOM_view_hpp__
+# include "text-API.hpp"
+# include <mtc/iBuffer.h>
+
+namespace DeliriX {
+namespace view_as {
+
+  /*
+    Dump( buffer )
+
+    Opens the document serialized by ITextView::Serialize( O*, version ) as
+    the read-only text view over the buffer: the paragraphs reference the text
+    in the buffer with no copying, and the buffer is held while the view or
+    any paragraph got from it is alive.
+
+    The paragraphs are not zero-terminated. Returns nullptr for invalid or
+    truncated data and for the compressed dumps, which have no text to be
+    referenced; throws std::invalid_argument for no buffer.
+  */
+  auto  Dump( const mtc::api<const mtc::IByteBuffer>& ) -> mtc::api<const ITextView>;
+
+}}
+
+# endif // !__DeliriX_DOM_view_hpp__
@@ -0,0 +1,101 @@
+# if !defined( __DeliriX_DOM_zdump_hpp__ )
+# define __DeliriX_DOM_zdump_hpp__
+# include "text-API.hpp"
+# include <mtc/iBuffer.h>
+# include <functional>
+# include <vector>
+
+namespace DeliriX {
+namespace zdump {
+
+  /*
+    The compressed dump (ITextView::dump_z) is the v2 dump split into the
+    separately deflated chunks: the head with the blocks columns, the tail
+    with the markup and the text chunks of whole blocks, about chunkSize
+    bytes each. The chunks table follows the signature, so the parts of
+    the document may be inflated with no need to inflate the rest.
+
+    The chunks may be deflated with the preset dictionary to improve the
+    ratio on small documents; the dictionaries are identified by the adler32
+    checksum as zlib does and have to be registered with AddDictionary()
+    before the dumps packed with them are read.
+  */
+  struct Options
+  {
+    uint32_t                          chunkSize = 0x10000;
+    int                               level = 6;
+    mtc::api<const mtc::IByteBuffer>  dictionary;
+  };
+
+  /*
+    Train( samples, maxSize )
+
+    Builds the preset dictionary of up to maxSize bytes (zlib uses the last
+    32K at most) from the segments of the sample documents dumps rich with
+    the byte sequences shared by several documents.
+  */
+  auto  Train( const std::vector<mtc::api<const ITextView>>&, size_t maxSize = 0x8000 ) -> mtc::api<const mtc::IByteBuffer>;
+
+  // registers the dictionary for reading; returns the dictionary id
+  auto  AddDictionary( const mtc::api<const mtc::IByteBuffer>& ) -> uint32_t;
+
+  /*
+    GetBufLen( text, options )
+
+    Returns the upper bound of the compressed dump size got with no deflate:
+    the bound of every chunk by deflateBound(), so the real dump is usually
+    several times shorter.
+  */
+  auto  GetBufLen( const ITextView&, const Options& = {} ) -> size_t;
+
+  bool  Serialize( std::function<bool( const void*, size_t )>, const ITextView&, const Options& = {} );
+
+  template <class O>
+  O*    Serialize( O* o, const ITextView& text, const Options& options = {} )
+  {
+    return Serialize( [&]( const void* p, size_t l ){  return (o = ::Serialize( o, p, l )) != nullptr;  }, text, options ) ? o : nullptr;
+  }
+
+  /*
+    Reader - random access to the compressed dump.
+
+    Inflates the head and the tail on open, and the text chunks covering the
+    blocks requested only. Throws std::invalid_argument for the data other
+    than the compressed dump, DeliriX::Error for corrupted data or unknown
+    dictionary.
+  */
+  class Reader
+  {
+    friend struct Layout;
+
+    struct Chunk;
+
+  public:
+    Reader( const mtc::api<const mtc::IByteBuffer>& );
+   ~Reader();
+
+    auto  GetBlockCount() const -> size_t                   {  return blocks.size();  }
+    auto  GetMarkup() const -> mtc::span<const MarkupTag>   {  return markup;  }
+    auto  GetLength() const -> uint32_t                     {  return length;  }
+
+  // gets count blocks starting at first, inflating the chunks covering them
+    auto  GetBlocks( size_t first, size_t count ) const -> std::vector<Paragraph>;
+
+  protected:
+    struct Block
+    {
+      uint32_t  encode;
+      uint32_t  length;
+    };
+
+    mtc::api<const mtc::IByteBuffer>  buffer;
+    std::vector<Block>                blocks;
+    std::vector<Chunk>                chunks;     // the text chunks
+    std::vector<MarkupTag>            markup;
+    uint32_t                          length = 0;
+
+  };
+
+}}
+
+# endif   // !__DeliriX_DOM_zdump_hpp__
@@ -6,19 +6,43 @@
 namespace DeliriX
 {
 
+  /*
+    IArchive - read-only access to archive members.
+
+    GetFile(), GetCount(), GetEntry() and FindEntry() may be called from
+    several threads at once: each extraction uses its own decoder over the
+    shared source buffer.
+  */
   struct IArchive: mtc::Iface
   {
     struct IEntry;
 
     virtual auto  GetFile( const char* ) -> mtc::api<const mtc::IByteBuffer> = 0;
     virtual auto  ReadDir() -> mtc::api<IEntry> = 0;
+
+  // indexed directory access; does not change the ReadDir() cursor
+    virtual auto  GetCount() const -> size_t = 0;
+    virtual auto  GetEntry( size_t ) -> mtc::api<IEntry> = 0;
+    virtual auto  FindEntry( const char* ) -> mtc::api<IEntry> = 0;
   };
 
   struct IArchive::IEntry: mtc::Iface
   {
+    enum: uint32_t
+    {
+      stored = 0,
+      deflated = 8
+    };
+
     virtual auto  GetAttr() const -> uint32_t = 0;
     virtual auto  GetName() const -> std::string = 0;
     virtual auto  GetFile() const -> mtc::api<const mtc::IByteBuffer> = 0;
+
+  // entry metadata got from the archive directory with no decompression
+    virtual auto  GetSize() const -> uint64_t = 0;
+    virtual auto  GetPackedSize() const -> uint64_t = 0;
+    virtual auto  GetMethod() const -> uint32_t = 0;
+    virtual auto  GetCRC32() const -> uint32_t = 0;
   };
 
   auto  OpenZip( const mtc::api<const mtc::IByteBuffer>& ) -> mtc::api<IArchive>;
@@ -0,0 +1,47 @@
+# if !defined( __DeliriX_batch_hpp__ )
+# define __DeliriX_batch_hpp__
+# include "DOM-text.hpp"
+# include "formats.hpp"
+# include <vector>
+
+namespace DeliriX
+{
+
+  /*
+    BatchResult - the outcome of one document in a batch: the format detected
+    and the error message if the document failed; failures do not break the
+    rest of the batch.
+  */
+  struct BatchResult
+  {
+    Format          format = Format::unknown;
+    std::string     error;            // empty if the document was parsed
+    mtc::api<Text>  output;           // the text created by ParseBatch( sources )
+
+    bool  Succeeded() const {  return error.empty();  }
+  };
+
+  /*
+    ParseBatch( sources, outputs, nthreads )
+
+    Parses each sources[i] with ParseAny() into outputs[i] on a work-stealing
+    thread pool of nthreads workers; nthreads == 0 means hardware concurrency.
+    Outputs must be independent sinks, one per source.
+
+    ParseBatch( sources, nthreads )
+
+    Creates the Text output for each document and returns it in the result.
+
+    Throws std::invalid_argument if sources and outputs count differ.
+  */
+  auto  ParseBatch(
+    const std::vector<mtc::api<const mtc::IByteBuffer>>&  sources,
+    const std::vector<mtc::api<IText>>&                   outputs,
+    unsigned                                              nthreads = 0 ) -> std::vector<BatchResult>;
+  auto  ParseBatch(
+    const std::vector<mtc::api<const mtc::IByteBuffer>>&  sources,
+    unsigned                                              nthreads = 0 ) -> std::vector<BatchResult>;
+
+}
+
+# endif   // !__DeliriX_batch_hpp__
@@ -0,0 +1,42 @@
+# include "bench.hpp"
+# include "../batch.hpp"
+# include <mtc/byteBuffer.h>
+# include <mtc/wcsstr.h>
+# include <algorithm>
+# include <thread>
+
+using namespace DeliriX;
+
+extern unsigned char  sample_odtzip_buf[];
+extern unsigned       sample_odtzip_len;
+extern unsigned char  sample_docxDeliriX_buf[];
+extern unsigned       sample_docxDeliriX_len;
+
+/*
+  batch/ParseBatch
+
+  Parses a batch of the sample documents on 1, 2, 4... up to hardware
+  concurrency threads; the throughput should scale close to linearly.
+*/
+bench::RegisterSuite  bench_batch( "batch/ParseBatch", []()
+{
+  auto  sources = std::vector<mtc::api<const mtc::IByteBuffer>>();
+  auto  ncores = std::max( std::thread::hardware_concurrency(), 1U );
+  auto  nbytes = size_t(0);
+
+  for ( int i = 0; i != 128; ++i )
+  {
+    sources.push_back( mtc::CreateByteBuffer( sample_odtzip_buf, sample_odtzip_len ).ptr() );
+    sources.push_back( mtc::CreateByteBuffer( sample_docxDeliriX_buf, sample_docxDeliriX_len ).ptr() );
+    nbytes += sample_odtzip_len + sample_docxDeliriX_len;
+  }
+
+  for ( unsigned nthreads = 1; ; nthreads = std::min( nthreads * 2, ncores ) )
+  {
+    bench::Measure( mtc::strprintf( "%u documents, %u threads", unsigned(sources.size()), nthreads ), [&]()
+      {  return ParseBatch( sources, nthreads ), nbytes;  } );
+
+    if ( nthreads == ncores )
+      break;
+  }
+} );
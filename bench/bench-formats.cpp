@@ -0,0 +1,177 @@
+# include "bench.hpp"
+# include "../DOM-text.hpp"
+# include "../archive.hpp"
+# include <mtc/byteBuffer.h>
+# include <mtc/wcsstr.h>
+
+using namespace DeliriX;
+
+extern unsigned char  sample_odtzip_buf[];
+extern unsigned       sample_odtzip_len;
+extern unsigned char  sample_odtDeliriX_buf[];
+extern unsigned       sample_odtDeliriX_len;
+extern unsigned char  sample_docxDeliriX_buf[];
+extern unsigned       sample_docxDeliriX_len;
+extern unsigned char  sample_fb2Panov_buf[];
+extern unsigned       sample_fb2Panov_len;
+
+using ParseFn = std::function<void( IText*, const mtc::api<const mtc::IByteBuffer>& )>;
+
+// the main document part size for the archives, else the source size
+static  auto  GetMarkupSize( const mtc::api<const mtc::IByteBuffer>& source ) -> size_t
+{
+  switch ( GetFormat( source ) )
+  {
+    case Format::odt:   return OpenZip( source )->GetFile( "content.xml" )->GetLen();
+    case Format::docx:  return OpenZip( source )->GetFile( "word/document.xml" )->GetLen();
+    default:            return source->GetLen();
+  }
+}
+
+/*
+  ParseDocs( title, parse, source )
+
+  Parses the document to the new Text; an operation is a document, so the
+  ops/s are the documents per second, and the MB/s are got by the markup
+  size, unpacked for odt and docx.
+*/
+static  void  ParseDocs( const std::string& title, const ParseFn& parse, const mtc::api<const mtc::IByteBuffer>& source )
+{
+  auto  nbytes = GetMarkupSize( source );
+
+  bench::Measure( title, [&]()
+    {
+      auto  text = Text();
+
+      return parse( &text, source ), nbytes;
+    } );
+}
+
+static  void  ParseAll( const char* format, const ParseFn& parse,
+  const std::vector<std::pair<const char*, mtc::api<const mtc::IByteBuffer>>>& samples, Format synthetic )
+{
+  for ( auto& sample: samples )
+    ParseDocs( mtc::strprintf( "%s, %s", format, sample.first ), parse, sample.second );
+
+  for ( auto length: { 0x100000, 0x1000000 } )
+  {
+    auto  source = bench::MakeDocument( synthetic, length );
+
+    ParseDocs( mtc::strprintf( "%s, synthetic %u MB", format, unsigned(length >> 20) ), parse,
+      mtc::CreateByteBuffer( source.data(), source.size() ).ptr() );
+  }
+}
+
+static  auto  Sample( unsigned char* buf, unsigned len ) -> mtc::api<const mtc::IByteBuffer>
+{
+  return mtc::CreateByteBuffer( (const char*)buf, len ).ptr();
+}
+
+/*
+  formats/OpenZip
+
+  Opens the archives and gets the main document part.
+*/
+bench::RegisterSuite  bench_open_zip( "formats/OpenZip", []()
+{
+  auto  samples = std::vector<std::pair<const char*, mtc::api<const mtc::IByteBuffer>>>{
+    { "keva.odt", Sample( sample_odtzip_buf, sample_odtzip_len ) },
+    { "DeliriX.odt", Sample( sample_odtDeliriX_buf, sample_odtDeliriX_len ) },
+    { "DeliriX.docx", Sample( sample_docxDeliriX_buf, sample_docxDeliriX_len ) } };
+
+  for ( auto& sample: samples )
+  {
+    bench::Measure( mtc::strprintf( "OpenZip, %s", sample.first ), [&]()
+      {
+        auto  zarc = OpenZip( sample.second );
+
+        return zarc->GetFile( zarc->FindEntry( "content.xml" ) != nullptr ? "content.xml" : "word/document.xml" )->GetLen();
+      } );
+  }
+} );
+
+/*
+  formats/ParseXML
+
+  The generic xml parser with no format adapter.
+*/
+bench::RegisterSuite  bench_parse_xml( "formats/ParseXML", []()
+{
+  ParseAll( "ParseXML", []( IText* text, const mtc::api<const mtc::IByteBuffer>& src ){  ParseXML( text, src );  },
+    { { "panov.fb2", Sample( sample_fb2Panov_buf, sample_fb2Panov_len ) } }, Format::xml );
+} );
+
+/*
+  formats/ParseFB2, formats/ParseODT, formats/ParseDOCX
+
+  The format parsers in the source encoding output; the samples are parsed
+  with the UTF-16 output, too.
+*/
+bench::RegisterSuite  bench_parse_fb2( "formats/ParseFB2", []()
+{
+  auto  sample = Sample( sample_fb2Panov_buf, sample_fb2Panov_len );
+
+  ParseAll( "ParseFB2", []( IText* text, const mtc::api<const mtc::IByteBuffer>& src ){  ParseFB2( text, src );  },
+    { { "panov.fb2", sample } }, Format::fb2 );
+  ParseDocs( "ParseFB2, panov.fb2, utf16", []( IText* text, const mtc::api<const mtc::IByteBuffer>& src )
+    {  ParseFB2( text, src, TextOutput::utf16 );  }, sample );
+} );
+
+bench::RegisterSuite  bench_parse_odt( "formats/ParseODT", []()
+{
+  auto  sample = Sample( sample_odtDeliriX_buf, sample_odtDeliriX_len );
+
+  ParseAll( "ParseODT", []( IText* text, const mtc::api<const mtc::IByteBuffer>& src ){  ParseODT( text, src );  },
+    { { "keva.odt", Sample( sample_odtzip_buf, sample_odtzip_len ) }, { "DeliriX.odt", sample } }, Format::odt );
+  ParseDocs( "ParseODT, DeliriX.odt, utf16", []( IText* text, const mtc::api<const mtc::IByteBuffer>& src )
+    {  ParseODT( text, src, TextOutput::utf16 );  }, sample );
+} );
+
+bench::RegisterSuite  bench_parse_docx( "formats/ParseDOCX", []()
+{
+  auto  sample = Sample( sample_docxDeliriX_buf, sample_docxDeliriX_len );
+
+  ParseAll( "ParseDOCX", []( IText* text, const mtc::api<const mtc::IByteBuffer>& src ){  ParseDOCX( text, src );  },
+    { { "DeliriX.docx", sample } }, Format::docx );
+  ParseDocs( "ParseDOCX, DeliriX.docx, utf16", []( IText* text, const mtc::api<const mtc::IByteBuffer>& src )
+    {  ParseDOCX( text, src, TextOutput::utf16 );  }, sample );
+
+// the cost of the stats collected
+  ParseDocs( "ParseDOCX, DeliriX.docx, stats", []( IText* text, const mtc::api<const mtc::IByteBuffer>& src )
+    {
+      auto  stats = ParseStats();
+
+      ParseDOCX( text, src, TextOutput::source, &stats );
+    }, sample );
+} );
+
+/*
+  formats/CopyUtf16
+
+  Converts the parsed documents to the UTF-16 Text; the bytes are the source
+  texts size.
+*/
+bench::RegisterSuite  bench_copy_utf16( "formats/CopyUtf16", []()
+{
+  auto  samples = std::vector<std::pair<const char*, mtc::api<const mtc::IByteBuffer>>>{
+    { "panov.fb2", Sample( sample_fb2Panov_buf, sample_fb2Panov_len ) },
+    { "DeliriX.docx", Sample( sample_docxDeliriX_buf, sample_docxDeliriX_len ) } };
+
+  for ( auto& sample: samples )
+  {
+    auto  source = Text();
+    auto  nbytes = size_t(0);
+
+    ParseAny( &source, sample.second );
+
+    for ( auto& next: source.GetBlocks() )
+      nbytes += next.GetTextSize();
+
+    bench::Measure( mtc::strprintf( "CopyUtf16, %s", sample.first ), [&]()
+      {
+        auto  output = Text();
+
+        return CopyUtf16( &output, source ), nbytes;
+      } );
+  }
+} );
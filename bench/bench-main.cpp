@@ -0,0 +1,206 @@
+# include "bench.hpp"
+# include "../trace.hpp"
+# include <atomic>
+# include <chrono>
+# include <cstring>
+# include <cstdlib>
+# include <cstdio>
+# include <new>
+
+# if defined( __unix__ ) || defined( __APPLE__ )
+#   include <sys/resource.h>
+# endif
+
+namespace DeliriX {
+namespace bench {
+
+  struct Suite
+  {
+    const char*           name;
+    std::function<void()> func;
+  };
+
+  double                minTime = 0.5;
+  bool                  asJson = false;
+  const char*           suiteName = "";
+  std::atomic<size_t>   allocCount( 0 );
+
+  auto  Suites() -> std::vector<Suite>&
+  {
+    static std::vector<Suite> suites;
+
+    return suites;
+  }
+
+  RegisterSuite::RegisterSuite( const char* name, std::function<void()> func )
+  {
+    Suites().push_back( { name, func } );
+  }
+
+  // the peak RSS in bytes, 0 if not supported
+  static  auto  GetPeakRss() -> size_t
+  {
+# if defined( __unix__ ) || defined( __APPLE__ )
+    struct rusage usage;
+
+    if ( getrusage( RUSAGE_SELF, &usage ) == 0 )
+#   if defined( __APPLE__ )
+      return size_t(usage.ru_maxrss);
+#   else
+      return size_t(usage.ru_maxrss) * 1024;
+#   endif
+# endif
+    return 0;
+  }
+
+  static  auto  JsonString( const std::string& str ) -> std::string
+  {
+    auto  output = std::string( "\"" );
+
+    for ( auto chr: str )
+    {
+      if ( chr == '"' || chr == '\\' )
+        output += '\\';
+      output += chr;
+    }
+    return output += '"';
+  }
+
+  auto  Measure( const std::string& name, std::function<size_t()> fn ) -> Result
+  {
+    auto  result = Result{ name };
+    auto  tstart = std::chrono::steady_clock::now();
+    auto  nalloc = size_t(0);
+
+    for ( fn(), nalloc = allocCount.load(); result.timer < minTime; )
+    {
+      result.bytes += fn();
+      result.count += 1;
+      result.timer = std::chrono::duration<double>( std::chrono::steady_clock::now() - tstart ).count();
+    }
+
+    result.allocs = double(allocCount.load() - nalloc) / result.count;
+    result.peakRss = GetPeakRss();
+
+    if ( asJson )
+    {
+      fprintf( stdout, "{\"suite\":%s,\"name\":%s,\"count\":%zu,\"bytes\":%zu,\"seconds\":%.6f,"
+        "\"MBps\":%.3f,\"opsps\":%.3f,\"allocs\":%.2f,\"peakRss\":%zu}\n",
+        JsonString( suiteName ).c_str(), JsonString( name ).c_str(),
+        result.count, result.bytes, result.timer,
+        result.bytes / result.timer / (1024 * 1024),
+        result.count / result.timer, result.allocs, result.peakRss );
+    }
+      else
+    {
+      fprintf( stdout, "%-48s %10.2f MB/s %12.1f ops/s %12.1f allocs/op %8.1f MB peak\n", name.c_str(),
+        result.bytes / result.timer / (1024 * 1024),
+        result.count / result.timer, result.allocs,
+        result.peakRss / (1024.0 * 1024) );
+    }
+    fflush( stdout );
+
+    return result;
+  }
+
+}}
+
+/*
+  The operator new calls counter; the C allocations by zlib and minizip are
+  not counted.
+*/
+void* operator new( size_t size )
+{
+  auto  ptr = malloc( size != 0 ? size : 1 );
+
+  if ( ptr == nullptr )
+    throw std::bad_alloc();
+
+  return ++DeliriX::bench::allocCount, ptr;
+}
+
+void* operator new[]( size_t size )
+{
+  return operator new( size );
+}
+
+void* operator new( size_t size, const std::nothrow_t& ) noexcept
+{
+  auto  ptr = malloc( size != 0 ? size : 1 );
+
+  if ( ptr != nullptr )
+    ++DeliriX::bench::allocCount;
+
+  return ptr;
+}
+
+void* operator new[]( size_t size, const std::nothrow_t& tag ) noexcept
+{
+  return operator new( size, tag );
+}
+
+void  operator delete( void* ptr ) noexcept               {  free( ptr );  }
+void  operator delete[]( void* ptr ) noexcept             {  free( ptr );  }
+void  operator delete( void* ptr, size_t ) noexcept       {  free( ptr );  }
+void  operator delete[]( void* ptr, size_t ) noexcept     {  free( ptr );  }
+
+/*
+  DeliriX-bench [--json] [--min-time=seconds] [--trace=file] [suite filter...]
+
+  --trace writes the Chrome Trace JSON of the suites run to the file, the
+  last events of each thread only.
+*/
+int   main( int argc, char* argv[] )
+{
+  auto  filter = std::vector<const char*>();
+  auto  traced = (const char*)nullptr;
+  auto  nfound = 0;
+
+  for ( int i = 1; i < argc; ++i )
+  {
+    if ( strcmp( argv[i], "--json" ) == 0 )
+      DeliriX::bench::asJson = true;
+    else if ( strncmp( argv[i], "--min-time=", 11 ) == 0 )
+      DeliriX::bench::minTime = atof( argv[i] + 11 );
+    else if ( strncmp( argv[i], "--trace=", 8 ) == 0 )
+      traced = argv[i] + 8;
+    else if ( strncmp( argv[i], "--", 2 ) == 0 )
+      return fprintf( stderr, "usage: %s [--json] [--min-time=seconds] [--trace=file] [suite filter...]\n", argv[0] ), -1;
+    else
+      filter.push_back( argv[i] );
+  }
+
+  if ( traced != nullptr )
+    DeliriX::trace::Start();
+
+  for ( auto& suite: DeliriX::bench::Suites() )
+  {
+    bool  select = filter.empty();
+
+    for ( auto next = filter.begin(); next != filter.end() && !select; ++next )
+      select = strstr( suite.name, *next ) != nullptr;
+
+    if ( select )
+    {
+      if ( !DeliriX::bench::asJson )
+        fprintf( stdout, "%s\n", suite.name );
+
+      DeliriX::bench::suiteName = suite.name;
+        suite.func();
+      ++nfound;
+    }
+  }
+
+  if ( traced != nullptr )
+  {
+    auto  output = fopen( traced, "wb" );
+    auto  events = DeliriX::trace::Flush();
+
+    if ( output == nullptr || fwrite( events.data(), 1, events.size(), output ) != events.size() )
+      fprintf( stderr, "failed to write the trace to '%s'\n", traced );
+
+    if ( output != nullptr )
+      fclose( output );
+  }
+  return nfound != 0 ? 0 : (fprintf( stderr, "no benchmark suites match\n" ), -1);
+}
@@ -0,0 +1,369 @@
+# include "bench.hpp"
+# include "../DOM-text.hpp"
+# include "../DOM-view.hpp"
+# include "../DOM-zdump.hpp"
+# include "../DOM-dump.hpp"
+# include "../DOM-load.hpp"
+# include "../formats.hpp"
+# include "../src/transcode.hpp"
+# include <mtc/byteBuffer.h>
+# include <mtc/serialize.h>
+# include <mtc/wcsstr.h>
+# include <moonycode/codes.h>
+# include <iterator>
+
+using namespace DeliriX;
+
+extern unsigned char  sample_odtzip_buf[];
+extern unsigned       sample_odtzip_len;
+extern unsigned char  sample_docxDeliriX_buf[];
+extern unsigned       sample_docxDeliriX_len;
+
+template <> inline
+auto  Serialize( std::string* to, const void* p, size_t l ) -> std::string*
+  {  return to->append( (const char*)p, l ), to;  }
+
+/*
+  text/AddBlock
+
+  Fills a document with 100k short paragraphs and destroys it, with the
+  paragraphs allocated on the heap one by one and in the document arena.
+*/
+bench::RegisterSuite  bench_text( "text/AddBlock", []()
+{
+  static const char*  words[] = { "lorem", "ipsum dolor sit amet", "consectetur adipiscing elit",
+    "sed do eiusmod tempor incididunt ut labore et dolore magna aliqua" };
+
+  for ( auto chunkSize: { size_t(0), size_t(0x10000) } )
+  {
+    bench::Measure( chunkSize == 0 ? "100k paragraphs, heap" : "100k paragraphs, arena", [&]()
+      {
+        auto  text = Text();
+        auto  size = size_t(0);
+
+        text.SetArena( chunkSize );
+
+        for ( size_t i = 0; i != 100000; ++i )
+          size += text.AddBlock( words[i % std::size( words )] ).GetTextSize();
+
+        return size;
+      } );
+  }
+} );
+
+/*
+  text/FindNext
+
+  Enumerates all the cells of a 1000 x 10 table; with the tag index each
+  step is a binary search, not a markup and blocks scan.
+*/
+bench::RegisterSuite  bench_find( "text/FindNext", []()
+{
+  auto  text = Text();
+  auto  table = text.AddMarkupTag( "table" );
+
+  for ( int row = 0; row != 1000; ++row )
+  {
+    auto  tr = table->AddMarkupTag( "tr" );
+
+    for ( int col = 0; col != 10; ++col )
+      tr->AddMarkupTag( "td" )->AddBlock( "cell" );
+  }
+
+  bench::Measure( "10000 table cells", [&]()
+    {
+      auto  ncells = size_t(0);
+      auto  tbview = text.FindFirst( "table" );
+
+      for ( auto tr = tbview->FindFirst( "tr" ); tr != nullptr; tr = tr->FindNext() )
+        for ( auto td = tr->FindFirst( "td" ); td != nullptr; td = td->FindNext() )
+          ncells += td->GetLength();
+
+      return ncells;
+    } );
+} );
+
+/*
+  text/Serialize
+
+  Replays a 100k paragraphs document into another Text; the paragraphs are
+  passed through, so the cost does not depend on the text size.
+*/
+bench::RegisterSuite  bench_replay( "text/Serialize", []()
+{
+  auto  source = Text();
+
+  for ( int i = 0; i != 10000; ++i )
+  {
+    auto  para = source.AddMarkupTag( "p" );
+
+    for ( int j = 0; j != 10; ++j )
+      para->AddBlock( "sed do eiusmod tempor incididunt ut labore et dolore magna aliqua" );
+  }
+
+  bench::Measure( "100k paragraphs to Text", [&]()
+    {
+      auto  output = Text();
+
+      source.Serialize( (IText*)&output );
+
+      return size_t(output.GetLength());
+    } );
+} );
+
+/*
+  text/view_as::Dump
+
+  Opens a serialized 100k paragraphs document by Text::FetchFrom() copying
+  the text and as the view over the buffer.
+*/
+bench::RegisterSuite  bench_view( "text/view_as::Dump", []()
+{
+  auto  source = Text();
+  auto  buffer = std::string();
+
+  for ( int i = 0; i != 10000; ++i )
+  {
+    auto  para = source.AddMarkupTag( "p" );
+
+    for ( int j = 0; j != 10; ++j )
+      para->AddBlock( "sed do eiusmod tempor incididunt ut labore et dolore magna aliqua" );
+  }
+
+  source.Serialize( &buffer );
+
+  auto  dumped = mtc::api<const mtc::IByteBuffer>( mtc::CreateByteBuffer( buffer.data(), buffer.size() ).ptr() );
+
+  bench::Measure( "100k paragraphs, Text::FetchFrom", [&]()
+    {
+      auto  output = Text();
+
+      output.FetchFrom( mtc::sourcebuf( buffer ).ptr() );
+
+      return buffer.size();
+    } );
+  bench::Measure( "100k paragraphs, view_as::Dump", [&]()
+    {
+      return view_as::Dump( dumped ), buffer.size();
+    } );
+} );
+
+/*
+  text/dump format
+
+  Serializes and loads the sample documents in the v1 and the columnar v2
+  dump formats; the dump sizes are listed in the measure names.
+*/
+bench::RegisterSuite  bench_dump( "text/dump format", []()
+{
+  auto  corpus = std::vector<mtc::api<Text>>();
+
+  for ( auto& sample: {
+    mtc::CreateByteBuffer( sample_odtzip_buf, sample_odtzip_len ),
+    mtc::CreateByteBuffer( sample_docxDeliriX_buf, sample_docxDeliriX_len ) } )
+  {
+    for ( int i = 0; i != 16; ++i )
+      ParseAny( (corpus.emplace_back( Text::Create() )).ptr(), sample.ptr() );
+  }
+
+  for ( auto version: { ITextView::dump_v1, ITextView::dump_v2 } )
+  {
+    auto  dumped = std::vector<std::string>( corpus.size() );
+    auto  nbytes = size_t(0);
+
+    for ( size_t i = 0; i != corpus.size(); ++i )
+      nbytes += corpus[i]->Serialize( &dumped[i], version )->size();
+
+    bench::Measure( mtc::strprintf( "v%u Serialize, %u bytes", version, unsigned(nbytes) ), [&]()
+      {
+        for ( size_t i = 0; i != corpus.size(); ++i )
+          corpus[i]->Serialize( &dumped[i].erase(), version );
+        return nbytes;
+      } );
+    bench::Measure( mtc::strprintf( "v%u FetchFrom, %u bytes", version, unsigned(nbytes) ), [&]()
+      {
+        auto  output = Text();
+
+        for ( auto& next: dumped )
+          output.FetchFrom( mtc::sourcebuf( next ).ptr() );
+        return nbytes;
+      } );
+  }
+} );
+
+/*
+  text/zdump
+
+  Compresses the sample documents one by one with no dictionary and with
+  the dictionary trained on the same samples, which is the best case for
+  the dictionary; the total dump sizes are listed in the measure names.
+*/
+bench::RegisterSuite  bench_zdump( "text/zdump", []()
+{
+  auto  corpus = std::vector<mtc::api<const ITextView>>();
+  auto  nbytes = size_t(0);
+
+  for ( auto& sample: {
+    mtc::CreateByteBuffer( sample_odtzip_buf, sample_odtzip_len ),
+    mtc::CreateByteBuffer( sample_docxDeliriX_buf, sample_docxDeliriX_len ) } )
+  {
+    auto  output = Text::Create();
+
+    ParseAny( output.ptr(), sample.ptr() );
+    corpus.push_back( output.ptr() );
+    nbytes += output->GetBufLen( ITextView::dump_v2 );
+  }
+
+  for ( auto dictSize: { 0, 0x1000, 0x8000 } )
+  {
+    auto  options = zdump::Options();
+    auto  dumped = std::vector<std::string>( corpus.size() );
+    auto  cbdump = size_t(0);
+
+    if ( dictSize != 0 )
+      zdump::AddDictionary( options.dictionary = zdump::Train( corpus, dictSize ) );
+
+    for ( size_t i = 0; i != corpus.size(); ++i )
+      cbdump += zdump::Serialize( &dumped[i], *corpus[i], options )->size();
+
+    bench::Measure( mtc::strprintf( "dictionary %u, Serialize, %u => %u bytes", dictSize, unsigned(nbytes), unsigned(cbdump) ), [&]()
+      {
+        for ( size_t i = 0; i != corpus.size(); ++i )
+          zdump::Serialize( &dumped[i].erase(), *corpus[i], options );
+        return nbytes;
+      } );
+    bench::Measure( mtc::strprintf( "dictionary %u, FetchFrom", dictSize ), [&]()
+      {
+        auto  output = Text();
+
+        for ( auto& next: dumped )
+          output.FetchFrom( mtc::sourcebuf( next ).ptr() );
+        return nbytes;
+      } );
+  }
+} );
+
+/*
+  text/transcode
+
+  Converts the mostly ASCII and the cyrillic texts with codepages:: and with
+  the transcode:: kernels selected for the CPU.
+*/
+bench::RegisterSuite  bench_transcode( "text/transcode", []()
+{
+  auto  ascii = std::string();
+  auto  cyrillic = std::string();
+
+  while ( ascii.size() < 0x100000 )
+  {
+    ascii += "Lorem ipsum dolor sit amet, consectetur adipiscing elit, sed do eiusmod tempor; ";
+    cyrillic += "Съешь же ещё этих мягких французских булок да выпей чаю. ";
+  }
+
+  for ( auto& sample: { std::make_pair( "ascii", &ascii ), std::make_pair( "cyrillic", &cyrillic ) } )
+  {
+    auto& source = *sample.second;
+    auto  widestr = codepages::mbcstowide( codepages::codepage_utf8, source );
+
+    bench::Measure( mtc::strprintf( "%s, codepages::mbcstowide", sample.first ), [&]()
+      {  return codepages::mbcstowide( codepages::codepage_utf8, source ).size(), source.size();  } );
+    bench::Measure( mtc::strprintf( "%s, transcode::ToWide (%s)", sample.first, transcode::GetKernelsName() ), [&]()
+      {  return transcode::ToWide( codepages::codepage_utf8, source ).size(), source.size();  } );
+    bench::Measure( mtc::strprintf( "%s, codepages::widetombcs", sample.first ), [&]()
+      {  return codepages::widetombcs( codepages::codepage_utf8, widestr ).size(), source.size();  } );
+    bench::Measure( mtc::strprintf( "%s, transcode::ToUtf8 (%s)", sample.first, transcode::GetKernelsName() ), [&]()
+      {  return transcode::ToUtf8( widestr ).size(), source.size();  } );
+  }
+} );
+
+/*
+  text/dump_as
+
+  Dumps a large document as json and tags unbuffered, with every token
+  passed to the output function, and with the default output buffer.
+*/
+bench::RegisterSuite  bench_dump_as( "text/dump_as", []()
+{
+  auto  text = Text();
+  auto  nbytes = size_t(0);
+
+  for ( int i = 0; i != 200; ++i )
+    ParseAny( &text, mtc::CreateByteBuffer( sample_docxDeliriX_buf, sample_docxDeliriX_len ).ptr() );
+
+  for ( auto& next: text.GetBlocks() )
+    nbytes += next.GetCharStr().size();
+
+  for ( auto options: { dump_as::Options{ 0 }, dump_as::Options{}, dump_as::Options{ 0x10000, true } } )
+  {
+    auto  output = std::string();
+    auto  suffix = options.bufferSize == 0 ? "unbuffered" : options.compact ? "buffered, compact" : "buffered";
+
+    bench::Measure( mtc::strprintf( "Json, %s", suffix ), [&]()
+      {
+        text.Serialize( dump_as::Json( dump_as::MakeOutput( &output.erase() ), options ) );
+        return nbytes;
+      } );
+    bench::Measure( mtc::strprintf( "Tags, %s", suffix ), [&]()
+      {
+        text.Serialize( dump_as::Tags( dump_as::MakeOutput( &output.erase() ), codepages::codepage_utf8, options ) );
+        return nbytes;
+      } );
+  }
+} );
+
+/*
+  text/load_as
+
+  Loads the large json and tags dumps by characters and from the contiguous
+  buffer scanned directly; the json buffer is loaded by the structural index
+  built by the blocks on demand, measured apart, too.
+*/
+bench::RegisterSuite  bench_load_as( "text/load_as", []()
+{
+  auto  text = Text();
+  auto  json = std::string();
+  auto  tags = std::string();
+
+  for ( int i = 0; i != 100; ++i )
+    ParseAny( &text, mtc::CreateByteBuffer( sample_docxDeliriX_buf, sample_docxDeliriX_len ).ptr() );
+
+  text.Serialize( dump_as::Json( dump_as::MakeOutput( &json ) ) );
+  text.Serialize( dump_as::Tags( dump_as::MakeOutput( &tags ) ) );
+
+  bench::Measure( "Json, by characters", [&]()
+    {
+      auto  output = Text();
+
+      load_as::Json( &output, load_as::MakeSource( json.c_str() ) );
+      return json.size();
+    } );
+  bench::Measure( "Json, contiguous buffer", [&]()
+    {
+      auto  output = Text();
+
+      load_as::Json( &output, std::string_view( json ) );
+      return json.size();
+    } );
+  bench::Measure( "Json, structural index only", [&]()
+    {
+      const char* chunk[0x400];
+
+      for ( auto index = transcode::JsonIndex( json.data(), json.size() ); index.Fill( chunk, std::size( chunk ) ) != 0; )
+        continue;
+      return json.size();
+    } );
+  bench::Measure( "Tags, by characters", [&]()
+    {
+      auto  output = Text();
+
+      load_as::Tags( &output, load_as::MakeSource( tags.c_str() ) );
+      return tags.size();
+    } );
+  bench::Measure( "Tags, contiguous buffer", [&]()
+    {
+      auto  output = Text();
+
+      load_as::Tags( &output, std::string_view( tags ) );
+      return tags.size();
+    } );
+} );
@@ -0,0 +1,87 @@
+# include "bench.hpp"
+# include "../archive.hpp"
+# include <minizip/unzip.h>
+# include <mtc/wcsstr.h>
+# include <vector>
+
+namespace DeliriX
+{
+  extern zlib_filefunc_def_s zlib_funcs;
+}
+
+using namespace DeliriX;
+
+extern unsigned char  sample_odtzip_buf[];
+extern unsigned       sample_odtzip_len;
+extern unsigned char  sample_docxDeliriX_buf[];
+extern unsigned       sample_docxDeliriX_len;
+
+/*
+  ReadByLoop( source, name )
+
+  The former member extraction: 1 KB reads appended to a growing vector.
+*/
+static  size_t  ReadByLoop( const mtc::api<const mtc::IByteBuffer>& source, const char* name )
+{
+  auto  zipped = unzOpen2( (const char*)source.ptr(), &zlib_funcs );
+  auto  output = std::vector<char>();
+
+  if ( zipped != nullptr && unzLocateFile( zipped, name, 1 ) == UNZ_OK && unzOpenCurrentFile( zipped ) == UNZ_OK )
+  {
+    char  buffer[0x400];
+    long  cbread;
+
+    while ( (cbread = unzReadCurrentFile( zipped, buffer, sizeof(buffer) )) > 0 )
+      output.insert( output.end(), buffer, buffer + cbread );
+
+    unzCloseCurrentFile( zipped );
+  }
+  if ( zipped != nullptr )
+    unzClose( zipped );
+
+  return output.size();
+}
+
+static  size_t  ReadByArchive( const mtc::api<const mtc::IByteBuffer>& source, const char* name )
+{
+  auto  buffer = OpenZip( source )->GetFile( name );
+
+  return buffer != nullptr ? buffer->GetLen() : 0;
+}
+
+static  void  Compare( const std::string& title, const mtc::api<const mtc::IByteBuffer>& source, const char* name )
+{
+  bench::Measure( title + " 1K loop", [&](){  return ReadByLoop( source, name );  } );
+  bench::Measure( title + " GetFile", [&](){  return ReadByArchive( source, name );  } );
+}
+
+static  auto  MakeText( size_t length ) -> std::string
+{
+  static const char*  words[] = { "lorem", "ipsum", "dolor", "sit", "amet", "consectetur", "adipiscing", "elit" };
+  auto                output = std::string();
+
+  for ( size_t n = 0; output.size() < length; ++n )
+    (output += "<w:p><w:r><w:t>") += words[(n * 7 + n / 5) % std::size( words )], output += "</w:t></w:r></w:p>\n";
+
+  return output;
+}
+
+bench::RegisterSuite  bench_zip( "zip/GetFile", []()
+{
+  Compare( "odt content.xml", mtc::CreateByteBuffer( sample_odtzip_buf, sample_odtzip_len ).ptr(), "content.xml" );
+  Compare( "docx document.xml", mtc::CreateByteBuffer( sample_docxDeliriX_buf, sample_docxDeliriX_len ).ptr(), "word/document.xml" );
+
+  for ( auto length: { 0x100000, 0x1000000 } )
+  {
+    auto  xmltxt = MakeText( length );
+
+    for ( auto deflate: { true, false } )
+    {
+      auto  zipped = bench::MakeZip( { { "word/document.xml", xmltxt } }, deflate );
+      auto  source = mtc::CreateByteBuffer( zipped.data(), zipped.size() );
+
+      Compare( mtc::strprintf( "synthetic %u MB %s", unsigned(length >> 20), deflate ? "deflated" : "stored" ),
+        source.ptr(), "word/document.xml" );
+    }
+  }
+} );
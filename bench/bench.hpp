@@ -0,0 +1,56 @@
+# if !defined( __DeliriX_bench_hpp__ )
+# define __DeliriX_bench_hpp__
+# include "../formats.hpp"
+# include <functional>
+# include <string>
+# include <vector>
+
+namespace DeliriX {
+namespace bench {
+
+  struct Result
+  {
+    std::string name;
+    size_t      count = 0;      // iterations done
+    size_t      bytes = 0;      // bytes processed by all the iterations
+    double      timer = 0.0;    // seconds elapsed
+    double      allocs = 0.0;   // operator new calls per iteration
+    size_t      peakRss = 0;    // the process peak resident set size, bytes
+  };
+
+  /*
+    Measure( name, fn )
+
+    Calls fn() until the minimal time is elapsed and reports the throughput,
+    MB/s and calls per second, that are documents per second for the parsers
+    suites, the operator new calls per call and the process peak RSS; fn
+    returns the count of bytes processed by one call.
+
+    The results are printed as the table, or as json lines with --json for
+    the trend tracking.
+  */
+  auto  Measure( const std::string& name, std::function<size_t()> fn ) -> Result;
+
+  struct RegisterSuite
+  {
+    RegisterSuite( const char* name, std::function<void()> );
+  };
+
+  // synthetic inputs
+
+  using ZipFiles = std::vector<std::pair<std::string, std::string>>;
+
+  auto  MakeZip( const ZipFiles&, bool deflate = true ) -> std::string;
+
+  /*
+    MakeDocument( format, length )
+
+    Builds the synthetic document of the format passed with about length
+    bytes of markup: headers, paragraphs of words with inline styles, and
+    tables; odt and docx are the deflated zip archives.
+  */
+  auto  MakeDocument( Format, size_t length ) -> std::string;
+
+}}
+
+# endif   // !__DeliriX_bench_hpp__
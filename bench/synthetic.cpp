@@ -0,0 +1,215 @@
+# include "bench.hpp"
+# include <mtc/wcsstr.h>
+# include <zlib.h>
+# include <stdexcept>
+# include <cstdint>
+# include <iterator>
+
+namespace DeliriX {
+namespace bench {
+
+  template <class T>
+  void  Put( std::string& out, T t )
+  {
+    for ( size_t i = 0; i != sizeof(T); ++i )
+      out += char(t >> (i * 8));
+  }
+
+  auto  Deflate( const std::string& src ) -> std::string
+  {
+    auto      output = std::string( compressBound( src.size() ) + 0x100, '\0' );
+    z_stream  stream = {};
+
+    if ( deflateInit2( &stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY ) != Z_OK )
+      throw std::runtime_error( "deflateInit2() failed" );
+
+    stream.next_in = (Bytef*)src.data();
+    stream.avail_in = uInt(src.size());
+    stream.next_out = (Bytef*)output.data();
+    stream.avail_out = uInt(output.size());
+
+    if ( deflate( &stream, Z_FINISH ) != Z_STREAM_END )
+      throw deflateEnd( &stream ), std::runtime_error( "deflate() failed" );
+
+    output.resize( stream.total_out );
+      deflateEnd( &stream );
+    return output;
+  }
+
+  /*
+    MakeZip( files, deflate )
+
+    Builds the minimal zip archive image with the files passed either stored
+    or deflated.
+  */
+  auto  MakeZip( const ZipFiles& files, bool deflate ) -> std::string
+  {
+    auto  output = std::string();
+    auto  catalog = std::string();
+
+    for ( auto& file: files )
+    {
+      auto  packed = deflate ? Deflate( file.second ) : file.second;
+      auto  crc32v = uint32_t(crc32( 0, (const Bytef*)file.second.data(), uInt(file.second.size()) ));
+      auto  offset = uint32_t(output.size());
+
+      Put( output, uint32_t(0x04034b50) );
+      Put( output, uint16_t(20) );
+      Put( output, uint16_t(0) );
+      Put( output, uint16_t(deflate ? 8 : 0) );
+      Put( output, uint32_t(0) );
+      Put( output, crc32v );
+      Put( output, uint32_t(packed.size()) );
+      Put( output, uint32_t(file.second.size()) );
+      Put( output, uint16_t(file.first.size()) );
+      Put( output, uint16_t(0) );
+        output += file.first;
+        output += packed;
+
+      Put( catalog, uint32_t(0x02014b50) );
+      Put( catalog, uint16_t(20) );
+      Put( catalog, uint16_t(20) );
+      Put( catalog, uint16_t(0) );
+      Put( catalog, uint16_t(deflate ? 8 : 0) );
+      Put( catalog, uint32_t(0) );
+      Put( catalog, crc32v );
+      Put( catalog, uint32_t(packed.size()) );
+      Put( catalog, uint32_t(file.second.size()) );
+      Put( catalog, uint16_t(file.first.size()) );
+      Put( catalog, uint16_t(0) );
+      Put( catalog, uint16_t(0) );
+      Put( catalog, uint16_t(0) );
+      Put( catalog, uint16_t(0) );
+      Put( catalog, uint32_t(0) );
+      Put( catalog, offset );
+        catalog += file.first;
+    }
+
+    auto  dirpos = uint32_t(output.size());
+
+    output += catalog;
+
+    Put( output, uint32_t(0x06054b50) );
+    Put( output, uint16_t(0) );
+    Put( output, uint16_t(0) );
+    Put( output, uint16_t(files.size()) );
+    Put( output, uint16_t(files.size()) );
+    Put( output, uint32_t(catalog.size()) );
+    Put( output, dirpos );
+    Put( output, uint16_t(0) );
+
+    return output;
+  }
+
+  // synthetic documents
+
+  static  auto  MakeWords( size_t n, size_t nwords ) -> std::string
+  {
+    static const char*  words[] = { "lorem", "ipsum", "dolor", "sit", "amet", "съешь", "же", "ещё",
+      "этих", "мягких", "французских", "булок", "consectetur", "adipiscing", "elit" };
+    auto                output = std::string();
+
+    for ( size_t i = 0; i != nwords; ++i )
+      (output += output.empty() ? "" : " ") += words[(n * 7 + i * 5 + i / 3) % std::size( words )];
+
+    return output;
+  }
+
+  struct Markup
+  {
+    const char* head;
+    const char* tail;
+    const char* title;          // %s is the title text
+    const char* para;           // %s are the words before, in and after the style
+    const char* table;          // %s are the cells, or nullptr for no tables
+  };
+
+  static const Markup xmlMarkup =
+  {
+    "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n<document>\n",
+    "</document>\n",
+    "<h1>%s</h1>\n",
+    "<p>%s <b>%s</b> %s</p>\n",
+    "<table><tr><td>%s</td><td>%s</td></tr><tr><td>%s</td><td>%s</td></tr></table>\n"
+  };
+
+  static const Markup fb2Markup =
+  {
+    "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n"
+      "<FictionBook xmlns=\"http://www.gribuser.ru/xml/fictionbook/2.0\"><body><section>\n",
+    "</section></body></FictionBook>\n",
+    "<title><p>%s</p></title>\n",
+    "<p>%s <emphasis>%s</emphasis> %s</p>\n",
+    nullptr
+  };
+
+  static const Markup odtMarkup =
+  {
+    "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+      "<office:document-content xmlns:office=\"urn:oasis:names:tc:opendocument:xmlns:office:1.0\" "
+      "xmlns:text=\"urn:oasis:names:tc:opendocument:xmlns:text:1.0\"><office:body><office:text>\n",
+    "</office:text></office:body></office:document-content>\n",
+    "<text:h text:outline-level=\"1\">%s</text:h>\n",
+    "<text:p>%s <text:span text:style-name=\"T1\">%s</text:span> %s</text:p>\n",
+    "<text:list><text:list-item><text:p>%s</text:p></text:list-item><text:list-item><text:p>%s</text:p>"
+      "</text:list-item><text:list-item><text:p>%s</text:p></text:list-item><text:list-item><text:p>%s</text:p>"
+      "</text:list-item></text:list>\n"
+  };
+
+  static const Markup docxMarkup =
+  {
+    "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\n"
+      "<w:document xmlns:w=\"http://schemas.openxmlformats.org/wordprocessingml/2006/main\"><w:body>\n",
+    "</w:body></w:document>\n",
+    "<w:p><w:pPr><w:pStyle w:val=\"Heading1\"/></w:pPr><w:r><w:t>%s</w:t></w:r></w:p>\n",
+    "<w:p><w:r><w:t xml:space=\"preserve\">%s </w:t></w:r><w:r><w:rPr><w:b/></w:rPr><w:t>%s</w:t></w:r>"
+      "<w:r><w:t xml:space=\"preserve\"> %s</w:t></w:r></w:p>\n",
+    "<w:tbl><w:tr><w:tc><w:p><w:r><w:t>%s</w:t></w:r></w:p></w:tc><w:tc><w:p><w:r><w:t>%s</w:t></w:r></w:p></w:tc></w:tr>"
+      "<w:tr><w:tc><w:p><w:r><w:t>%s</w:t></w:r></w:p></w:tc><w:tc><w:p><w:r><w:t>%s</w:t></w:r></w:p></w:tc></w:tr></w:tbl>\n"
+  };
+
+  static  auto  MakeMarkup( const Markup& markup, size_t length ) -> std::string
+  {
+    auto  output = std::string( markup.head );
+
+    for ( size_t n = 0; output.size() < length; ++n )
+    {
+      if ( n % 50 == 0 )
+        output += mtc::strprintf( markup.title, MakeWords( n, 4 ).c_str() );
+      else if ( n % 20 == 0 && markup.table != nullptr )
+      {
+        output += mtc::strprintf( markup.table, MakeWords( n, 3 ).c_str(), MakeWords( n + 1, 3 ).c_str(),
+          MakeWords( n + 2, 3 ).c_str(), MakeWords( n + 3, 3 ).c_str() );
+      }
+        else
+      {
+        output += mtc::strprintf( markup.para, MakeWords( n, 8 + n % 24 ).c_str(), MakeWords( n + 1, 2 ).c_str(),
+          MakeWords( n + 2, 4 + n % 8 ).c_str() );
+      }
+    }
+    return output += markup.tail;
+  }
+
+  auto  MakeDocument( Format format, size_t length ) -> std::string
+  {
+    switch ( format )
+    {
+      case Format::xml:
+        return MakeMarkup( xmlMarkup, length );
+      case Format::fb2:
+        return MakeMarkup( fb2Markup, length );
+      case Format::odt:
+        return MakeZip( {
+          { "mimetype", "application/vnd.oasis.opendocument.text" },
+          { "content.xml", MakeMarkup( odtMarkup, length ) } } );
+      case Format::docx:
+        return MakeZip( {
+          { "[Content_Types].xml", "<?xml version=\"1.0\" encoding=\"UTF-8\"?><Types><Override PartName=\"/word/document.xml\" "
+            "ContentType=\"application/vnd.openxmlformats-officedocument.wordprocessingml.document.main+xml\"/></Types>" },
+          { "word/document.xml", MakeMarkup( docxMarkup, length ) } } );
+      default:
+        throw std::invalid_argument( "unknown synthetic document format" );
+    }
+  }
+
+}}
@@ -0,0 +1,33 @@
+# if !defined( __DeliriX_filemap_hpp__ )
+# define __DeliriX_filemap_hpp__
+# include <mtc/iBuffer.h>
+
+namespace DeliriX
+{
+
+  /*
+    MapFile( path, access )
+
+    Maps the file into memory read-only and returns it as a byte buffer that
+    may be passed to OpenZip() and Parse*() instead of the file contents read
+    into the heap; the mapping lives while the buffer is referenced.
+
+    The access hint is passed to the kernel paging:
+      sequential  - the file is read once from start to end (xml, fb2);
+      random      - sparse reads, e.g. zip directory and stored members;
+      normal      - no hint.
+
+    Throws std::system_error if the file cannot be opened or mapped.
+  */
+  enum class Access
+  {
+    normal,
+    sequential,
+    random
+  };
+
+  auto  MapFile( const char* path, Access = Access::normal ) -> mtc::api<const mtc::IByteBuffer>;
+
+}
+
+# endif   // !__DeliriX_filemap_hpp__
@@ -1,6 +1,7 @@
 # if !defined( __DeliriX_formats_hpp__ )
 # define __DeliriX_formats_hpp__
 # include "text-API.hpp"
+# include "stats.hpp"
 # include <mtc/iBuffer.h>
 
 namespace DeliriX
@@ -9,10 +10,49 @@ namespace DeliriX
   class Error: public std::runtime_error
     {  using std::runtime_error::runtime_error;  };
 
-  int   ParseXML  ( IText*, const mtc::api<const mtc::IByteBuffer>& );
-  int   ParseODT  ( IText*, const mtc::api<const mtc::IByteBuffer>& );
-  int   ParseDOCX ( IText*, const mtc::api<const mtc::IByteBuffer>& );
-  int   ParseFB2  ( IText*, const mtc::api<const mtc::IByteBuffer>& );
+  /*
+    The ODT, DOCX and FB2 parsers output the text in the source encoding,
+    UTF-8 for the most documents, with no conversion; TextOutput::utf16 asks
+    them to output the widechar paragraphs.
+  */
+  enum class TextOutput: int
+  {
+    source = 0,
+    utf16
+  };
+
+  /*
+    The parsers called with the ParseStats pointer add the document pipeline
+    counters to it, see stats.hpp; nullptr collects nothing.
+  */
+  int   ParseXML  ( IText*, const mtc::api<const mtc::IByteBuffer>&, ParseStats* = nullptr );
+  int   ParseODT  ( IText*, const mtc::api<const mtc::IByteBuffer>&, TextOutput = TextOutput::source, ParseStats* = nullptr );
+  int   ParseDOCX ( IText*, const mtc::api<const mtc::IByteBuffer>&, TextOutput = TextOutput::source, ParseStats* = nullptr );
+  int   ParseFB2  ( IText*, const mtc::api<const mtc::IByteBuffer>&, TextOutput = TextOutput::source, ParseStats* = nullptr );
+
+  /*
+    Format detection by the document content:
+      - zip archives are recognized by the 'mimetype' member (odt) or by the
+        '[Content_Types].xml' main part type (docx);
+      - xml documents are recognized by the root element name (fb2).
+
+    GetFormat() returns 'unknown' for anything else; ParseAny() detects the
+    format, calls the matching parser and returns the format detected, or
+    throws std::invalid_argument for unknown formats. The archive is opened
+    only once for both detection and parsing.
+  */
+  enum class Format: int
+  {
+    unknown = 0,
+    xml,
+    fb2,
+    odt,
+    docx
+  };
+
+  auto  GetFormat( const mtc::api<const mtc::IByteBuffer>& ) -> Format;
+  auto  ParseAny( IText*, const mtc::api<const mtc::IByteBuffer>&, TextOutput = TextOutput::source,
+    ParseStats* = nullptr ) -> Format;
 
 }
 
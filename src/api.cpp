@@ -1,7 +1,18 @@
 # include "../DOM-text.hpp"
+# include "text-index.hpp"
+# include "paragraph.hpp"
+# include "dump-v2.hpp"
+# include "transcode.hpp"
+# include "trace-scope.hpp"
 # include <moonycode/codes.h>
 # include <mtc/wcsstr.h>
+# include <algorithm>
+# include <atomic>
 # include <functional>
+# include <memory>
+# include <mutex>
+# include <unordered_map>
+# include <unordered_set>
 #include <bits/ios_base.h>
 
 using SerializeFn = std::function<bool( const void*, size_t )>;
@@ -17,124 +28,346 @@ FetchFromFn*  FetchFrom( FetchFromFn* s, void* p, size_t l )
 
 namespace DeliriX
 {
-  struct ParagraphCtl
+  /*
+    ViewSpan - the view of a tag found in the document: the blocks covered by
+    the tag and the markup nested into it.
+
+    Markup positions are the indices in the indexed document markup; the tag
+    is at mkSelf, the nested tags are up to mkEnd, and FindNext() searches up
+    to the end of the view the tag was found in.
+  */
+  class ViewSpan final: public ITextView
   {
-    uint32_t  encode;
-    uint32_t  length;
-    int       rcount;
+    mtc::api<const ITextView>         docptr;
+    std::shared_ptr<const TextIndex>  tindex;
+    size_t                            mkSelf;
+    size_t                            mkEnd;
+    size_t                            mkScope;
+    size_t                            blOrg;
+    size_t                            blEnd;
 
-    static  ParagraphCtl* Create( const char* str, uint32_t len, uint32_t enc )
-    {
-      auto  nalloc = (sizeof(ParagraphCtl) * 2 + len) / sizeof(ParagraphCtl);
-      auto  palloc = new ParagraphCtl[nalloc];
+  public:
+    ViewSpan(
+      const mtc::api<const ITextView>&        doc,
+      const std::shared_ptr<const TextIndex>& idx,
+      size_t                                  pos,
+      size_t                                  lim );
+
+    auto    GetBlocks() const -> mtc::span<const Paragraph>       override;
+    auto    GetMarkup() const -> mtc::span<const MarkupTag>       override;
+    auto    GetLength() const -> uint32_t                         override;
+    auto    FindFirst( const char* ) const -> mtc::api<ITextView> override;
+    auto    FindNext() const -> mtc::api<ITextView>               override;
+    auto    GetBlockPos( uint32_t ) const -> BlockPos             override;
+    auto    GetText( uint32_t, uint32_t ) const -> std::vector<TextChunk>  override;
 
-      ((char*)(1 + new ( palloc ) ParagraphCtl{ enc, len, 1 }))[len] = 0;
+    implement_lifetime_control
+  };
+
+  // ParagraphArena implementation
 
-      if ( str != nullptr )
-        mtc::w_strncpy( (char*)(1 + palloc), str, len );
+  auto  ParagraphArena::Chunk::Create( size_t length, size_t offset ) -> Chunk*
+  {
+    stats::Count( &ParseStats::allocs );
 
-      return palloc;
+    return new ( new ParagraphCtl[(length + sizeof(ParagraphCtl) - 1) / sizeof(ParagraphCtl)] )
+      Chunk{ 1, length, offset, nullptr };
+  }
+
+  void  ParagraphArena::Chunk::Release( Chunk* chunk )
+  {
+    if ( chunk->rcount.fetch_sub( 1, std::memory_order_acq_rel ) == 1 )
+    {
+      chunk->~Chunk();
+      delete[] (ParagraphCtl*)chunk;
     }
-    static  ParagraphCtl* Create( const widechar* str, uint32_t len )
+  }
+
+  ParagraphArena::ParagraphArena( size_t chunkSize ): csize( chunkSize )
+  {
+  }
+
+  ParagraphArena::~ParagraphArena()
+  {
+    Reset();
+  }
+
+  void  ParagraphArena::Reset()
+  {
+    if ( chunk != nullptr )
+      Chunk::Release( chunk );
+    chunk = nullptr;
+  }
+
+  auto  ParagraphArena::Allocate( size_t length, Chunk*& pchunk ) -> void*
+  {
+    auto  header = Chunk::HeaderSize();
+    auto  palloc = (char*)nullptr;
+
+  // paragraphs longer than a chunk get their own chunk referenced by the
+  // paragraph only, so the current chunk is kept to be filled further
+    if ( header + length > csize )
     {
-      auto  nalloc = (sizeof(ParagraphCtl) * 2 + (len + 1) * sizeof(widechar) - 1) / sizeof(ParagraphCtl);
-      auto  palloc = new ParagraphCtl[nalloc];
+      pchunk = Chunk::Create( header + length, header + length );
 
-      ((widechar*)(1 + new ( palloc ) ParagraphCtl{ uint32_t(-1), len, 1 }))[len] = 0;
+      return (char*)pchunk + header;
+    }
 
-      if ( str != nullptr )
-        mtc::w_strncpy( (widechar*)(1 + palloc), str, len )[len] = 0;
+    if ( chunk == nullptr || chunk->offset + length > chunk->length )
+    {
+      Reset();
 
-      return palloc;
+      chunk = Chunk::Create( csize, header );
     }
-  };
 
-  class ViewSpan final: public ITextView
+    palloc = (char*)chunk + chunk->offset;
+      chunk->offset += length;
+    chunk->rcount.fetch_add( 1, std::memory_order_relaxed );
+
+    return (pchunk = chunk), palloc;
+  }
+
+  // TagKey implementation
+
+  /*
+    The dictionary is shared by all the threads; every thread caches the
+    interned keys it has got to avoid locking on the tags already seen.
+
+    The side table is kept in segments allocated once and never moved, so
+    the names of the keys alive are read with no lock.
+  */
+  static  const size_t  TagKeyLimit = 0x1000;     // the count of the names interned
+  static  const size_t  TagKeyMaxLen = 0x100;     // the length of the name interned
+  static  const size_t  TagKeyStep = 12;          // the side table segment size, log2
+  static  const size_t  TagKeyCount = 0x1000000;  // the side table size limit
+
+  struct TagKeyDict
   {
-    mtc::span<const Paragraph>  blocks;
-    mtc::span<const MarkupTag>  markup;
-    mtc::api<const ITextView>   parent;
-    uint32_t                    txOffs;
-    uint32_t                    txSize;
+    struct Counted
+    {
+      std::string           name;       // empty if the entry is free
+      std::atomic<uint32_t> rcount;
+    };
+
+    std::mutex                                      mxlock;
+    std::unordered_map<std::string_view, uint32_t>  idsmap;     // the ids of all the names
+    std::unordered_set<std::string>                 tagset;     // the names interned
+    const std::string*                              interned[TagKeyLimit + 1];
+    std::unique_ptr<Counted[]>                      segment[TagKeyCount >> TagKeyStep];
+    std::vector<uint32_t>                           freeids;
+    uint32_t                                        ncounted = 0;
 
   public:
-    ViewSpan(
-      mtc::span<const Paragraph>  blk,
-      mtc::span<const MarkupTag>  fmt,
-      mtc::api<const ITextView>   par,
-      uint32_t                    off );
+    static  auto  Get() -> TagKeyDict&
+    {
+      static TagKeyDict dict;
 
-    auto    GetBlocks() const -> mtc::span<const Paragraph>       override;
-    auto    GetMarkup() const -> mtc::span<const MarkupTag>       override;
-    auto    GetLength() const -> uint32_t                         override;
-    auto    FindFirst( const char* ) const -> mtc::api<ITextView> override;
-    auto    FindNext() const -> mtc::api<ITextView>               override;
+      return dict;
+    }
+    auto  Entry( uint32_t keyid ) -> Counted&
+    {
+      keyid &= ~0x80000000;
 
-    implement_lifetime_control
+      return segment[keyid >> TagKeyStep][keyid & ((1 << TagKeyStep) - 1)];
+    }
+
+  // all the methods below are called under the lock
+    auto  Find( const std::string_view& tag ) -> uint32_t
+    {
+      auto  pfound = idsmap.find( tag );
+
+      if ( pfound == idsmap.end() )
+        return 0;
+      if ( pfound->second & 0x80000000 )
+        Entry( pfound->second ).rcount.fetch_add( 1, std::memory_order_relaxed );
+      return pfound->second;
+    }
+    auto  Insert( const std::string_view& tag ) -> uint32_t
+    {
+      auto  keyid = uint32_t(0);
+
+      if ( tag.size() <= TagKeyMaxLen && tagset.size() < TagKeyLimit )
+      {
+        interned[keyid = uint32_t(tagset.size() + 1)] = &*tagset.emplace( tag ).first;
+
+        return idsmap.emplace( *interned[keyid], keyid ), keyid;
+      }
+
+      if ( !freeids.empty() )
+      {
+        keyid = freeids.back();
+        freeids.pop_back();
+      }
+        else
+      {
+        if ( ncounted == TagKeyCount )
+          throw std::length_error( "TagKey too many markup tag names" );
+        if ( segment[ncounted >> TagKeyStep] == nullptr )
+          segment[ncounted >> TagKeyStep].reset( new Counted[1 << TagKeyStep]() );
+        keyid = 0x80000000 | ncounted++;
+      }
+
+      auto& entry = Entry( keyid );
+
+      entry.name = tag;
+      entry.rcount.store( 1, std::memory_order_relaxed );
+
+      return idsmap.emplace( entry.name, keyid ), keyid;
+    }
+  // the entry may be found again before the lock is got, or even be reused
+    void  Release( uint32_t keyid )
+    {
+      auto& entry = Entry( keyid );
+      auto  pfound = idsmap.find( entry.name );
+
+      if ( entry.rcount.load( std::memory_order_acquire ) == 0 && pfound != idsmap.end() && pfound->second == keyid )
+      {
+        idsmap.erase( pfound );
+        std::string().swap( entry.name );
+        freeids.push_back( keyid );
+      }
+    }
   };
 
+  static  auto  TagKeyCache() -> std::unordered_map<std::string_view, uint32_t>&
+  {
+    thread_local std::unordered_map<std::string_view, uint32_t> tagmap;
+
+    return tagmap;
+  }
+
+  TagKey::TagKey( const std::string_view& tag )
+  {
+    auto& cached = TagKeyCache();
+    auto  pfound = cached.find( tag );
+
+    if ( pfound != cached.end() )
+      keyid = pfound->second;
+        else
+    if ( !tag.empty() )
+    {
+      auto& dict = TagKeyDict::Get();
+      auto  exlock = std::unique_lock<std::mutex>( dict.mxlock );
+
+      if ( (keyid = dict.Find( tag )) == 0 )
+        keyid = dict.Insert( tag );
+
+      if ( (keyid & counted) == 0 )
+        cached.emplace( *dict.interned[keyid], keyid );
+    }
+  }
+
+  auto  TagKey::Find( const std::string_view& tag ) -> TagKey
+  {
+    auto& cached = TagKeyCache();
+    auto  pfound = cached.find( tag );
+    auto  output = TagKey();
+
+    if ( pfound != cached.end() )
+      return output.keyid = pfound->second, output;
+
+    if ( !tag.empty() )
+    {
+      auto& dict = TagKeyDict::Get();
+      auto  exlock = std::unique_lock<std::mutex>( dict.mxlock );
+
+      if ( (output.keyid = dict.Find( tag )) != 0 && (output.keyid & counted) == 0 )
+        cached.emplace( *dict.interned[output.keyid], output.keyid );
+    }
+    return output;
+  }
+
+  auto  TagKey::str() const -> const std::string&
+  {
+    static const std::string  empty;
+
+    if ( keyid == 0 )
+      return empty;
+    if ( keyid & counted )
+      return TagKeyDict::Get().Entry( keyid ).name;
+    return *TagKeyDict::Get().interned[keyid];
+  }
+
+  void  TagKey::Attach( uint32_t keyid )
+  {
+    TagKeyDict::Get().Entry( keyid ).rcount.fetch_add( 1, std::memory_order_relaxed );
+  }
+
+  void  TagKey::Detach( uint32_t keyid )
+  {
+    auto& dict = TagKeyDict::Get();
+
+    if ( dict.Entry( keyid ).rcount.fetch_sub( 1, std::memory_order_acq_rel ) == 1 )
+    {
+      auto  exlock = std::unique_lock<std::mutex>( dict.mxlock );
+
+      dict.Release( keyid );
+    }
+  }
+
   // Paragraph implementation
 
-  Paragraph::Paragraph(): charstr( nullptr )
+  Paragraph::Paragraph(): pctl( nullptr )
   {
   }
 
   Paragraph::~Paragraph()
   {
-    if ( charstr != nullptr && --((ParagraphCtl*)charstr)[-1].rcount == 0 )
-      delete[] (-1 + (ParagraphCtl*)charstr);
+    if ( pctl != nullptr )
+      ParagraphCtl::Release( pctl );
   }
 
-  Paragraph::Paragraph( const Paragraph& p ): charstr( p.charstr )
+  Paragraph::Paragraph( const Paragraph& p ): pctl( p.pctl )
   {
-    if ( charstr != nullptr )
-      ++((ParagraphCtl*)charstr)[-1].rcount;
+    if ( pctl != nullptr )
+      ++pctl->rcount;
   }
 
-  Paragraph::Paragraph( Paragraph&& p ): charstr( p.charstr )
+  Paragraph::Paragraph( Paragraph&& p ): pctl( p.pctl )
   {
-    p.charstr = nullptr;
+    p.pctl = nullptr;
   }
 
   Paragraph& Paragraph::operator = ( const Paragraph& p )
   {
-    if ( charstr != nullptr && --((ParagraphCtl*)charstr)[-1].rcount == 0 )
-      delete[] ((ParagraphCtl*)charstr - 1);
-    if ( (charstr = p.charstr) != nullptr )
-      ++((ParagraphCtl*)charstr)[-1].rcount;
+    if ( p.pctl != nullptr )
+      ++p.pctl->rcount;
+    if ( pctl != nullptr )
+      ParagraphCtl::Release( pctl );
+    pctl = p.pctl;
     return *this;
   }
 
   Paragraph& Paragraph::operator = ( Paragraph&& p )
   {
-    if ( charstr != nullptr && --((ParagraphCtl*)charstr)[-1].rcount == 0 )
-      delete[] ((ParagraphCtl*)charstr - 1);
-    charstr = p.charstr;
-      p.charstr = nullptr;
+    if ( pctl != nullptr )
+      ParagraphCtl::Release( pctl );
+    pctl = p.pctl;
+      p.pctl = nullptr;
     return *this;
   }
 
   uint32_t  Paragraph::GetEncoding() const
   {
-    return charstr != nullptr ? ((ParagraphCtl*)charstr)[-1].encode : 0;
+    return pctl != nullptr ? pctl->encode : 0;
   }
 
   uint32_t  Paragraph::GetTextSize() const
   {
-    return charstr != nullptr ? ((ParagraphCtl*)charstr)[-1].length : 0;
+    return pctl != nullptr ? pctl->length : 0;
   }
 
   auto  Paragraph::GetCharStr() const -> std::string_view
   {
-    if ( charstr != nullptr && GetEncoding() != uint32_t(-1) )
-      return { charstr, GetTextSize() };
+    if ( pctl != nullptr && pctl->encode != uint32_t(-1) )
+      return { pctl->ptext, pctl->length };
     return { nullptr, 0 };
   }
 
   auto  Paragraph::GetWideStr() const -> std::basic_string_view<widechar>
   {
-    if ( widestr != nullptr && GetEncoding() == uint32_t(-1) )
-      return { widestr, GetTextSize() };
+    if ( pctl != nullptr && pctl->encode == uint32_t(-1) )
+      return { (const widechar*)pctl->ptext, pctl->length };
     return { nullptr, 0 };
   }
 
@@ -154,26 +387,31 @@ namespace DeliriX
     auto  len = GetTextSize();
     auto  out = ::Serialize( ::Serialize( &fns, enc + 1 ), len );
 
-    out = enc == (uint32_t)-1 ? ::Serialize( out, widestr, len * sizeof(widechar) )
-      : ::Serialize( out, charstr, len );
+    out = len != 0 ? ::Serialize( out, pctl->ptext, enc == uint32_t(-1) ? len * sizeof(widechar) : len ) : out;
 
     return out != nullptr;
   }
 
-  bool  Paragraph::FetchFrom( std::function<bool( void*, size_t )> fns )
+  bool  Paragraph::FetchFrom( std::function<bool( void*, size_t )> fns, ParagraphArena* arena )
   {
     uint32_t  enc;
     uint32_t  len;
 
-    auto  src = ::FetchFrom( ::FetchFrom( &fns, enc ), len );
-      --enc;
+    if ( ::FetchFrom( ::FetchFrom( &fns, enc ), len ) == nullptr )
+      return false;
+
+    return FetchFrom( enc - 1, len, std::move( fns ), arena );
+  }
+
+  bool  Paragraph::FetchFrom( uint32_t enc, uint32_t len, std::function<bool( void*, size_t )> fns, ParagraphArena* arena )
+  {
+    if ( pctl != nullptr )
+      ParagraphCtl::Release( pctl );
 
     if ( enc == (uint32_t)-1 )
-      src = ::FetchFrom( src, (void*)(widestr = (const widechar*)(1 + ParagraphCtl::Create( nullptr, len ))), len * sizeof(widechar) );
+      return ::FetchFrom( &fns, (void*)(pctl = ParagraphCtl::Create( nullptr, len, arena ))->ptext, len * sizeof(widechar) ) != nullptr;
     else
-      src = ::FetchFrom( src, (void*)(widestr = (const widechar*)(1 + ParagraphCtl::Create( nullptr, len, enc ))), len );
-
-    return src != nullptr;
+      return ::FetchFrom( &fns, (void*)(pctl = ParagraphCtl::Create( nullptr, len, enc, arena ))->ptext, len ) != nullptr;
   }
 
   // IText
@@ -186,7 +424,7 @@ namespace DeliriX
       for ( len = 0; str[len] != 0; ++len )
         (void)NULL;
 
-    para.widestr = (widechar*)(1 + ParagraphCtl::Create( str, len ));
+    para.pctl = ParagraphCtl::Create( str, len, GetArena() );
 
     return AddParagraph( para );
   }
@@ -199,7 +437,7 @@ namespace DeliriX
       for ( len = 0; str[len] != 0; ++len )
         (void)NULL;
 
-    para.charstr = (char*)(1 + ParagraphCtl::Create( str, len, cp ));
+    para.pctl = ParagraphCtl::Create( str, len, cp, GetArena() );
 
     return AddParagraph( para );
   }
@@ -207,202 +445,253 @@ namespace DeliriX
   // ViewSpan implementation
 
   ViewSpan::ViewSpan(
-    mtc::span<const Paragraph>  blk,
-    mtc::span<const MarkupTag>  fmt,
-    mtc::api<const ITextView>   par,
-    uint32_t                    off ):
-      blocks( blk ),
-      markup( fmt ),
-      parent( par ),
-      txOffs( off )
+    const mtc::api<const ITextView>&        doc,
+    const std::shared_ptr<const TextIndex>& idx,
+    size_t                                  pos,
+    size_t                                  lim ):
+      docptr( doc ),
+      tindex( idx ),
+      mkSelf( pos ),
+      mkEnd( idx->GetTagEnd( pos ) ),
+      mkScope( lim )
   {
-    for ( auto& next: blk )
-      txSize += next.GetTextSize();
+    auto& markup = tindex->GetMarkup()[mkSelf];
+
+    blOrg = tindex->GetBlockOrg( markup.uLower );
+    blEnd = std::max( tindex->GetBlockEnd( markup.uUpper ), blOrg );
   }
 
   auto    ViewSpan::GetBlocks() const -> mtc::span<const Paragraph>
   {
-    return blocks;
+    return tindex->GetBlocks().subspan( blOrg, blEnd - blOrg );
   }
 
   auto    ViewSpan::GetMarkup() const -> mtc::span<const MarkupTag>
   {
-    return markup.subspan( 1, markup.size() - 1 );
+    return tindex->GetMarkup().subspan( mkSelf + 1, mkEnd - mkSelf - 1 );
   }
 
   auto    ViewSpan::GetLength() const -> uint32_t
   {
-    return txSize;
+    return tindex->GetOffset( blEnd ) - tindex->GetOffset( blOrg );
   }
 
   auto  ViewSpan::FindFirst( const char* tag ) const -> mtc::api<ITextView>
   {
-    for ( size_t mk_pos = 1; mk_pos < markup.size(); ++mk_pos )
-      if ( markup[mk_pos].tagKey == tag )
-      {
-        size_t  mk_len = 1;
-        size_t  bl_pos;
-        size_t  bl_len;
-        auto    txtOrg = txOffs;
-        auto    txtEnd = uint32_t{};
-        auto    uLower = markup[mk_pos].uLower;
-        auto    uUpper = markup[mk_pos].uUpper;
-
-        // get tag length in markups
-        while ( mk_pos + mk_len < markup.size() && markup[mk_pos + mk_len].uUpper <= uUpper )
-          ++mk_len;
-
-        // get block start
-        for ( bl_pos = 0; bl_pos < blocks.size() && txtOrg < uLower; ++bl_pos )
-          txtOrg += blocks[bl_pos].GetTextSize();
-
-        // get block count
-        for ( bl_len = 0, txtEnd = txtOrg; bl_pos + bl_len < blocks.size() && txtEnd <= uUpper; ++bl_len )
-          txtEnd += blocks[bl_pos + bl_len].GetTextSize();
-
-        // create the subspan
-        return new ViewSpan( blocks.subspan( bl_pos, bl_len ), markup.subspan( mk_pos, mk_len ), this, txOffs );
-      }
-    return nullptr;
+    auto  tagKey = TagKey::Find( tag );
+    auto  mk_pos = size_t{};
+
+    if ( tagKey.empty() || (mk_pos = tindex->FindTag( tagKey, mkSelf + 1, mkEnd )) == mkEnd )
+      return nullptr;
+
+    return new ViewSpan( docptr, tindex, mk_pos, mkEnd );
   }
 
-  auto    ViewSpan::FindNext() const -> mtc::api<ITextView>
+  auto  ViewSpan::FindNext() const -> mtc::api<ITextView>
   {
-    auto  parfmt = parent->GetMarkup();
-    auto& tagKey = markup.front().tagKey;
-    auto  mk_pos = size_t(1);
-    auto  txtOrg = txOffs;
+    auto  mk_pos = tindex->FindTag( tindex->GetMarkup()[mkSelf].tagKey, mkEnd, mkScope );
 
-  // skip until current tag
-    while ( mk_pos < parfmt.size() && parfmt[mk_pos].uLower < markup.front().uUpper )
-      ++mk_pos;
+    if ( mk_pos == mkScope )
+      return nullptr;
 
-  // search next tag
-    while ( mk_pos < parfmt.size() && parfmt[mk_pos].tagKey != tagKey )
-      ++mk_pos;
-
-    if ( mk_pos < parfmt.size() )
-    {
-      auto  parblk = parent->GetBlocks();
-      auto  mk_len = size_t(1);
-      auto  bl_pos = size_t(0);
-      auto  bl_len = size_t(0);
-      auto  txtEnd = uint32_t{};
-
-      while ( mk_pos + mk_len < parfmt.size() && parfmt[mk_pos + mk_len].uUpper <= parfmt[mk_pos].uUpper )
-        ++mk_len;
+    return new ViewSpan( docptr, tindex, mk_pos, mkScope );
+  }
 
-      while ( bl_pos < parblk.size() && txtOrg < parfmt[mk_pos].uLower )
-        txtOrg += parblk[bl_pos++].GetTextSize();
+  auto  ViewSpan::GetBlockPos( uint32_t offset ) const -> BlockPos
+  {
+    auto  blkpos = tindex->GetBlockPos( offset, blOrg, blEnd );
 
-      for ( txtEnd = txtOrg; bl_pos + bl_len < parblk.size() && txtEnd <= parfmt[mk_pos].uUpper; ++bl_len )
-        txtEnd += parblk[bl_pos + bl_len].GetTextSize();
+    return { blkpos.block - blOrg, blkpos.offset };
+  }
 
-      // create the subspan
-      return new ViewSpan( parblk.subspan( bl_pos, bl_len ), markup.subspan( mk_pos, mk_len ), this, txtOrg );
-    }
-    return nullptr;
+  auto  ViewSpan::GetText( uint32_t offset, uint32_t length ) const -> std::vector<TextChunk>
+  {
+    return tindex->GetText( offset, length, blOrg, blEnd );
   }
 
   // ITextView
 
   auto  ITextView::FindFirst( const char* tag ) const -> mtc::api<ITextView>
+  {
+    auto  tindex = GetIndex();
+    auto  mk_lim = tindex->GetMarkup().size();
+    auto  tagKey = TagKey::Find( tag );
+    auto  mk_pos = size_t{};
+
+    if ( tagKey.empty() || (mk_pos = tindex->FindTag( tagKey, 0, mk_lim )) == mk_lim )
+      return nullptr;
+
+    return new ViewSpan( this, tindex, mk_pos, mk_lim );
+  }
+
+  auto  ITextView::FindNext() const -> mtc::api<ITextView>
+  {
+    return nullptr;
+  }
+
+  /*
+    The default GetBlockPos() and GetText() scan the blocks with no index, as
+    the default index would be built on each call; the views caching the
+    index override them with the binary searches.
+  */
+  auto  ITextView::GetBlockPos( uint32_t offset ) const -> BlockPos
   {
     auto  blocks = GetBlocks();
-    auto  markup = GetMarkup();
+    auto  bl_org = uint32_t(0);
+
+    for ( size_t i = 0; i != blocks.size(); ++i )
+    {
+      auto  bl_end = bl_org + blocks[i].GetTextSize();
 
-    for ( size_t mk_pos = 0; mk_pos < markup.size(); ++mk_pos )
-      if ( markup[mk_pos].tagKey == tag )
+      if ( offset < bl_end )
+        return { i, offset - bl_org };
+
+      bl_org = bl_end;
+    }
+    return { blocks.size(), 0 };
+  }
+
+  auto  ITextView::GetText( uint32_t offset, uint32_t length ) const -> std::vector<TextChunk>
+  {
+    auto  output = std::vector<TextChunk>();
+    auto  bl_org = uint32_t(0);
+
+    for ( auto& next: GetBlocks() )
+    {
+      auto  bl_end = bl_org + next.GetTextSize();
+
+      if ( length == 0 )
+        break;
+
+      if ( offset < bl_end )
       {
-        size_t  mk_len = 1;
-        size_t  bl_pos;
-        size_t  bl_len;
-        auto    txtOrg = uint32_t(0);
-        auto    txtEnd = uint32_t{};
-        auto    uLower = markup[mk_pos].uLower;
-        auto    uUpper = markup[mk_pos].uUpper;
-
-      // get tag length in markups
-        while ( mk_pos + mk_len < markup.size() && markup[mk_pos + mk_len].uUpper <= uUpper )
-          ++mk_len;
-
-      // get block start
-        for ( bl_pos = 0; bl_pos < blocks.size() && txtOrg < uLower; ++bl_pos )
-          txtOrg += blocks[bl_pos].GetTextSize();
-
-      // get block count
-        for ( bl_len = 0, txtEnd = txtOrg; bl_pos + bl_len < blocks.size() && txtEnd <= uUpper; ++bl_len )
-          txtEnd += blocks[bl_pos + bl_len].GetTextSize();
-
-      // create the subspan
-        return new ViewSpan( blocks.subspan( bl_pos, bl_len ), markup.subspan( mk_pos, mk_len ), this, txtOrg );
+        auto  cchblk = std::min( bl_end - offset, length );
+
+        output.push_back( { &next, offset - bl_org, cchblk } );
+          offset += cchblk;
+          length -= cchblk;
       }
-    return nullptr;
+      bl_org = bl_end;
+    }
+    return output;
   }
 
-  auto  ITextView::FindNext() const -> mtc::api<ITextView>
+  auto  ITextView::GetIndex() const -> std::shared_ptr<const TextIndex>
   {
-    return nullptr;
+    return std::make_shared<const TextIndex>( GetBlocks(), GetMarkup() );
   }
 
-  auto  ITextView::GetBufLen() const -> size_t
+  auto  ITextView::GetBufLen( unsigned version ) const -> size_t
   {
     auto  blocks = GetBlocks();
     auto  markup = GetMarkup();
-    auto  length = ::GetBufLen( blocks.size() )
-                 + ::GetBufLen( markup.size() ) + ::GetBufLen( GetLength() );
+    auto  length = size_t(0);
+
+    if ( version == dump_v2 )
+      return SerializeV2( [&]( const void*, size_t l ){  return length += l, true;  } ), length;
+    if ( version == dump_z )
+      return GetBufLenZ();
+
+    if ( version != dump_v1 )
+      throw std::invalid_argument( "ITextView::GetBufLen unknown dump version" );
+
+    length = ::GetBufLen( blocks.size() )
+           + ::GetBufLen( markup.size() ) + ::GetBufLen( GetLength() );
 
     for ( auto& str: blocks )
       length += str.GetBufLen();
 
     for ( auto& tag: markup )
-      length += ::GetBufLen( tag.tagKey ) + ::GetBufLen( tag.uLower ) + ::GetBufLen( tag.uUpper );
+      length += ::GetBufLen( tag.tagKey.str() ) + ::GetBufLen( tag.uLower ) + ::GetBufLen( tag.uUpper );
 
     return length;
   }
 
+  /*
+    SerializeV2( fns )
+
+    Writes the columnar dump: the numeric columns are collected in the buffer
+    and passed in one call, the text is passed by blocks as it is stored.
+  */
+  bool  ITextView::SerializeV2( std::function<bool( const void*, size_t )> fns ) const
+  {
+    auto  output = &fns;
+    auto  column = ColumnBuf();
+
+    ::Serialize( ::Serialize( ::Serialize( &column,
+      size_t(0) ),
+      v2signature ),
+      unsigned(dump_v2) );
+
+    dump_v2::PutHead( column, *this );
+
+    if ( (output = ::Serialize( output, column.data(), column.size() )) == nullptr )
+      return false;
+
+    for ( auto& str: GetBlocks() )
+    {
+      auto  bytes = dump_v2::GetBytes( str );
+
+      if ( !bytes.empty() && (output = ::Serialize( output, bytes.data(), bytes.size() )) == nullptr )
+        return false;
+    }
+
+    column.clear();
+
+    dump_v2::PutTail( column, *this );
+
+    return ::Serialize( output, column.data(), column.size() ) != nullptr;
+  }
+
+  /*
+    Serialize( output )
+
+    Replays the document to the output, passing the paragraphs as they are
+    with no text copied; the open tags are kept on the explicit stack, a tag
+    is closed when the next block starts after its uUpper.
+  */
   auto  ITextView::Serialize( IText* output ) const -> IText*
   {
+    struct Level
+    {
+      mtc::api<IText> output;
+      uint32_t        uUpper;
+    };
+
+    auto  traced = trace::Span( "dump" );
     auto  blocks = GetBlocks();
     auto  markup = GetMarkup();
-    auto  lineIt = blocks.begin();
     auto  spanIt = markup.begin();
     auto  offset = uint32_t(0);
-    auto  fPrint = std::function<void( IText*, uint32_t )>();
+    auto  nested = std::vector<Level>();
+
+    nested.reserve( 0x10 );
+    nested.push_back( { output, uint32_t(-1) } );
 
-    fPrint = [&]( IText* to, uint32_t up )
+    for ( auto& next: blocks )
     {
-      while ( lineIt != blocks.end() && offset < up )
+    // close the tags ended before the block
+      while ( nested.size() > 1 && offset > nested.back().uUpper )
+        nested.pop_back();
+
+    // open the tags started at the block
+      for ( ; spanIt != markup.end() && spanIt->uLower <= offset; ++spanIt )
       {
-        // check if print next line to current IText*
-        if ( spanIt == markup.end() || offset < spanIt->uLower )
-        {
-          auto  enc = lineIt->GetEncoding();
-
-          if ( enc == unsigned(-1) )
-            to->AddBlock( lineIt->GetWideStr() );
-          else
-            to->AddBlock( enc, lineIt->GetCharStr() );
-
-          offset += lineIt->GetTextSize();
-
-          if ( ++lineIt == blocks.end() )
-            return;
-          continue;
-        }
-
-        // check if open new span
-        if ( offset >= spanIt->uLower )
-        {
-          auto  new_to = to->AddMarkupTag( spanIt->tagKey );
-          auto  uUpper = spanIt->uUpper;
-            ++spanIt;
-          fPrint( new_to.ptr(), uUpper );
-        }
+        while ( nested.size() > 1 && spanIt->uLower > nested.back().uUpper )
+          nested.pop_back();
+
+        nested.push_back( { nested.back().output->AddMarkupTag( spanIt->tagKey ), spanIt->uUpper } );
       }
-    };
 
-    return fPrint( output, uint32_t(-1) ), output;
+      nested.back().output->AddParagraph( next );
+        offset += next.GetTextSize();
+    }
+
+  // close the tags innermost first
+    while ( !nested.empty() )
+      nested.pop_back();
+
+    return output;
   }
 
   // helpers
@@ -428,9 +717,9 @@ namespace DeliriX
       {
         widechar  wcsstr[0x400];
 
-        if ( coding != codepages::codepage_utf8 && para.GetTextSize() <= std::size( wcsstr ) )
-          return output->AddBlock( wcsstr, codepages::mbcstowide( coding, wcsstr, para.GetCharStr() ) );
-        return output->AddBlock( codepages::mbcstowide( codepages::codepage_utf8, para.GetCharStr() ) );
+        if ( para.GetTextSize() <= std::size( wcsstr ) )
+          return output->AddBlock( wcsstr, transcode::ToWide( coding, wcsstr, std::size( wcsstr ), para.GetCharStr() ) );
+        return output->AddBlock( transcode::ToWide( coding, para.GetCharStr() ) );
       }
       return output->AddParagraph( para );
     }
@@ -456,4 +745,59 @@ namespace DeliriX
     return Serialize( (IText*)&utfOut, source );
   }
 
+  // dump_v2 implementation
+
+  void  dump_v2::PutHead( ColumnBuf& column, const ITextView& text )
+  {
+    auto  blocks = text.GetBlocks();
+
+    column.reserve( column.size() + 0x10 + blocks.size() * 3 );
+
+    ::Serialize( &column, blocks.size() );
+
+    for ( auto& str: blocks )
+      ::Serialize( &column, str.GetEncoding() + 1 );
+    for ( auto& str: blocks )
+      ::Serialize( &column, str.GetTextSize() );
+  }
+
+  // the tag names are listed in the order of first use
+  void  dump_v2::PutTail( ColumnBuf& column, const ITextView& text )
+  {
+    auto  markup = text.GetMarkup();
+    auto  tagmap = std::unordered_map<TagKey, uint32_t, TagKey::Hash>();
+    auto  tagtab = std::vector<TagKey>();
+    auto  tagidx = std::vector<uint32_t>();
+    auto  uLower = uint32_t(0);
+
+    tagidx.reserve( markup.size() );
+
+    for ( auto& tag: markup )
+    {
+      auto  insert = tagmap.try_emplace( tag.tagKey, uint32_t(tagtab.size()) );
+
+      if ( insert.second )
+        tagtab.push_back( tag.tagKey );
+      tagidx.push_back( insert.first->second );
+    }
+
+    column.reserve( column.size() + 0x10 + tagtab.size() * 0x10 + markup.size() * 4 );
+
+    ::Serialize( &column, tagtab.size() );
+
+    for ( auto& key: tagtab )
+      ::Serialize( &column, key.str() );
+
+    ::Serialize( &column, markup.size() );
+
+    for ( auto index: tagidx )
+      ::Serialize( &column, index );
+    for ( auto& tag: markup )
+      ::Serialize( &column, uint32_t(tag.uLower - uLower) ), uLower = tag.uLower;
+    for ( auto& tag: markup )
+      ::Serialize( &column, uint32_t(tag.uUpper - tag.uLower + 1) );
+
+    ::Serialize( &column, text.GetLength() );
+  }
+
 }
@@ -0,0 +1,192 @@
+# include "../batch.hpp"
+# include "trace-scope.hpp"
+# include <algorithm>
+# include <functional>
+# include <stdexcept>
+# include <system_error>
+# include <thread>
+# include <mutex>
+# include <deque>
+
+namespace DeliriX
+{
+
+  /*
+    WorkPool - runs the indexed jobs on a set of worker threads.
+
+    Each worker owns a deque filled with a contiguous range of job indices;
+    it takes jobs from the front of its own deque and, when it is empty,
+    steals a half of the jobs from the back of another worker's deque, so
+    the documents of very different sizes are balanced with no central queue.
+  */
+  class WorkPool
+  {
+    struct Queue
+    {
+      std::mutex          mxlock;
+      std::deque<size_t>  ntasks;
+    };
+
+    std::vector<Queue>          queues;
+    std::function<void(size_t)> runjob;
+
+  public:
+    WorkPool( size_t ncount, unsigned nthreads, std::function<void(size_t)> fn );
+
+    void  Run();
+
+  protected:
+    void  Work( size_t );
+    bool  Pop( size_t, size_t& );
+    bool  Steal( size_t );
+
+  };
+
+  // WorkPool implementation
+
+  WorkPool::WorkPool( size_t ncount, unsigned nthreads, std::function<void(size_t)> fn ):
+    queues( std::max( std::min( size_t(nthreads), ncount ), size_t(1) ) ),
+    runjob( fn )
+  {
+    for ( size_t i = 0; i != ncount; ++i )
+      queues[i * queues.size() / ncount].ntasks.push_back( i );
+  }
+
+  void  WorkPool::Run()
+  {
+    auto  worker = std::vector<std::thread>();
+
+  // the calling thread is the first worker; if the system refuses to start
+  // more threads, the ones started steal the jobs of the queues left with no
+  // worker, so the batch is done on fewer threads
+    worker.reserve( queues.size() - 1 );
+
+    try
+    {
+      for ( size_t i = 1; i < queues.size(); ++i )
+        worker.emplace_back( &WorkPool::Work, this, i );
+    }
+    catch ( const std::system_error& )
+    {
+    }
+
+    Work( 0 );
+
+    for ( auto& next: worker )
+      next.join();
+  }
+
+  void  WorkPool::Work( size_t nqueue )
+  {
+    size_t  ntask;
+
+  // no jobs are added while running, so all the deques being empty means
+  // the work is done
+    for ( ; ; )
+    {
+      if ( Pop( nqueue, ntask ) )
+        runjob( ntask );
+      else if ( !Steal( nqueue ) )
+        break;
+    }
+  }
+
+  bool  WorkPool::Pop( size_t nqueue, size_t& ntask )
+  {
+    auto& queue = queues[nqueue];
+    auto  exlock = std::unique_lock<std::mutex>( queue.mxlock );
+
+    if ( queue.ntasks.empty() )
+      return false;
+
+    ntask = queue.ntasks.front();
+    queue.ntasks.pop_front();
+    return true;
+  }
+
+  bool  WorkPool::Steal( size_t nqueue )
+  {
+    for ( size_t i = 1; i < queues.size(); ++i )
+    {
+      auto& victim = queues[(nqueue + i) % queues.size()];
+      auto  stolen = std::deque<size_t>();
+
+      {
+        auto  exlock = std::unique_lock<std::mutex>( victim.mxlock );
+        auto  ncount = (victim.ntasks.size() + 1) / 2;
+
+        stolen.assign( victim.ntasks.end() - ncount, victim.ntasks.end() );
+        victim.ntasks.erase( victim.ntasks.end() - ncount, victim.ntasks.end() );
+      }
+
+      if ( !stolen.empty() )
+      {
+        auto& queue = queues[nqueue];
+        auto  exlock = std::unique_lock<std::mutex>( queue.mxlock );
+
+        queue.ntasks.insert( queue.ntasks.end(), stolen.begin(), stolen.end() );
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // ParseBatch implementation
+
+  static  void  ParseOne( IText* output, const mtc::api<const mtc::IByteBuffer>& source, BatchResult& result )
+  {
+    auto  traced = trace::Span( "batch document", source != nullptr ? source->GetLen() : 0 );
+
+    try
+    {
+      result.format = ParseAny( output, source );
+    }
+    catch ( const std::exception& xp )
+    {
+      result.error = xp.what();
+    }
+    catch ( ... )
+    {
+      result.error = "unknown exception";
+    }
+  }
+
+  static  auto  GetThreads( unsigned nthreads ) -> unsigned
+  {
+    return nthreads != 0 ? nthreads : std::max( std::thread::hardware_concurrency(), 1U );
+  }
+
+  auto  ParseBatch(
+    const std::vector<mtc::api<const mtc::IByteBuffer>>&  sources,
+    const std::vector<mtc::api<IText>>&                   outputs,
+    unsigned                                              nthreads ) -> std::vector<BatchResult>
+  {
+    auto  results = std::vector<BatchResult>( sources.size() );
+
+    if ( sources.size() != outputs.size() )
+      throw std::invalid_argument( "ParseBatch: sources and outputs count mismatch" );
+
+    WorkPool( sources.size(), GetThreads( nthreads ), [&]( size_t i )
+      {  ParseOne( outputs[i].ptr(), sources[i], results[i] );  } ).Run();
+
+    return results;
+  }
+
+  auto  ParseBatch(
+    const std::vector<mtc::api<const mtc::IByteBuffer>>&  sources,
+    unsigned                                              nthreads ) -> std::vector<BatchResult>
+  {
+    auto  results = std::vector<BatchResult>( sources.size() );
+
+    WorkPool( sources.size(), GetThreads( nthreads ), [&]( size_t i )
+      {
+        auto  output = Text::Create();
+
+        if ( ParseOne( output.ptr(), sources[i], results[i] ), results[i].Succeeded() )
+          results[i].output = output;
+      } ).Run();
+
+    return results;
+  }
+
+}
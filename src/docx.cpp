@@ -1,7 +1,9 @@
 
 # include "../archive.hpp"
 # include "../formats.hpp"
-# include <moonycode/codes.h>
+# include "text-buffer.hpp"
+# include "stats-scope.hpp"
+# include "trace-scope.hpp"
 # include <mtc/wcsstr.h>
 
 namespace DeliriX
@@ -13,11 +15,11 @@ namespace DeliriX
 
     std::atomic_long  refCnt;
 
-    mtc::widestr      string;
+    TextBuffer        string;
 
   public:
-    DOCX( IText* tx ): output( tx ), refCnt( 0 ) {}
-    DOCX( IText* tx, int inplace ): output( tx ), refCnt( inplace ) {}
+    DOCX( IText* tx, TextOutput to ): output( tx ), refCnt( 0 ), string( to ) {}
+    DOCX( IText* tx, TextOutput to, int inplace ): output( tx ), refCnt( inplace ), string( to ) {}
 
     auto  AddMarkupTag( const std::string_view&, const markup_attribute& ) -> mtc::api<IText>  override;
     auto  AddParagraph( const Paragraph& ) -> Paragraph override;
@@ -31,10 +33,10 @@ namespace DeliriX
   {
     mtc::api<IText>   output;
     mtc::charstr      tagStr = "p";
-    mtc::widestr      string;
+    TextBuffer        string;
 
   public:
-    Para( IText* tx ): output( tx ) {}
+    Para( IText* tx, TextOutput to ): output( tx ), string( to ) {}
    ~Para();
 
     auto  AddMarkupTag( const std::string_view&, const markup_attribute& ) -> mtc::api<IText>  override;
@@ -65,10 +67,10 @@ namespace DeliriX
 
     // check renamed tags
     for ( auto& rename : renameTags )
-      if ( tag == rename.first )  return new DOCX( output->AddMarkupTag( rename.second, att ) );
+      if ( tag == rename.first )  return new DOCX( output->AddMarkupTag( rename.second, att ), string.GetOutput() );
 
     if ( tag == "w:p" )
-      return new Para( output );
+      return new Para( output, string.GetOutput() );
 
   // headings
     if ( tag == "text:h" )
@@ -79,7 +81,7 @@ namespace DeliriX
       if ( outLevel != att.end() )
         tagValue += outLevel->second;
 
-      return new DOCX( output->AddMarkupTag( tagValue, {} ) );
+      return new DOCX( output->AddMarkupTag( tagValue, {} ), string.GetOutput() );
     }
 
   // spaces
@@ -93,15 +95,12 @@ namespace DeliriX
       return IText::AddBlock( strPaste ), this;
     }
 
-    return new DOCX( output->AddMarkupTag( tag, att ) );
+    return new DOCX( output->AddMarkupTag( tag, att ), string.GetOutput() );
   }
 
   auto  DOCX::AddParagraph( const Paragraph& para ) -> Paragraph
   {
-    uint32_t  coding = para.GetEncoding();
-
-    if ( coding == uint32_t(-1) ) string += para.GetWideStr();
-      else  string += codepages::mbcstowide( coding, para.GetCharStr() );
+    string.Append( para );
     return {};
   }
 
@@ -116,8 +115,7 @@ namespace DeliriX
 
     if ( rCount == 0 )
     {
-      if ( !string.empty() )
-        output->AddBlock( string );
+      string.PutTo( output.ptr() );
 
       delete this;
     }
@@ -129,7 +127,7 @@ namespace DeliriX
   Para::~Para()
   {
     if ( !string.empty() )
-      output->AddMarkupTag( tagStr )->AddBlock( string );
+      string.PutTo( output->AddMarkupTag( tagStr ).ptr() );
   }
 
   auto  Para::AddMarkupTag( const std::string_view& tag, const markup_attribute& att ) -> mtc::api<IText>
@@ -171,31 +169,42 @@ namespace DeliriX
 
   auto  Para::AddParagraph( const Paragraph& para ) -> Paragraph
   {
-    uint32_t  coding = para.GetEncoding();
-
-    if ( coding == uint32_t(-1) ) string += para.GetWideStr();
-      else  string += codepages::mbcstowide( coding, para.GetCharStr() );
+    string.Append( para );
     return {};
   }
 
   // public call method
 
-  int   ParseDOCX( IText* text, const mtc::api<const mtc::IByteBuffer>& buff )
+  // archive-level entry used by ParseAny() to reuse the opened archive
+
+  int   LoadDOCX( IText* text, IArchive* zarc, TextOutput to )
   {
+    auto  zsrc = zarc->GetFile( "word/document.xml" );
+
+    if ( zsrc != nullptr )
+    {
+      auto  traced = trace::Span( "docx adapter" );
+      auto  xt = DOCX( text, to, 1 );
+
+      ParseXML( &xt, zsrc.ptr() );
+
+      return 0;
+    }
+    throw std::invalid_argument( "archive does not contain 'word/document.xml'" );
+  }
+
+  int   ParseDOCX( IText* text, const mtc::api<const mtc::IByteBuffer>& buff, TextOutput to, ParseStats* pstats )
+  {
+    auto  scope = stats::Scope( pstats, buff.ptr() );
+
     if ( text != nullptr )
     {
       auto  zarc = OpenZip( buff );
-      auto  zsrc = zarc->GetFile( "word/document.xml" );
 
-      if ( zsrc != nullptr )
-      {
-        auto  xt = DOCX( text, 1 );
-
-        ParseXML( &xt, zsrc.ptr() );
+      if ( zarc != nullptr )
+        return LoadDOCX( scope.Output( text ), zarc.ptr(), to );
 
-        return 0;
-      }
-      throw std::invalid_argument( "archive does not contain 'contents.xml'" );
+      throw std::invalid_argument( "source is not a zip archive" );
     }
     throw std::invalid_argument( "undefined output" );
   }
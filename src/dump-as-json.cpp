@@ -1,4 +1,5 @@
-# include "../DOM-dump.hpp"
+# include "dump-writer.hpp"
+# include "transcode.hpp"
 # include <moonycode/codes.h>
 
 // tags implementation
@@ -6,11 +7,8 @@
 namespace DeliriX {
 namespace dump_as {
 
-  using FnSink = std::function<void(const char*, size_t)>;
-
-  class JsonTag final: public IText
+  class JsonTag final: public DumpTag
   {
-    FnSink      fWrite;
     unsigned    uShift;
     size_t      nItems = 0;
     bool        is_Tag;
@@ -18,106 +16,96 @@ namespace dump_as {
     implement_lifetime_control
 
   public:
-    JsonTag( FnSink f, unsigned u, const std::string& t = {} ):
-      fWrite( f ),
+    JsonTag( const std::shared_ptr<Writer>& w, unsigned u, const std::string_view& t = {} ):
+      DumpTag( w ),
       uShift( u ),
       is_Tag( !t.empty() )
     {
       if ( is_Tag )
       {
-        for ( unsigned u = 0; u != uShift; ++u )
-          fWrite( "  ", 2 );
-
-        fWrite( "{ \"", 3 );
+        writer->Indent( uShift );
+        writer->Write( writer->IsCompact() ? "{\"" : "{ \"" );
           Print( t );
-        fWrite( "\": ", 3 );
+        writer->Write( writer->IsCompact() ? "\":" : "\": " );
       }
-      fWrite( "[\n", 1 );
+      writer->Write( "[" );
     }
     ~JsonTag()
     {
       if ( nItems != 0 )
-        fWrite( "\n", 1 );
-
-      for ( unsigned u = 0; u != uShift; ++u )
-        fWrite( "  ", 2 );
+        NewLine();
 
-      fWrite( "]", 1 );
+      writer->Indent( uShift );
+      writer->Write( "]" );
 
       if ( is_Tag )
-        fWrite( " }", 2 );
+        writer->Write( writer->IsCompact() ? "}" : " }" );
     }
     auto  AddMarkupTag( const std::string_view& tag, const markup_attribute& ) -> mtc::api<IText> override
     {
-      if ( nItems++ != 0 )  fWrite( ",\n", 2 );
-        else fWrite( "\n", 1 );
+      if ( nItems++ != 0 )
+        writer->Write( "," );
+      NewLine();
 
-      return new JsonTag( fWrite, uShift + 1, { tag.data(), tag.length() } );
+      return new JsonTag( writer, uShift + 1, tag );
     }
     auto  AddParagraph( const Paragraph& str ) -> Paragraph override
     {
-      auto  utfstr = std::string();
-      auto  asView = str.GetCharStr();
       auto  coding = str.GetEncoding();
+      auto  output = [this]( const std::string_view& s ){  Print( s );  };
 
-      switch ( coding )
-      {
-        case uint32_t(-1):
-          asView = (utfstr = codepages::widetombcs( codepages::codepage_utf8, str.GetWideStr() ));
-        case codepages::codepage_utf8:
-          break;
-        default:
-          asView = (utfstr = codepages::mbcstombcs( codepages::codepage_utf8, coding, asView ));
-          break;
-      }
+      if ( nItems != 0 )
+        writer->Write( "," );
+      NewLine();
 
-      if ( nItems != 0 )  fWrite( ",\n", 2 );
-        else fWrite( "\n", 1 );
+      writer->Indent( uShift + 1 );
+      writer->Write( "\"" );
 
-      for ( unsigned u = 0; u != uShift + 1; ++u )
-        fWrite( "  ", 2 );
+    // escape the text converted by the chunks, with no temporary copy
+      if ( coding == uint32_t(-1) )
+        transcode::ToUtf8Chunks( str.GetWideStr(), output );
+      else
+        transcode::ToUtf8Chunks( coding, str.GetCharStr(), output );
 
-      fWrite( "\"", 1 );
-        Print( asView );
-      fWrite( "\"", 1 );
+      writer->Write( "\"" );
 
       ++nItems;
 
       return {};
     }
   protected:
+    void  NewLine() const
+    {
+      if ( !writer->IsCompact() )
+        writer->Write( "\n" );
+    }
     void  Print( const std::string_view& src ) const
     {
-      static const char escapeChar[] = "\"\\/\b\f\n\r\t";
-
-      for ( auto ptr = src.data(); ptr != src.end(); )
+      for ( auto ptr = src.data(), end = ptr + src.size(); ptr != end; )
       {
-        auto  org = ptr;
-
-        while ( ptr != src.end() && strchr( escapeChar, *ptr ) == nullptr )
-          ++ptr;
+        auto  clean = transcode::FindJsonEscape( ptr, end - ptr );
 
-        if ( ptr != org ) fWrite( org, ptr - org );
+        if ( clean != 0 ) writer->Write( ptr, clean ), ptr += clean;
           else
         switch ( *ptr++ )
         {
-          case '\"':  fWrite( "\\\"", 2 );  break;
-          case '\\':  fWrite( "\\\\", 2 );  break;
-          case '/':   fWrite( "\\/",  2 );  break;
-          case '\b':  fWrite( "\\b", 2 );  break;
-          case '\f':  fWrite( "\\f", 2 );  break;
-          case '\n':  fWrite( "\\n", 2 );  break;
-          case '\r':  fWrite( "\\r", 2 );  break;
-          case '\t':  fWrite( "\\t", 2 );  break;
+          case '\"':  writer->Write( "\\\"", 2 );  break;
+          case '\\':  writer->Write( "\\\\", 2 );  break;
+          case '/':   writer->Write( "\\/",  2 );  break;
+          case '\b':  writer->Write( "\\b", 2 );  break;
+          case '\f':  writer->Write( "\\f", 2 );  break;
+          case '\n':  writer->Write( "\\n", 2 );  break;
+          case '\r':  writer->Write( "\\r", 2 );  break;
+          case '\t':  writer->Write( "\\t", 2 );  break;
           default: throw std::logic_error( "invalid escape sequence" );
         }
       }
     }
   };
 
-  auto  Json( std::function<void( const char*, size_t )> fn ) -> mtc::api<IText>
+  auto  Json( SerializeFn fn, const Options& options ) -> mtc::api<IText>
   {
-    return new JsonTag( fn, 0 );
+    return new JsonTag( std::make_shared<Writer>( fn, options ), 0 );
   }
 
 }}
@@ -1,14 +1,12 @@
-# include "../DOM-dump.hpp"
+# include "dump-writer.hpp"
+# include "transcode.hpp"
 # include <moonycode/codes.h>
 
 namespace DeliriX {
 namespace dump_as {
 
-  using FnSink = std::function<void(const char*, size_t)>;
-
-  class TagsTag final: public IText
+  class TagsTag final: public DumpTag
   {
-    FnSink          fWrite;
     const unsigned  encode = codepages::codepage_utf8;
     unsigned        uShift;
     std::string     tagStr;
@@ -16,94 +14,73 @@ namespace dump_as {
     implement_lifetime_control
 
   public:
-    TagsTag( FnSink f, unsigned c, unsigned u, std::string&& t = {} ):
-      fWrite( f ),
+    TagsTag( const std::shared_ptr<Writer>& w, unsigned c, unsigned u, std::string&& t = {} ):
+      DumpTag( w ),
       encode( c ),
       uShift( u ),
       tagStr( std::move( t ) )
     {
       if ( !tagStr.empty() )
       {
-        for ( unsigned u = 0; u != uShift; ++u )
-          fWrite( "  ", 2 );
-
-        fWrite( "<", 1 );
+        writer->Indent( uShift );
+        writer->Write( "<" );
           Print( tagStr );
-        fWrite( ">\n", 2 );
+        writer->Write( ">\n" );
       }
     }
     ~TagsTag()
     {
       if ( !tagStr.empty() )
       {
-        for ( unsigned u = 0; u != uShift; ++u )
-          fWrite( "  ", 2 );
-
-        fWrite( "</", 2 );
+        writer->Indent( uShift );
+        writer->Write( "</" );
           Print( tagStr );
-        fWrite( ">\n", 2 );
+        writer->Write( ">\n" );
       }
     }
     auto  AddMarkupTag( const std::string_view& tag, const markup_attribute& ) -> mtc::api<IText> override
     {
-      return new TagsTag( fWrite, encode, uShift + 1, { tag.data(), tag.length() } );
+      return new TagsTag( writer, encode, uShift + 1, { tag.data(), tag.length() } );
     }
     auto  AddParagraph( const Paragraph& src ) -> Paragraph override
     {
-      std::string       utfstr;
-      std::string_view  asView;
-      auto              coding = src.GetEncoding();
-
-      switch ( coding )
-      {
-        case uint32_t(-1):
-          asView = (utfstr = codepages::widetombcs( codepages::codepage_utf8, src.GetWideStr() ));
-          break;
-        case codepages::codepage_utf8:
-          asView = src.GetCharStr();
-          break;
-        default:
-          asView = (utfstr = codepages::mbcstombcs( codepages::codepage_utf8, coding, src.GetCharStr() ));
-          break;
-      }
+      auto  coding = src.GetEncoding();
+      auto  output = [this]( const std::string_view& s ){  Print( s );  };
 
       if ( !tagStr.empty() )
-      {
-        for ( unsigned u = 0; u <= uShift; ++u )
-          fWrite( "  ", 2 );
-      }
+        writer->Indent( uShift + 1 );
 
-      Print( asView );
+      if ( coding == uint32_t(-1) )
+        transcode::ToUtf8Chunks( src.GetWideStr(), output );
+      else
+        transcode::ToUtf8Chunks( coding, src.GetCharStr(), output );
 
-      fWrite( "\n", 1 );
+      writer->Write( "\n" );
 
       return {};
     }
   protected:
     void  Print( const std::string_view& src ) const
     {
-      for ( auto ptr = src.begin(); ptr != src.end(); )
+      for ( auto ptr = src.data(), end = ptr + src.size(); ptr != end; )
       {
-        auto org = ptr;
-
-        while ( ptr != src.end() && *ptr != '<' && *ptr != '>' && *ptr != '&' )
-          ++ptr;
+        auto  clean = transcode::FindTagsEscape( ptr, end - ptr );
 
-        if ( ptr != org ) fWrite( org, ptr - org );
+        if ( clean != 0 ) writer->Write( ptr, clean ), ptr += clean;
           else
         switch ( *ptr++ )
         {
-          case '<': fWrite( "&lt;", 4 );  break;
-          case '>': fWrite( "&gt;", 4 );  break;
-          default:  fWrite( "&amp;", 5 );
+          case '<': writer->Write( "&lt;", 4 );  break;
+          case '>': writer->Write( "&gt;", 4 );  break;
+          default:  writer->Write( "&amp;", 5 );
         }
       }
     }
   };
 
-  auto  Tags( std::function<void( const char*, size_t )> fn, unsigned cp ) -> mtc::api<IText>
+  auto  Tags( SerializeFn fn, unsigned cp, const Options& options ) -> mtc::api<IText>
   {
-    return new TagsTag( fn, cp, unsigned(-1) );
+    return new TagsTag( std::make_shared<Writer>( fn, options ), cp, unsigned(-1) );
   }
 
 }}
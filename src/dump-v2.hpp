@@ -0,0 +1,228 @@
+# if !defined( __DeliriX_src_dump_v2_hpp__ )
+# define __DeliriX_src_dump_v2_hpp__
+# include "../text-API.hpp"
+# include <algorithm>
+# include <functional>
+# include <cstring>
+# include <string>
+# include <vector>
+
+struct ColumnBuf: std::vector<char> {};
+
+template <> inline
+ColumnBuf*  Serialize( ColumnBuf* o, const void* p, size_t l )
+{
+  if ( l == 1 ) o->push_back( *(const char*)p );
+    else o->insert( o->end(), (const char*)p, (const char*)p + l );
+  return o;
+}
+
+/*
+  DumpSource - the dump reader source over the memory block; the text may be
+  referenced in place and skipped.
+*/
+struct DumpSource
+{
+  const char* ptr;
+  const char* end;
+
+  auto  Skip( size_t len ) -> DumpSource*
+    {  return size_t(end - ptr) >= len ? (ptr += len, this) : nullptr;  }
+  auto  GetAvail() const -> size_t
+    {  return end - ptr;  }
+};
+
+template <> inline
+DumpSource* FetchFrom( DumpSource* s, void* p, size_t l )
+{
+  if ( s == nullptr || size_t(s->end - s->ptr) < l )
+    return nullptr;
+  memcpy( p, s->ptr, l );
+    s->ptr += l;
+  return s;
+}
+
+/*
+  FetchSource - the dump reader source over any stream; the size is not known,
+  so nothing is limited by the data available but by the data got.
+*/
+struct FetchSource
+{
+  std::function<bool( void*, size_t )>  fetch;
+
+  auto  GetAvail() const -> size_t
+    {  return size_t(-1);  }
+};
+
+template <> inline
+FetchSource* FetchFrom( FetchSource* s, void* p, size_t l )
+{
+  return s != nullptr && s->fetch( p, l ) ? s : nullptr;
+}
+
+namespace DeliriX {
+namespace dump_v2 {
+
+  /*
+    The parts of the v2 dump following the signature: the head with the
+    blocks columns, the text of the blocks and the tail with the tag names
+    table, the markup columns and the text length.
+  */
+  void  PutHead( ColumnBuf&, const ITextView& );
+  void  PutTail( ColumnBuf&, const ITextView& );
+
+  /*
+    The checked readers of the dump parts, shared by the dump view reading
+    the memory block in place and Text reading any source.
+
+    The counts read are checked by the data available if the source size is
+    known; else the vectors and strings grow by the data got, so the corrupt
+    counts fail at the data end with no huge allocations.
+  */
+  const size_t  growStep = 0x1000;
+
+  // the count of the items taking minlen bytes at least
+  template <class S>
+  auto  GetCount( S* s, size_t& count, size_t minlen = 1 ) -> S*
+  {
+    if ( (s = ::FetchFrom( s, count )) == nullptr || count > s->GetAvail() / minlen )
+      return nullptr;
+    return s;
+  }
+
+  template <class S>
+  auto  GetColumn( S* s, std::vector<uint32_t>& column, size_t count ) -> S*
+  {
+    uint32_t  value;
+
+    column.clear();
+    column.reserve( std::min( count, growStep ) );
+
+    while ( column.size() != count )
+    {
+      if ( (s = ::FetchFrom( s, value )) == nullptr )
+        return nullptr;
+      column.push_back( value );
+    }
+    return s;
+  }
+
+  template <class S>
+  auto  GetString( S* s, std::string& str, size_t length ) -> S*
+  {
+    str.clear();
+
+    if ( s == nullptr || length > s->GetAvail() )
+      return nullptr;
+
+    while ( str.size() != length )
+    {
+      auto  offset = str.size();
+      auto  cbread = std::min( length - offset, std::max( offset, growStep ) );
+
+      str.resize( offset + cbread );
+
+      if ( (s = ::FetchFrom( s, (void*)(str.data() + offset), cbread )) == nullptr )
+        return nullptr;
+    }
+    return s;
+  }
+
+  // the v2 head following the version: the encodings and the lengths columns
+  template <class S>
+  auto  GetHead( S* s, std::vector<uint32_t>& columns, size_t& ncount ) -> S*
+  {
+    if ( (s = GetCount( s, ncount, 2 )) == nullptr )
+      return nullptr;
+    return GetColumn( s, columns, ncount * 2 );
+  }
+
+  // the v2 tag names table
+  template <class S>
+  auto  GetTagKeys( S* s, std::vector<TagKey>& tagKeys ) -> S*
+  {
+    auto    tagstr = std::string();
+    size_t  ncount;
+    size_t  taglen;
+
+    if ( (s = GetCount( s, ncount )) == nullptr )
+      return nullptr;
+
+    tagKeys.clear();
+    tagKeys.reserve( std::min( ncount, growStep ) );
+
+    while ( tagKeys.size() != ncount )
+    {
+      if ( (s = ::FetchFrom( s, taglen )) == nullptr || (s = GetString( s, tagstr, taglen )) == nullptr )
+        return nullptr;
+      tagKeys.emplace_back( tagstr );
+    }
+    return s;
+  }
+
+  // the v2 markup columns: the name indices, the uLower deltas and the lengths
+  template <class S>
+  auto  GetMarkup( S* s, const std::vector<TagKey>& tagKeys, std::vector<MarkupTag>& markup ) -> S*
+  {
+    auto    columns = std::vector<uint32_t>();
+    auto    uLower = uint32_t(0);
+    size_t  ncount;
+
+    if ( (s = GetCount( s, ncount, 3 )) == nullptr || (s = GetColumn( s, columns, ncount * 3 )) == nullptr )
+      return nullptr;
+
+    markup.clear();
+    markup.reserve( ncount );
+
+    for ( size_t i = 0; i != ncount; ++i )
+    {
+      if ( columns[i] >= tagKeys.size() )
+        return nullptr;
+
+      uLower += columns[ncount + i];
+
+      markup.push_back( { tagKeys[columns[i]], uLower, uLower + columns[ncount * 2 + i] - 1 } );
+    }
+    return s;
+  }
+
+  // the v1 tag records, each with its full name
+  template <class S>
+  auto  GetTags( S* s, size_t ncount, std::vector<MarkupTag>& markup ) -> S*
+  {
+    auto    tagstr = std::string();
+    size_t  taglen;
+
+    if ( s == nullptr || ncount > s->GetAvail() / 3 )
+      return nullptr;
+
+    markup.clear();
+    markup.reserve( std::min( ncount, growStep ) );
+
+    while ( markup.size() != ncount )
+    {
+      auto  tag = MarkupTag();
+
+      if ( (s = ::FetchFrom( s, taglen )) == nullptr || (s = GetString( s, tagstr, taglen )) == nullptr )
+        return nullptr;
+
+      if ( (s = ::FetchFrom( ::FetchFrom( s, tag.uLower ), tag.uUpper )) == nullptr )
+        return nullptr;
+
+      tag.tagKey = TagKey( tagstr );
+      markup.push_back( std::move( tag ) );
+    }
+    return s;
+  }
+
+  // the block text bytes as stored in the dump
+  inline  auto  GetBytes( const Paragraph& str ) -> std::string_view
+  {
+    if ( str.GetEncoding() != uint32_t(-1) )
+      return str.GetCharStr();
+    return { (const char*)str.GetWideStr().data(), str.GetTextSize() * sizeof(widechar) };
+  }
+
+}}
+
+# endif   // !__DeliriX_src_dump_v2_hpp__
@@ -0,0 +1,77 @@
+# include "dump-writer.hpp"
+# include <algorithm>
+
+namespace DeliriX {
+namespace dump_as {
+
+  // Writer implementation
+
+  Writer::Writer( SerializeFn fn, const Options& op ):
+    output( fn ),
+    options( op )
+  {
+    if ( output == nullptr )
+      throw std::invalid_argument( "undefined output" );
+
+    buffer.reserve( options.bufferSize );
+  }
+
+  Writer::~Writer()
+  {
+  // the output errors may be caught by Flush() only
+    try
+    {
+      Flush();
+    }
+    catch ( ... )
+    {
+    }
+  }
+
+  void  Writer::Indent( unsigned level )
+  {
+    static const char spaces[] = "                                ";
+
+    if ( !options.compact )
+      for ( auto nchars = size_t(level) * 2; nchars != 0; )
+      {
+        auto  ncopy = std::min( nchars, sizeof(spaces) - 1 );
+
+        Write( spaces, ncopy );
+        nchars -= ncopy;
+      }
+  }
+
+  void  Writer::Flush()
+  {
+    if ( !buffer.empty() )
+    {
+      try
+      {
+        output( buffer.data(), buffer.size() );
+      }
+      catch ( ... )
+      {
+        buffer.clear();
+        throw;
+      }
+      buffer.clear();
+    }
+  }
+
+  // Flush() implementation
+
+  void  Flush( mtc::api<IText>& dumper )
+  {
+    auto  dumptag = dynamic_cast<DumpTag*>( dumper.ptr() );
+    auto  writer = std::shared_ptr<Writer>();
+
+    if ( dumptag == nullptr )
+      throw std::invalid_argument( "the object passed is not a dumper" );
+
+    writer = dumptag->writer;
+    dumper = nullptr;
+    writer->Flush();
+  }
+
+}}
@@ -0,0 +1,61 @@
+# if !defined( __DeliriX_src_dump_writer_hpp__ )
+# define __DeliriX_src_dump_writer_hpp__
+# include "../DOM-dump.hpp"
+# include <string_view>
+# include <string>
+# include <memory>
+
+namespace DeliriX {
+namespace dump_as {
+
+  /*
+    Writer - the dumpers output buffer shared by all the tags of one dump;
+    passes the data to the SerializeFn by the chunks of up to bufferSize
+    bytes, and the longer strings directly.
+  */
+  class Writer
+  {
+  public:
+    Writer( SerializeFn, const Options& );
+   ~Writer();
+
+    bool  IsCompact() const {  return options.compact;  }
+
+    void  Write( const char* str, size_t len )
+    {
+      if ( buffer.size() + len > options.bufferSize )
+      {
+        Flush();
+
+        if ( len >= options.bufferSize )
+          return output( str, len );
+      }
+      buffer.append( str, len );
+    }
+    void  Write( const std::string_view& str )
+      {  Write( str.data(), str.size() );  }
+
+  // two spaces per level, nothing in compact mode
+    void  Indent( unsigned );
+    void  Flush();
+
+  protected:
+    SerializeFn output;
+    Options     options;
+    std::string buffer;
+
+  };
+
+  /*
+    DumpTag - the base of the dumpers tags referencing the shared writer.
+  */
+  struct DumpTag: public IText
+  {
+    DumpTag( const std::shared_ptr<Writer>& w ): writer( w ) {}
+
+    std::shared_ptr<Writer> writer;
+  };
+
+}}
+
+# endif   // !__DeliriX_src_dump_writer_hpp__
@@ -1,5 +1,7 @@
 # include "../formats.hpp"
-# include <moonycode/codes.h>
+# include "text-buffer.hpp"
+# include "stats-scope.hpp"
+# include "trace-scope.hpp"
 # include <mtc/wcsstr.h>
 
 namespace DeliriX
@@ -11,11 +13,11 @@ namespace DeliriX
 
     std::atomic_long  refCnt;
 
-    mtc::widestr      string;
+    TextBuffer        string;
 
   public:
-    FB2( IText* tx ): output( tx ), refCnt( 0 ) {}
-    FB2( IText* tx, int inplace ): output( tx ), refCnt( inplace ) {}
+    FB2( IText* tx, TextOutput to ): output( tx ), refCnt( 0 ), string( to ) {}
+    FB2( IText* tx, TextOutput to, int inplace ): output( tx ), refCnt( inplace ), string( to ) {}
 
     auto  AddMarkupTag( const std::string_view&, const markup_attribute& ) -> mtc::api<IText>  override;
     auto  AddParagraph( const Paragraph& ) -> Paragraph override;
@@ -67,22 +69,15 @@ namespace DeliriX
 
     if ( tag == "p" )
     {
-      if ( !string.empty() )
-      {
-        output->AddBlock( string );
-        string.clear();
-      }
+      string.PutTo( output.ptr() );
       return this;
     }
-    return new FB2( output->AddMarkupTag( tag, att ) );
+    return new FB2( output->AddMarkupTag( tag, att ), string.GetOutput() );
   }
 
   auto  FB2::AddParagraph( const Paragraph& para ) -> Paragraph
   {
-    auto  coding = para.GetEncoding();
-
-    if ( coding == uint32_t(-1) ) string += para.GetWideStr();
-      else  string += codepages::mbcstowide( coding, para.GetCharStr() );
+    string.Append( para );
     return {};
   }
 
@@ -97,19 +92,21 @@ namespace DeliriX
 
     if ( rCount == 0 )
     {
-      if ( !string.empty() )
-        output->AddBlock( string );
+      string.PutTo( output.ptr() );
 
       delete this;
     }
     return rCount;
   }
 
-  int   ParseFB2( IText* text, const mtc::api<const mtc::IByteBuffer>& buff )
+  int   ParseFB2( IText* text, const mtc::api<const mtc::IByteBuffer>& buff, TextOutput to, ParseStats* pstats )
   {
+    auto  scope = stats::Scope( pstats, buff.ptr() );
+
     if ( text != nullptr && buff != nullptr )
     {
-      auto  xt = FB2( text, 1 );
+      auto  traced = trace::Span( "fb2 adapter" );
+      auto  xt = FB2( scope.Output( text ), to, 1 );
 
       ParseXML( &xt, buff.ptr() );
 
@@ -0,0 +1,124 @@
+# include "../filemap.hpp"
+# include <system_error>
+# include <stdexcept>
+# include <cerrno>
+# include <cstdio>
+# include <vector>
+
+# if defined( _WIN32 ) || defined( _WIN64 )
+#   define DELIRIX_NO_MMAP
+# else
+#   include <sys/mman.h>
+#   include <sys/stat.h>
+#   include <fcntl.h>
+#   include <unistd.h>
+# endif
+
+namespace DeliriX {
+
+# if !defined( DELIRIX_NO_MMAP )
+
+  class FileMap final: public mtc::IByteBuffer
+  {
+    void*   mapPtr = nullptr;
+    size_t  mapLen = 0;
+
+    implement_lifetime_control
+
+  public:
+    FileMap( const char* path, Access access )
+    {
+      struct stat fstats;
+      int         handle;
+
+      if ( (handle = open( path, O_RDONLY | O_CLOEXEC )) < 0 )
+        throw std::system_error( errno, std::generic_category(), std::string( "MapFile: could not open " ) + path );
+
+      if ( fstat( handle, &fstats ) != 0 )
+      {
+        auto  nerror = errno;
+
+        close( handle );
+        throw std::system_error( nerror, std::generic_category(), std::string( "MapFile: could not stat " ) + path );
+      }
+
+    // zero-length files are not mappable, but valid
+      if ( (mapLen = size_t(fstats.st_size)) != 0 )
+      {
+        if ( (mapPtr = mmap( nullptr, mapLen, PROT_READ, MAP_PRIVATE, handle, 0 )) == MAP_FAILED )
+        {
+          auto  nerror = errno;
+
+          close( handle );
+          throw std::system_error( nerror, std::generic_category(), std::string( "MapFile: could not map " ) + path );
+        }
+
+        switch ( access )
+        {
+          case Access::sequential:
+            madvise( mapPtr, mapLen, MADV_SEQUENTIAL );
+            break;
+          case Access::random:
+            madvise( mapPtr, mapLen, MADV_RANDOM );
+            break;
+          default:
+            break;
+        }
+      }
+
+    // the mapping keeps the file referenced
+      close( handle );
+    }
+   ~FileMap()
+    {
+      if ( mapLen != 0 )
+        munmap( mapPtr, mapLen );
+    }
+
+    const char* GetPtr() const override {  return (const char*)mapPtr;  }
+    size_t      GetLen() const override {  return mapLen;  }
+    int         SetBuf( const void*, size_t ) override  {  return -1;  }
+    int         SetLen( size_t ) override {  return -1;  }
+  };
+
+# else
+
+  // no mmap(): fall back to reading the whole file into the heap
+
+  class FileMap final: public std::vector<char>, public mtc::IByteBuffer
+  {
+    implement_lifetime_control
+
+  public:
+    FileMap( const char* path, Access )
+    {
+      auto  lpfile = fopen( path, "rb" );
+      char  buffer[0x10000];
+      auto  cbread = size_t(0);
+
+      if ( lpfile == nullptr )
+        throw std::system_error( errno, std::generic_category(), std::string( "MapFile: could not open " ) + path );
+
+      while ( (cbread = fread( buffer, 1, sizeof(buffer), lpfile )) != 0 )
+        insert( end(), buffer, buffer + cbread );
+
+      fclose( lpfile );
+    }
+
+    const char* GetPtr() const override {  return data();  }
+    size_t      GetLen() const override {  return size();  }
+    int         SetBuf( const void*, size_t ) override  {  return -1;  }
+    int         SetLen( size_t ) override {  return -1;  }
+  };
+
+# endif   // !DELIRIX_NO_MMAP
+
+  auto  MapFile( const char* path, Access access ) -> mtc::api<const mtc::IByteBuffer>
+  {
+    if ( path == nullptr || *path == '\0' )
+      throw std::invalid_argument( "MapFile: empty file path" );
+
+    return new FileMap( path, access );
+  }
+
+}
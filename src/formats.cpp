@@ -0,0 +1,164 @@
+# include "../archive.hpp"
+# include "../formats.hpp"
+# include "stats-scope.hpp"
+# include "trace-scope.hpp"
+# include <stdexcept>
+# include <cstring>
+
+namespace DeliriX
+{
+
+  int   LoadODT( IText*, IArchive*, TextOutput );
+  int   LoadDOCX( IText*, IArchive*, TextOutput );
+
+  // format detection helpers
+
+  static  bool  HasPrefix( const char* top, const char* end, const char* pfx )
+  {
+    auto  len = strlen( pfx );
+
+    return size_t(end - top) >= len && memcmp( top, pfx, len ) == 0;
+  }
+
+  static  bool  HasString( const mtc::api<const mtc::IByteBuffer>& buf, const char* str )
+  {
+    return buf != nullptr && std::string_view( buf->GetPtr(), buf->GetLen() ).find( str ) != std::string_view::npos;
+  }
+
+  /*
+    GetZipFormat( zarc )
+
+    Checks the odt 'mimetype' member stored uncompressed at the archive start,
+    then the docx content types; the presence of the main document parts is
+    used as a fallback for archives without those markers.
+
+    The 'mimetype' present is decisive: the other OpenDocument archives, the
+    spreadsheets and presentations, have 'content.xml' too, but are not odt.
+  */
+  static  auto  GetZipFormat( IArchive* zarc ) -> Format
+  {
+    if ( zarc->FindEntry( "mimetype" ) != nullptr )
+    {
+      auto  mimetype = zarc->GetFile( "mimetype" );
+
+      return mimetype != nullptr && HasPrefix( mimetype->GetPtr(), mimetype->GetPtr() + mimetype->GetLen(),
+        "application/vnd.oasis.opendocument.text" ) ? Format::odt : Format::unknown;
+    }
+
+    if ( HasString( zarc->GetFile( "[Content_Types].xml" ), "wordprocessingml.document.main+xml" ) )
+      return Format::docx;
+
+    if ( zarc->FindEntry( "word/document.xml" ) != nullptr )
+      return Format::docx;
+
+    if ( zarc->FindEntry( "content.xml" ) != nullptr )
+      return Format::odt;
+
+    return Format::unknown;
+  }
+
+  /*
+    GetXmlFormat( top, end )
+
+    Skips the byte order mark, the declaration, comments, processing
+    instructions and the doctype to get the root element name.
+  */
+  static  auto  GetXmlFormat( const char* top, const char* end ) -> Format
+  {
+    if ( HasPrefix( top, end, "\xef\xbb\xbf" ) )
+      top += 3;
+
+    for ( ; ; )
+    {
+      while ( top != end && (unsigned char)*top <= 0x20 )
+        ++top;
+
+      if ( top == end || *top != '<' )
+        return Format::unknown;
+
+      if ( HasPrefix( top, end, "<?" ) || HasPrefix( top, end, "<!" ) )
+      {
+        auto  close = HasPrefix( top, end, "<!--" ) ? "-->" : ">";
+        auto  found = std::string_view( top, end - top ).find( close );
+
+        if ( found == std::string_view::npos )
+          return Format::unknown;
+
+        top += found + strlen( close );
+      }
+        else
+      {
+        auto  tagtop = ++top;
+        auto  tagend = top;
+
+        while ( tagend != end && (unsigned char)*tagend > 0x20 && *tagend != '>' && *tagend != '/' )
+          ++tagend;
+
+        if ( tagend == tagtop )
+          return Format::unknown;
+
+      // skip namespace prefix if any
+        for ( auto colon = tagtop; colon != tagend; ++colon )
+          if ( *colon == ':' )  tagtop = colon + 1;
+
+        return std::string_view( tagtop, tagend - tagtop ) == "FictionBook" ? Format::fb2 : Format::xml;
+      }
+    }
+  }
+
+  static  auto  GetFormat( const mtc::api<const mtc::IByteBuffer>& buff, mtc::api<IArchive>& zarc ) -> Format
+  {
+    auto  top = buff->GetPtr();
+    auto  end = buff->GetPtr() + buff->GetLen();
+
+    if ( HasPrefix( top, end, "PK\x03\x04" ) || HasPrefix( top, end, "PK\x05\x06" ) )
+      return (zarc = OpenZip( buff )) != nullptr ? GetZipFormat( zarc.ptr() ) : Format::unknown;
+
+    return GetXmlFormat( top, end );
+  }
+
+  // public functions
+
+  auto  GetFormat( const mtc::api<const mtc::IByteBuffer>& buff ) -> Format
+  {
+    mtc::api<IArchive>  zarc;
+
+    if ( buff == nullptr )
+      throw std::invalid_argument( "undefined source" );
+
+    return GetFormat( buff, zarc );
+  }
+
+  auto  ParseAny( IText* text, const mtc::api<const mtc::IByteBuffer>& buff, TextOutput to, ParseStats* pstats ) -> Format
+  {
+    auto                scope = stats::Scope( pstats, buff.ptr() );
+    mtc::api<IArchive>  zarc;
+    Format              type;
+
+    if ( text == nullptr )
+      throw std::invalid_argument( "undefined output" );
+
+    if ( buff == nullptr )
+      throw std::invalid_argument( "undefined source" );
+
+    text = scope.Output( text );
+
+    {
+      auto  traced = trace::Span( "detect format" );
+
+      type = GetFormat( buff, zarc );
+    }
+
+    switch ( type )
+    {
+      case Format::odt:   LoadODT( text, zarc.ptr(), to );  break;
+      case Format::docx:  LoadDOCX( text, zarc.ptr(), to );  break;
+      case Format::fb2:   ParseFB2( text, buff, to );  break;
+      case Format::xml:   ParseXML( text, buff );  break;
+      default:
+        throw std::invalid_argument( "unknown document format" );
+    }
+    return type;
+  }
+
+}
@@ -1,6 +1,8 @@
 # include "../DOM-load.hpp"
+# include "transcode.hpp"
 # include <moonycode/codes.h>
 # include <mtc/json.h>
+# include <cstring>
 
 namespace DeliriX {
 namespace load_as {
@@ -15,74 +17,157 @@ namespace load_as {
       {  return reader();  }
   };
 
-  void  jsonString( mtc::api<IText> doc, mtc::json::parse::reader& src );
-  void  jsonVector( mtc::api<IText> doc, mtc::json::parse::reader& src );
-  void  jsonStruct( mtc::api<IText> doc, mtc::json::parse::reader& src );
-  void  jsonRecord( mtc::api<IText> doc, mtc::json::parse::reader& src );
+  static  char  Unescape( char chr )
+  {
+    switch ( chr )
+    {
+      case 'b':   return '\b';
+      case 'f':   return '\f';
+      case 'n':   return '\n';
+      case 'r':   return '\r';
+      case 't':   return '\t';
+      default:    return chr;
+    }
+  }
 
-  auto  jsonString( mtc::json::parse::reader& src ) -> std::string
+  /*
+    StreamSource - the json source read by characters; the strings are
+    collected to the scratch buffer reused for all the strings.
+  */
+  class StreamSource
   {
-    char  buf[1024];
-    char* ptr = buf;
-    auto  str = std::string();
+    mtc::json::parse::reader  reader;
+    std::string               scratch;
+
+  public:
+    StreamSource( mtc::json::parse::stream& stm ): reader( stm ) {}
 
-    if ( src.nospace() != '\"' )
-      throw ParseError( "'\"' expected" );
+    char  nospace() {  return reader.nospace();  }
+    auto  putback( char chr ) -> StreamSource&  {  return reader.putback( chr ), *this;  }
 
-    for ( auto bslash = false; ; )
+    auto  GetString() -> std::string_view
     {
-      auto  chr = src.getnext();
+      if ( reader.nospace() != '\"' )
+        throw ParseError( "'\"' expected" );
 
-      if ( !bslash && chr == '\\' )
+      for ( scratch.clear(); ; )
       {
-        bslash = true;
-        continue;
+        auto  chr = reader.getnext();
+
+        if ( chr == '\\' )
+          chr = (chr = reader.getnext()) != '\0' ? Unescape( chr ) : chr;
+        else if ( chr == '"' )
+          return scratch;
+
+        if ( chr == '\0' )
+          throw ParseError( "unexpected end of input" );
+
+        scratch += chr;
       }
+    }
+  };
 
-      switch ( chr )
+  /*
+    IndexSource - the json source in the contiguous buffer, up to the first
+    '\0' as the character source is, read by the structural index built by
+    the blocks on demand; the characters are got by the index positions only,
+    and each opening quote is followed by the escaping backslashes and the
+    closing quote, so the strings are cut and unescaped with no scan of the
+    characters. The strings with no escapes are passed as the references to
+    the buffer, the others are unescaped to the scratch buffer.
+  */
+  class IndexSource
+  {
+    const char*           limit;
+    transcode::JsonIndex  index;
+    const char*           chunk[0x400];
+    const char**          ptr = chunk;
+    const char**          end = chunk;
+    std::string           scratch;
+
+  public:
+    IndexSource( const char* src, size_t len ):
+      limit( src + GetLength( src, len ) ),
+      index( src, limit - src ) {}
+
+    char  nospace()
+    {
+      auto  pos = GetNext();
+
+      return pos != nullptr ? *pos : '\0';
+    }
+    auto  putback( char chr ) -> IndexSource&
+    {
+      if ( chr != '\0' )
+        --ptr;
+      return *this;
+    }
+
+    auto  GetString() -> std::string_view
+    {
+      const char* top;
+      const char* lim;
+
+      if ( nospace() != '\"' )
+        throw ParseError( "'\"' expected" );
+
+      top = ptr[-1] + 1;
+
+      if ( (lim = GetNext()) == nullptr )
+        throw ParseError( "unexpected end of input" );
+
+      if ( *lim == '"' )
+        return { top, size_t(lim - top) };
+
+    // the escaping backslashes are indexed up to the closing quote
+      for ( scratch.clear(); *lim != '"'; )
       {
-        case '\0':
+        if ( lim + 1 == limit )
+          throw ParseError( "unexpected end of input" );
+
+        scratch.append( top, lim );
+        scratch += Unescape( lim[1] );
+        top = lim + 2;
+
+        if ( (lim = GetNext()) == nullptr )
           throw ParseError( "unexpected end of input" );
-        case '"':
-          if ( !bslash )
-            return str + std::string( buf, ptr - buf );
-          break;
-        case '/':
-          break;
-        case 'b':
-          chr = bslash ? '\b' : chr;
-          break;
-        case 'f':
-          chr = bslash ? '\f' : chr;
-          break;
-        case 'n':
-          chr = bslash ? '\n' : chr;
-          break;
-        case 'r':
-          chr = bslash ? '\r' : chr;
-          break;
-        case 't':
-          chr = bslash ? '\t' : chr;
-          break;
-        default: break;
       }
-      bslash = false;
+      return scratch.append( top, lim );
+    }
+
+  protected:
+    static  auto  GetLength( const char* src, size_t len ) -> size_t
+    {
+      auto  zero = len != 0 ? (const char*)memchr( src, 0, len ) : nullptr;
 
-      if ( ptr == buf + sizeof(buf) )
+      return zero != nullptr ? zero - src : len;
+    }
+    auto  GetNext() -> const char*
+    {
+      if ( ptr == end )
       {
-        str += std::string( buf, ptr - buf );
-        ptr = buf;
+        auto  count = index.Fill( chunk, std::size( chunk ) );
+
+        if ( count == 0 )
+          return nullptr;
+        end = (ptr = chunk) + count;
       }
-      *ptr++ = chr;
+      return *ptr++;
     }
-  }
+  };
+
+  template <class Source>  void  jsonVector( IText* doc, Source& src );
+  template <class Source>  void  jsonStruct( IText* doc, Source& src );
+  template <class Source>  void  jsonRecord( IText* doc, Source& src );
 
-  void  jsonString( mtc::api<IText> doc, mtc::json::parse::reader& src )
+  template <class Source>
+  void  jsonString( IText* doc, Source& src )
   {
-    doc->AddBlock( jsonString( src ) );
+    doc->AddBlock( src.GetString() );
   }
 
-  void  jsonVector( mtc::api<IText> doc, mtc::json::parse::reader& src )
+  template <class Source>
+  void  jsonVector( IText* doc, Source& src )
   {
     char  chr;
 
@@ -102,7 +187,8 @@ namespace load_as {
     }
   }
 
-  void  jsonStruct( mtc::api<IText> doc, mtc::json::parse::reader& src )
+  template <class Source>
+  void  jsonStruct( IText* doc, Source& src )
   {
     char  chr;
 
@@ -113,11 +199,10 @@ namespace load_as {
     {
       if ( chr == '\"' )
       {
-        auto  key = jsonString( src.putback( chr ) );
-        auto  tag = doc->AddMarkupTag( key );
+        auto  tag = doc->AddMarkupTag( src.putback( chr ).GetString() );
 
         if ( src.nospace() == ':' )
-          jsonRecord( tag, src );
+          jsonRecord( tag.ptr(), src );
         else throw ParseError( "':' expected" );
 
         if ( (chr = src.nospace()) != '}' )
@@ -127,7 +212,8 @@ namespace load_as {
     }
   }
 
-  void  jsonRecord( mtc::api<IText> doc, mtc::json::parse::reader& src )
+  template <class Source>
+  void  jsonRecord( IText* doc, Source& src )
   {
     auto  chr = src.nospace();
 
@@ -140,18 +226,27 @@ namespace load_as {
     }
   }
 
-  void  jsonVector( mtc::api<IText> doc, mtc::json::parse::stream& src )
+  void  Json( mtc::api<IText> doc, std::function<char()> src )
   {
-    auto  reader = mtc::json::parse::reader( src );
+    FnStream      stm( src );
+    StreamSource  source( stm );
 
-    return jsonVector( doc, reader );
+    return jsonVector( doc.ptr(), source );
   }
 
-  void  Json( mtc::api<IText> doc, std::function<char()> src )
+  void  Json( mtc::api<IText> doc, const std::string_view& src )
+  {
+    IndexSource source( src.data(), src.size() );
+
+    return jsonVector( doc.ptr(), source );
+  }
+
+  void  Json( mtc::api<IText> doc, const mtc::api<const mtc::IByteBuffer>& src )
   {
-    FnStream  stm( src );
+    if ( src == nullptr )
+      throw std::invalid_argument( "undefined source" );
 
-    return jsonVector( doc, stm );
+    return Json( doc, std::string_view( src->GetPtr(), src->GetLen() ) );
   }
 
 }}
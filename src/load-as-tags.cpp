@@ -1,6 +1,7 @@
 # include "../DOM-load.hpp"
 # include <mtc/json.h>
 # include <moonycode/codes.h>
+# include <cstring>
 
 namespace DeliriX {
 namespace load_as {
@@ -21,22 +22,88 @@ namespace load_as {
     std::string     key;
   };
 
-  auto  trimString( std::string& str ) -> std::string&
+  /*
+    Tags sources: Collect( first, stop, term ) gets the string starting with
+    the character first up to '\0', '\n' or stop, and sets term to the char
+    the string is terminated with.
+  */
+  class TagsStream
   {
-    auto  pos = str.find_last_not_of( " \t" );
+    mtc::json::parse::reader  reader;
+    std::string               scratch;
+
+  public:
+    TagsStream( mtc::json::parse::stream& stm ): reader( stm ) {}
+
+    char  nospace() {  return reader.nospace();  }
+    void  putback( char chr ) {  reader.putback( chr );  }
+
+    auto  Collect( char chr, char stop, char& term ) -> std::string_view
+    {
+      for ( scratch.clear(); chr != '\0' && chr != '\n' && chr != stop; chr = reader.getnext() )
+        scratch += chr;
+
+      return term = chr, scratch;
+    }
+  };
+
+  class TagsBuffer
+  {
+    const char* ptr;
+    const char* end;
+
+  public:
+    TagsBuffer( const char* src, size_t len ): ptr( src ), end( src + len )
+    {
+      auto  zero = len != 0 ? (const char*)memchr( src, 0, len ) : nullptr;
+
+      if ( zero != nullptr )
+        end = zero;
+    }
+
+    char  nospace()
+    {
+      while ( ptr != end && (unsigned char)*ptr <= 0x20 )
+        ++ptr;
+      return ptr != end ? *ptr++ : '\0';
+    }
+    void  putback( char chr )
+    {
+      if ( chr != '\0' )
+        --ptr;
+    }
+
+  // the string is referenced in the buffer; chr is the last character read
+    auto  Collect( char chr, char stop, char& term ) -> std::string_view
+    {
+      auto  top = ptr - 1;
+
+      if ( chr == '\0' || chr == '\n' || chr == stop )
+        return term = chr, std::string_view();
+
+      while ( ptr != end && *ptr != '\n' && *ptr != stop )
+        ++ptr;
 
-    if ( pos != std::string::npos )
-      str.resize( pos + 1 );
+      term = ptr != end ? *ptr++ : '\0';
+
+      return { top, size_t(ptr - top - (term != '\0' ? 1 : 0)) };
+    }
+  };
+
+  auto  trimString( const std::string_view& str ) -> std::string_view
+  {
+    auto  pos = str.find_last_not_of( " \t" );
 
-    return str;
+    return pos != std::string_view::npos ? str.substr( 0, pos + 1 ) : str;
   }
 
-  void  loadObject( std::vector<Tag>& tagStack, mtc::json::parse::reader& src )
+  template <class Source>
+  void  loadObject( std::vector<Tag>& tagStack, Source& src )
   {
     for ( ; !tagStack.empty(); )
     {
-      auto  str = std::string();
       auto  chr = src.nospace();
+      auto  str = std::string_view();
 
       if ( chr == '\0' )
         break;
@@ -57,14 +124,13 @@ namespace load_as {
         }
 
       // get tag string
-        for ( ; chr != '\0' && chr != '\n' && chr != '>'; chr = src.getnext() )
-          str += chr;
+        str = src.Collect( chr, '>', chr );
 
       // check if tag ended not with '>'
         if ( chr != '>' )
           throw ParseError( "unexpected end of tag" );
 
-        if ( trimString( str ).length() == 0 )
+        if ( (str = trimString( str )).length() == 0 )
           throw ParseError( "empty tag name" );
 
       // if closing, rollback the tag history
@@ -74,19 +140,16 @@ namespace load_as {
             tagStack.pop_back();
 
           if ( tagStack.empty() )
-            throw ParseError( mtc::strprintf( "closing tag '%s' does not match any opening", str.c_str() ) );
+            throw ParseError( mtc::strprintf( "closing tag '%s' does not match any opening", std::string( str ).c_str() ) );
 
           tagStack.pop_back();
         }
           else
-        tagStack.push_back( { tagStack.back().tag->AddMarkupTag( str.c_str() ), str } );
+        tagStack.push_back( { tagStack.back().tag->AddMarkupTag( str ), std::string( str ) } );
       }
         else
       {
-        do str += chr;
-          while ( (chr = src.getnext()) != '\0' && chr != '\n' && chr != '<' );
-
-        tagStack.back().tag->AddBlock( str );
+        tagStack.back().tag->AddBlock( src.Collect( chr, '<', chr ) );
 
         src.putback( chr );
       }
@@ -95,11 +158,27 @@ namespace load_as {
 
   void  Tags( mtc::api<IText> doc, std::function<char()> src )
   {
-    FnStream                  stream( src );
-    mtc::json::parse::reader  reader( stream );
-    std::vector<Tag>          tagSet{ { doc, "" } };
+    FnStream          stream( src );
+    TagsStream        source( stream );
+    std::vector<Tag>  tagSet{ { doc, "" } };
+
+    loadObject( tagSet, source );
+  }
+
+  void  Tags( mtc::api<IText> doc, const std::string_view& src )
+  {
+    TagsBuffer        source( src.data(), src.size() );
+    std::vector<Tag>  tagSet{ { doc, "" } };
+
+    loadObject( tagSet, source );
+  }
+
+  void  Tags( mtc::api<IText> doc, const mtc::api<const mtc::IByteBuffer>& src )
+  {
+    if ( src == nullptr )
+      throw std::invalid_argument( "undefined source" );
 
-    loadObject( tagSet, reader );
+    return Tags( doc, std::string_view( src->GetPtr(), src->GetLen() ) );
   }
 
 }}
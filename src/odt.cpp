@@ -1,7 +1,9 @@
 
 # include "../archive.hpp"
 # include "../formats.hpp"
-# include <moonycode/codes.h>
+# include "text-buffer.hpp"
+# include "stats-scope.hpp"
+# include "trace-scope.hpp"
 # include <mtc/wcsstr.h>
 
 namespace DeliriX
@@ -13,11 +15,11 @@ namespace DeliriX
 
     std::atomic_long  refCnt;
 
-    mtc::widestr      string;
+    TextBuffer        string;
 
   public:
-    ODT( IText* tx ): output( tx ), refCnt( 0 ) {}
-    ODT( IText* tx, int inplace ): output( tx ), refCnt( inplace ) {}
+    ODT( IText* tx, TextOutput to ): output( tx ), refCnt( 0 ), string( to ) {}
+    ODT( IText* tx, TextOutput to, int inplace ): output( tx ), refCnt( inplace ), string( to ) {}
 
     auto  AddMarkupTag( const std::string_view&, const markup_attribute& ) -> mtc::api<IText>  override;
     auto  AddParagraph( const Paragraph& ) -> Paragraph override;
@@ -51,7 +53,7 @@ namespace DeliriX
 
   // check renamed tags
     for ( auto& rename : renameTags )
-      if ( tag == rename.first )  return new ODT( output->AddMarkupTag( rename.second, att ) );
+      if ( tag == rename.first )  return new ODT( output->AddMarkupTag( rename.second, att ), string.GetOutput() );
 
     // headings
     if ( tag == "text:h" )
@@ -62,7 +64,7 @@ namespace DeliriX
       if ( outLevel != att.end() )
         tagValue += outLevel->second;
 
-      return new ODT( output->AddMarkupTag( tagValue, {} ) );
+      return new ODT( output->AddMarkupTag( tagValue, {} ), string.GetOutput() );
     }
 
   // spaces
@@ -76,15 +78,12 @@ namespace DeliriX
       return AddBlock( strPaste ), this;
     }
 
-    return new ODT( output->AddMarkupTag( tag, att ) );
+    return new ODT( output->AddMarkupTag( tag, att ), string.GetOutput() );
   }
 
   auto  ODT::AddParagraph( const Paragraph& para ) -> Paragraph
   {
-    auto  coding = para.GetEncoding();
-
-    if ( coding == uint32_t(-1) ) string += para.GetWideStr();
-      else string += codepages::mbcstowide( coding, para.GetCharStr() );
+    string.Append( para );
     return {};
   }
 
@@ -99,30 +98,43 @@ namespace DeliriX
 
     if ( rCount == 0 )
     {
-      if ( !string.empty() )
-        output->AddBlock( string );
+      string.PutTo( output.ptr() );
 
       delete this;
     }
     return rCount;
   }
 
-  int   ParseODT( IText* text, const mtc::api<const mtc::IByteBuffer>& buff )
+  // archive-level entry used by ParseAny() to reuse the opened archive
+
+  int   LoadODT( IText* text, IArchive* zarc, TextOutput to )
+  {
+    auto  zsrc = zarc->GetFile( "content.xml" );
+
+    if ( zsrc != nullptr )
+    {
+      auto  traced = trace::Span( "odt adapter" );
+      auto  xt = ODT( text, to, 1 );
+
+      ParseXML( &xt, zsrc.ptr() );
+
+      return 0;
+    }
+    throw std::invalid_argument( "archive does not contain 'content.xml'" );
+  }
+
+  int   ParseODT( IText* text, const mtc::api<const mtc::IByteBuffer>& buff, TextOutput to, ParseStats* pstats )
   {
+    auto  scope = stats::Scope( pstats, buff.ptr() );
+
     if ( text != nullptr )
     {
       auto  zarc = OpenZip( buff );
-      auto  zsrc = zarc->GetFile( "content.xml" );
-
-      if ( zsrc != nullptr )
-      {
-        auto  xt = ODT( text, 1 );
 
-        ParseXML( &xt, zsrc.ptr() );
+      if ( zarc != nullptr )
+        return LoadODT( scope.Output( text ), zarc.ptr(), to );
 
-        return 0;
-      }
-      throw std::invalid_argument( "archive does not contain 'contents.xml'" );
+      throw std::invalid_argument( "source is not a zip archive" );
     }
     throw std::invalid_argument( "undefined output" );
   }
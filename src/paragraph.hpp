@@ -0,0 +1,108 @@
+# if !defined( __DeliriX_src_paragraph_hpp__ )
+# define __DeliriX_src_paragraph_hpp__
+# include "../text-API.hpp"
+# include "stats-scope.hpp"
+# include <mtc/wcsstr.h>
+# include <atomic>
+# include <new>
+
+namespace DeliriX
+{
+
+  /*
+    ParagraphArena::Chunk - the header of the memory block shared by several
+    paragraphs: the arena chunk or the headers of external paragraphs.
+
+    The paragraphs of one chunk may be passed to different threads, so the
+    count is atomic, as the separate paragraph headers are independent.
+  */
+  struct ParagraphArena::Chunk
+  {
+    std::atomic<size_t> rcount;     // live paragraphs + the arena itself while current
+    size_t              length;
+    size_t              offset;
+
+  // the external text holder released with the chunk, if any
+    mtc::api<const mtc::Iface>  holder;
+
+    static  auto  Create( size_t length, size_t offset ) -> Chunk*;
+    static  void  Release( Chunk* );
+
+  // the chunk header size rounded to keep the paragraphs aligned
+    static  auto  HeaderSize() -> size_t;
+  };
+
+  /*
+    ParagraphCtl - the refcounted paragraph header; ptext references the text
+    following the header or the external text, pchunk is the chunk holding
+    the header if not allocated alone.
+  */
+  struct ParagraphCtl
+  {
+    uint32_t                encode;
+    uint32_t                length;
+    int                     rcount;
+    ParagraphArena::Chunk*  pchunk;
+    const char*             ptext;
+
+    static  ParagraphCtl* Create( const char* str, uint32_t len, uint32_t enc, ParagraphArena* arena = nullptr )
+    {
+      auto  pchunk = (ParagraphArena::Chunk*)nullptr;
+      auto  palloc = Allocate( (sizeof(ParagraphCtl) * 2 + len) / sizeof(ParagraphCtl), arena, pchunk );
+      auto  pttext = (char*)(1 + palloc);
+
+      new ( palloc ) ParagraphCtl{ enc, len, 1, pchunk, pttext };
+
+      if ( str != nullptr )
+        mtc::w_strncpy( pttext, str, len );
+
+      return pttext[len] = 0, palloc;
+    }
+    static  ParagraphCtl* Create( const widechar* str, uint32_t len, ParagraphArena* arena = nullptr )
+    {
+      auto  pchunk = (ParagraphArena::Chunk*)nullptr;
+      auto  palloc = Allocate( (sizeof(ParagraphCtl) * 2 + (len + 1) * sizeof(widechar) - 1) / sizeof(ParagraphCtl), arena, pchunk );
+      auto  pttext = (widechar*)(1 + palloc);
+
+      new ( palloc ) ParagraphCtl{ uint32_t(-1), len, 1, pchunk, (const char*)pttext };
+
+      if ( str != nullptr )
+        mtc::w_strncpy( pttext, str, len );
+
+      return pttext[len] = 0, palloc;
+    }
+    static  ParagraphCtl* Allocate( size_t nalloc, ParagraphArena* arena, ParagraphArena::Chunk*& pchunk )
+    {
+      if ( arena != nullptr )
+        return (ParagraphCtl*)arena->Allocate( nalloc * sizeof(ParagraphCtl), pchunk );
+
+      stats::Count( &ParseStats::allocs );
+
+      return pchunk = nullptr, new ParagraphCtl[nalloc];
+    }
+    static  void  Release( ParagraphCtl* pctl )
+    {
+      if ( --pctl->rcount == 0 )
+      {
+        if ( pctl->pchunk != nullptr )
+          ParagraphArena::Chunk::Release( pctl->pchunk );
+        else
+          delete[] pctl;
+      }
+    }
+
+  // makes the paragraph own the header
+    static  auto  Attach( Paragraph& para, ParagraphCtl* pctl ) -> Paragraph&
+    {
+      return para.pctl = pctl, para;
+    }
+  };
+
+  inline  auto  ParagraphArena::Chunk::HeaderSize() -> size_t
+  {
+    return (sizeof(Chunk) + sizeof(ParagraphCtl) - 1) / sizeof(ParagraphCtl) * sizeof(ParagraphCtl);
+  }
+
+}
+
+# endif   // !__DeliriX_src_paragraph_hpp__
@@ -0,0 +1,111 @@
+# if !defined( __DeliriX_src_stats_scope_hpp__ )
+# define __DeliriX_src_stats_scope_hpp__
+# include "../stats.hpp"
+# include "../text-API.hpp"
+# include <mtc/iBuffer.h>
+# include <chrono>
+
+namespace DeliriX {
+namespace stats {
+
+  /*
+    The stats collected by the parse running in the thread: the pipeline
+    code is not passed the ParseStats pointer, but reports the events to the
+    thread state, set by the Scope of the public call; with no Scope active
+    each event costs one thread-local pointer check.
+  */
+  struct State
+  {
+    ParseStats*       pstats = nullptr;
+    ParseStats::Stage pstage = ParseStats::other;
+    uint64_t          since = 0;
+  };
+
+  inline  thread_local  State current;
+
+  inline  auto  Now() -> uint64_t
+  {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch() ).count();
+  }
+
+  inline  bool  Enabled()
+  {
+    return current.pstats != nullptr;
+  }
+
+  inline  void  Count( uint64_t ParseStats::* field, uint64_t value = 1 )
+  {
+    if ( current.pstats != nullptr )
+      current.pstats->*field += value;
+  }
+
+  // charges the time to the stage running and returns it; no clock call for the same stage
+  inline  auto  Switch( ParseStats::Stage next ) -> ParseStats::Stage
+  {
+    auto  prev = current.pstage;
+
+    if ( next != prev )
+    {
+      auto  tnow = Now();
+
+      current.pstats->nanoseconds[prev] += tnow - current.since;
+      current.since = tnow;
+      current.pstage = next;
+    }
+    return prev;
+  }
+
+  /*
+    Scope - installs the ParseStats for the public call; nullptr or the stats
+    already installed leave the outer scope as it is, so the nested public
+    calls are charged to the outer one and nothing is counted twice.
+  */
+  class Scope
+  {
+    State           outer;
+    bool            active;
+    mtc::api<IText> output;
+
+  public:
+    Scope( ParseStats* );
+    Scope( ParseStats*, const mtc::IByteBuffer* );
+    Scope( const Scope& ) = delete;
+   ~Scope();
+
+  // the output charging its calls to the stats, or the output itself if the scope is not active
+    auto  Output( IText* ) -> IText*;
+
+  };
+
+  /*
+    Stage - charges the time up to the end of the block to the stage passed,
+    then returns to the outer one.
+  */
+  class Stage
+  {
+    ParseStats::Stage outer = ParseStats::other;
+
+  public:
+    Stage( ParseStats::Stage );
+   ~Stage();
+
+  };
+
+  // Stage implementation
+
+  inline  Stage::Stage( ParseStats::Stage next )
+  {
+    if ( current.pstats != nullptr )
+      outer = Switch( next );
+  }
+
+  inline  Stage::~Stage()
+  {
+    if ( current.pstats != nullptr )
+      Switch( outer );
+  }
+
+}}
+
+# endif   // !__DeliriX_src_stats_scope_hpp__
@@ -0,0 +1,122 @@
+# include "stats-scope.hpp"
+
+namespace DeliriX {
+
+  // ParseStats implementation
+
+  auto  ParseStats::GetTime() const -> uint64_t
+  {
+    auto  ntotal = uint64_t(0);
+
+    for ( auto ntime: nanoseconds )
+      ntotal += ntime;
+
+    return ntotal;
+  }
+
+  auto  ParseStats::operator += ( const ParseStats& r ) -> ParseStats&
+  {
+    for ( unsigned i = 0; i != stage_count; ++i )
+      nanoseconds[i] += r.nanoseconds[i];
+
+    bytesIn += r.bytesIn;
+    bytesUnpacked += r.bytesUnpacked;
+    bytesOut += r.bytesOut;
+    elements += r.elements;
+    tags += r.tags;
+    blocks += r.blocks;
+    allocs += r.allocs;
+    conversions += r.conversions;
+    return *this;
+  }
+
+  auto  ParseStats::GetStageName( Stage stage ) -> const char*
+  {
+    switch ( stage )
+    {
+      case other:     return "other";
+      case unzip:     return "unzip";
+      case xml:       return "xml";
+      case adapter:   return "adapter";
+      case convert:   return "convert";
+      case output:    return "output";
+      default:        return "";
+    }
+  }
+
+namespace stats {
+
+  /*
+    Output - the output wrapper charging the calls to the output stage and
+    counting the tags and blocks added; the paragraphs are allocated in the
+    output arena, if any, as they are with no wrapper.
+  */
+  class Output final: public IText
+  {
+    implement_lifetime_control
+
+  public:
+    Output( mtc::api<IText> tx ): output( tx ) {}
+
+    auto  AddMarkupTag( const std::string_view& tag, const markup_attribute& att ) -> mtc::api<IText> override
+    {
+      auto  charge = Stage( ParseStats::output );
+      auto  nested = output->AddMarkupTag( tag, att );
+
+      if ( nested == nullptr )
+        return nullptr;
+
+      return Count( &ParseStats::tags ), new Output( nested );
+    }
+    auto  AddParagraph( const Paragraph& para ) -> Paragraph override
+    {
+      auto  charge = Stage( ParseStats::output );
+
+      Count( &ParseStats::blocks );
+      Count( &ParseStats::bytesOut, para.GetTextSize() * (para.GetEncoding() == uint32_t(-1) ? sizeof(widechar) : 1) );
+
+      return output->AddParagraph( para );
+    }
+
+  protected:
+    auto  GetArena() -> ParagraphArena* override
+      {  return GetArenaOf( output.ptr() );  }
+
+  protected:
+    mtc::api<IText> output;
+
+  };
+
+  // Scope implementation
+
+  Scope::Scope( ParseStats* stats ):
+    outer( current ),
+    active( stats != nullptr && stats != current.pstats )
+  {
+    if ( active )
+      current = { stats, ParseStats::other, Now() };
+  }
+
+  Scope::Scope( ParseStats* stats, const mtc::IByteBuffer* source ): Scope( stats )
+  {
+    if ( active && source != nullptr )
+      stats->bytesIn += source->GetLen();
+  }
+
+  Scope::~Scope()
+  {
+    if ( active )
+    {
+      current.pstats->nanoseconds[current.pstage] += Now() - current.since;
+      current = outer;
+    }
+  }
+
+  auto  Scope::Output( IText* text ) -> IText*
+  {
+    if ( active && text != nullptr )
+      return (output = new stats::Output( text )).ptr();
+    return text;
+  }
+
+}}
@@ -0,0 +1,125 @@
+# if !defined( __DeliriX_src_text_buffer_hpp__ )
+# define __DeliriX_src_text_buffer_hpp__
+# include "../text-API.hpp"
+# include "transcode.hpp"
+# include "stats-scope.hpp"
+# include <moonycode/codes.h>
+# include <mtc/wcsstr.h>
+
+namespace DeliriX
+{
+
+  /*
+    TextBuffer - the paragraph text collected by the format adapters.
+
+    The byte strings in one codepage are appended as they are and put to the
+    output as one block in this codepage, so the UTF-8 documents are output
+    with no conversion; codepage 0 is taken as UTF-8, as the text loader does.
+    The strings in different codepages are collected as UTF-8. The text is
+    widened to UTF-16 if the widechar string is added or the UTF-16 output is
+    requested.
+  */
+  class TextBuffer
+  {
+  public:
+    TextBuffer( TextOutput out = TextOutput::source ): widen( out == TextOutput::utf16 ) {}
+
+    bool  empty() const {  return charstr.empty() && widestr.empty();  }
+    auto  GetOutput() const -> TextOutput {  return widen ? TextOutput::utf16 : TextOutput::source;  }
+
+    void  Append( const Paragraph& );
+    void  Append( uint32_t codepage, const std::string_view& );
+
+  // puts the text collected to the output as one block and clears the buffer
+    void  PutTo( IText* );
+
+  protected:
+    void  Widen();
+
+  protected:
+    uint32_t      encode = uint32_t(-1);
+    std::string   charstr;
+    mtc::widestr  widestr;
+    bool          widen;
+
+  };
+
+  // TextBuffer implementation
+
+  inline  void  TextBuffer::Append( const Paragraph& para )
+  {
+    auto  coding = para.GetEncoding();
+
+    if ( coding != uint32_t(-1) )
+      return Append( coding, para.GetCharStr() );
+
+    Widen();
+    widestr += para.GetWideStr();
+  }
+
+  inline  void  TextBuffer::Append( uint32_t codepage, const std::string_view& str )
+  {
+    if ( codepage == 0 )
+      codepage = codepages::codepage_utf8;
+
+    if ( widen || !widestr.empty() )
+    {
+      auto  charge = stats::Stage( ParseStats::convert );
+
+      Widen();
+      stats::Count( &ParseStats::conversions );
+      return transcode::AppendWide( widestr, codepage, str );
+    }
+
+    if ( charstr.empty() )
+      encode = codepage;
+
+    if ( codepage == encode )
+      return (void)charstr.append( str );
+
+  // mixed codepages are collected as UTF-8
+    auto  charge = stats::Stage( ParseStats::convert );
+
+    if ( encode != codepages::codepage_utf8 )
+    {
+      stats::Count( &ParseStats::conversions );
+      charstr = transcode::ToUtf8( encode, charstr );
+    }
+
+    if ( codepage != codepages::codepage_utf8 )
+    {
+      stats::Count( &ParseStats::conversions );
+      transcode::AppendUtf8( charstr, codepage, str );
+    }
+      else
+    charstr.append( str );
+
+    encode = codepages::codepage_utf8;
+  }
+
+  inline  void  TextBuffer::PutTo( IText* output )
+  {
+    if ( !widestr.empty() )
+      output->AddBlock( widestr );
+    else if ( !charstr.empty() )
+      output->AddBlock( encode, charstr );
+
+    charstr.clear();
+    widestr.clear();
+  }
+
+  inline  void  TextBuffer::Widen()
+  {
+    if ( !charstr.empty() )
+    {
+      auto  charge = stats::Stage( ParseStats::convert );
+
+      stats::Count( &ParseStats::conversions );
+      transcode::AppendWide( widestr, encode, charstr );
+      charstr.clear();
+    }
+  }
+
+}
+
+# endif   // !__DeliriX_src_text_buffer_hpp__
@@ -0,0 +1,156 @@
+# if !defined( __DeliriX_src_text_index_hpp__ )
+# define __DeliriX_src_text_index_hpp__
+# include "../text-API.hpp"
+# include <unordered_map>
+# include <algorithm>
+# include <vector>
+
+namespace DeliriX
+{
+
+  /*
+    TextIndex - the structural index of a document view.
+
+    Keeps the sorted markup positions for each tag key and the block start
+    offsets, so the tags are enumerated and mapped to the block ranges with
+    binary searches instead of markup and block scans.
+
+    Markup is expected to be ordered by uLower with the nested tags following
+    the enclosing one, as Text creates it.
+  */
+  class TextIndex
+  {
+    mtc::span<const Paragraph>  blocks;
+    mtc::span<const MarkupTag>  markup;
+    mtc::span<const uint32_t>   blkOff;     // block start offsets
+    uint32_t                    txSize = 0;
+
+  // tag keys are mostly interned, so mostly hashed by the key string address
+    std::unordered_map<TagKey, std::vector<uint32_t>, TagKey::Hash>  tagPos;
+    std::vector<uint32_t>                                            ownOff;
+
+  public:
+    TextIndex(
+      mtc::span<const Paragraph>  blk,
+      mtc::span<const MarkupTag>  fmt,
+      mtc::span<const uint32_t>   off = {} ):
+        blocks( blk ),
+        markup( fmt ),
+        blkOff( off )
+    {
+    // the documents keeping the offsets pass them, else get them here
+      if ( blkOff.size() != blocks.size() )
+      {
+        ownOff.reserve( blocks.size() );
+
+        for ( auto& next: blocks )
+          ownOff.push_back( txSize ), txSize += next.GetTextSize();
+
+        blkOff = ownOff;
+      }
+        else
+      if ( !blocks.empty() )
+        txSize = blkOff.back() + blocks.back().GetTextSize();
+
+      for ( size_t i = 0; i != markup.size(); ++i )
+        tagPos[markup[i].tagKey].push_back( uint32_t(i) );
+    }
+
+    auto  GetBlocks() const -> mtc::span<const Paragraph> {  return blocks;  }
+    auto  GetMarkup() const -> mtc::span<const MarkupTag> {  return markup;  }
+
+  // first markup position in [from, upto) with the key, or upto
+    auto  FindTag( const TagKey& key, size_t from, size_t upto ) const -> size_t
+    {
+      auto  pfound = tagPos.find( key );
+
+      if ( pfound != tagPos.end() )
+      {
+        auto  ptrpos = std::lower_bound( pfound->second.begin(), pfound->second.end(), from );
+
+        if ( ptrpos != pfound->second.end() && *ptrpos < upto )
+          return *ptrpos;
+      }
+      return upto;
+    }
+
+  // the position after the tag and all the tags nested into it
+    auto  GetTagEnd( size_t mk_pos ) const -> size_t
+    {
+      auto  uUpper = markup[mk_pos].uUpper;
+
+      return std::upper_bound( markup.begin() + mk_pos + 1, markup.end(), uUpper,
+        []( uint32_t pos, const MarkupTag& tag ){  return pos < tag.uLower;  } ) - markup.begin();
+    }
+
+  // the first block starting at or after the offset
+    auto  GetBlockOrg( uint32_t offset ) const -> size_t
+    {
+      return std::lower_bound( blkOff.begin(), blkOff.end(), offset ) - blkOff.begin();
+    }
+
+  // the first block starting after the offset
+    auto  GetBlockEnd( uint32_t offset ) const -> size_t
+    {
+      return std::upper_bound( blkOff.begin(), blkOff.end(), offset ) - blkOff.begin();
+    }
+
+  // the block start offset; the text length for the end block
+    auto  GetOffset( size_t bl_pos ) const -> uint32_t
+    {
+      return bl_pos < blkOff.size() ? blkOff[bl_pos] : txSize;
+    }
+
+  /*
+    GetBlockPos( offset, bl_org, bl_end )
+
+    Returns the block containing the character offset and the offset in this
+    block, looking in [bl_org, bl_end) blocks only; offsets out of the range
+    get the nearest range limit.
+  */
+    auto  GetBlockPos( uint32_t offset, size_t bl_org, size_t bl_end ) const -> ITextView::BlockPos
+    {
+      auto  bl_pos = GetBlockEnd( offset );
+
+      if ( bl_pos <= bl_org || bl_org == bl_end )
+        return { bl_org, 0 };
+
+      if ( bl_pos > bl_end || offset >= GetOffset( bl_end ) )
+        return { bl_end, 0 };
+
+      return { bl_pos - 1, offset - blkOff[bl_pos - 1] };
+    }
+
+  /*
+    GetText( offset, length, bl_org, bl_end )
+
+    Lists the parts of [bl_org, bl_end) blocks covering the characters range.
+  */
+    auto  GetText( uint32_t offset, uint32_t length, size_t bl_org, size_t bl_end ) const -> std::vector<TextChunk>
+    {
+      auto  output = std::vector<TextChunk>();
+      auto  bl_pos = GetBlockPos( offset, bl_org, bl_end );
+
+      if ( offset < GetOffset( bl_org ) )
+      {
+        length -= std::min( length, GetOffset( bl_org ) - offset );
+        offset = GetOffset( bl_org );
+      }
+
+      for ( auto in_pos = bl_pos.offset; length != 0 && bl_pos.block < bl_end; in_pos = 0, ++bl_pos.block )
+      {
+        auto  cchblk = std::min( blocks[bl_pos.block].GetTextSize() - in_pos, length );
+
+        if ( cchblk != 0 )
+          output.push_back( { &blocks[bl_pos.block], in_pos, cchblk } );
+
+        length -= cchblk;
+      }
+      return output;
+    }
+
+  };
+
+}
+
+# endif   // !__DeliriX_src_text_index_hpp__
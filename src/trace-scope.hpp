@@ -0,0 +1,55 @@
+# if !defined( __DeliriX_src_trace_scope_hpp__ )
+# define __DeliriX_src_trace_scope_hpp__
+# include "../trace.hpp"
+# include <atomic>
+# include <cstdint>
+
+namespace DeliriX {
+namespace trace {
+
+  inline  std::atomic<bool> enabled( false );
+
+  auto  Now() -> uint64_t;
+  void  Put( const char* name, uint64_t start, uint64_t bytes );
+
+  /*
+    Span - the event lasting up to the end of the block, recorded if the trace
+    is started at the block start; the name is a string literal, the bytes are
+    passed as the event argument if set.
+  */
+  class Span
+  {
+    const char* name = nullptr;
+    uint64_t    start = 0;
+    uint64_t    bytes = 0;
+
+  public:
+    Span( const char*, uint64_t = 0 );
+    Span( const Span& ) = delete;
+   ~Span();
+
+    void  SetBytes( uint64_t n )  {  bytes = n;  }
+
+  };
+
+  // Span implementation
+
+  inline  Span::Span( const char* event, uint64_t nbytes )
+  {
+    if ( enabled.load( std::memory_order_relaxed ) )
+    {
+      name = event;
+      start = Now();
+      bytes = nbytes;
+    }
+  }
+
+  inline  Span::~Span()
+  {
+    if ( name != nullptr )
+      Put( name, start, bytes );
+  }
+
+}}
+
+# endif   // !__DeliriX_src_trace_scope_hpp__
@@ -0,0 +1,210 @@
+# include "trace-scope.hpp"
+# include <mtc/wcsstr.h>
+# include <algorithm>
+# include <chrono>
+# include <memory>
+# include <cstdio>
+# include <mutex>
+# include <vector>
+
+namespace DeliriX {
+namespace trace {
+
+  /*
+    Ring - the events recorded by one thread.
+
+    The thread owning the ring is the only writer: it claims the slot, writes
+    the event and then publishes it by the count of the events written.
+    Flush() reads the ring while it is written, so the event fields are
+    atomic, and the count claimed is checked after the read, as seqlock
+    readers do, to drop the slots overwritten while they were read.
+  */
+  struct Ring
+  {
+    struct Event
+    {
+      std::atomic<const char*>  name;
+      std::atomic<uint64_t>     start;
+      std::atomic<uint64_t>     until;
+      std::atomic<uint64_t>     bytes;
+    };
+
+    const unsigned            thread;
+    const uint64_t            length;
+    std::unique_ptr<Event[]>  events;
+    std::atomic<uint64_t>     header;         // the count of the events written
+    std::atomic<uint64_t>     claimed;        // the count of the events written and being written
+    uint64_t                  footer = 0;     // the count of the events flushed
+
+    Ring( unsigned id, size_t len ): thread( id ), length( len ), events( new Event[len] ), header( 0 ), claimed( 0 ) {}
+
+    void  Put( const char*, uint64_t, uint64_t, uint64_t );
+  };
+
+  struct Copy
+  {
+    const char* name;
+    uint64_t    start;
+    uint64_t    until;
+    uint64_t    bytes;
+  };
+
+  static  std::mutex                          mxlock;
+  static  std::vector<std::shared_ptr<Ring>>  threads;
+  static  size_t                              ringSize = 0x10000;
+  static  unsigned                            threadId = 0;
+  static  uint64_t                            origin = 0;
+
+  static  thread_local std::shared_ptr<Ring>  ring;
+
+  // Ring implementation
+
+  void  Ring::Put( const char* name, uint64_t start, uint64_t until, uint64_t bytes )
+  {
+    auto  npos = header.load( std::memory_order_relaxed );
+    auto& slot = events[npos % length];
+
+  // the reader seeing any of the slot changes sees the slot claimed too
+    claimed.store( npos + 1, std::memory_order_relaxed );
+    std::atomic_thread_fence( std::memory_order_release );
+
+    slot.name.store( name, std::memory_order_relaxed );
+    slot.start.store( start, std::memory_order_relaxed );
+    slot.until.store( until, std::memory_order_relaxed );
+    slot.bytes.store( bytes, std::memory_order_relaxed );
+
+    header.store( npos + 1, std::memory_order_release );
+  }
+
+  // the ring of the calling thread, created by the first event
+
+  static  auto  GetRing() -> Ring&
+  {
+    if ( ring == nullptr )
+    {
+      auto  exlock = std::unique_lock<std::mutex>( mxlock );
+
+      threads.push_back( ring = std::make_shared<Ring>( ++threadId, ringSize ) );
+    }
+    return *ring;
+  }
+
+  static  auto  GetEvent( const Copy& event, unsigned thread ) -> std::string
+  {
+    char  buffer[0x100];
+    int   length;
+
+    if ( event.bytes != 0 )
+    {
+      length = snprintf( buffer, sizeof(buffer), "{\"name\":\"%s\",\"cat\":\"DeliriX\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,"
+        "\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"bytes\":%llu}}", event.name, thread,
+        int64_t(event.start - origin) / 1000.0, (event.until - event.start) / 1000.0, (unsigned long long)event.bytes );
+    }
+      else
+    {
+      length = snprintf( buffer, sizeof(buffer), "{\"name\":\"%s\",\"cat\":\"DeliriX\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,"
+        "\"ts\":%.3f,\"dur\":%.3f}", event.name, thread,
+        int64_t(event.start - origin) / 1000.0, (event.until - event.start) / 1000.0 );
+    }
+    return std::string( buffer, std::min( size_t(std::max( length, 0 )), sizeof(buffer) - 1 ) );
+  }
+
+  // public functions
+
+  auto  Now() -> uint64_t
+  {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch() ).count();
+  }
+
+  void  Put( const char* name, uint64_t start, uint64_t bytes )
+  {
+    GetRing().Put( name, start, Now(), bytes );
+  }
+
+  /*
+    Start( ringSize )
+
+    Starts the trace; the ring size is set for the threads recording the
+    first event after the call, the rings created before keep their size.
+  */
+  void  Start( size_t length )
+  {
+    auto  exlock = std::unique_lock<std::mutex>( mxlock );
+
+    ringSize = std::max( length, size_t(0x10) );
+
+    if ( origin == 0 )
+      origin = Now();
+
+    enabled.store( true );
+  }
+
+  void  Stop()
+  {
+    enabled.store( false );
+  }
+
+  bool  Enabled()
+  {
+    return enabled.load();
+  }
+
+  auto  Flush() -> std::string
+  {
+    auto  exlock = std::unique_lock<std::mutex>( mxlock );
+    auto  output = std::string( "{\"traceEvents\":[" );
+    auto  events = std::vector<Copy>();
+    auto  nfirst = true;
+    auto  ndrops = uint64_t(0);
+
+    for ( auto& next: threads )
+    {
+      auto  ntop = next->header.load( std::memory_order_acquire );
+      auto  nbeg = std::max( next->footer, ntop > next->length ? ntop - next->length : 0 );
+      auto  nlow = uint64_t(0);
+
+      events.clear();
+
+      for ( auto npos = nbeg; npos != ntop; ++npos )
+      {
+        auto& slot = next->events[npos % next->length];
+
+        events.push_back( {
+          slot.name.load( std::memory_order_relaxed ),
+          slot.start.load( std::memory_order_relaxed ),
+          slot.until.load( std::memory_order_relaxed ),
+          slot.bytes.load( std::memory_order_relaxed ) } );
+      }
+
+    // the slots claimed again while read are not valid
+      std::atomic_thread_fence( std::memory_order_acquire );
+
+      if ( (nlow = next->claimed.load( std::memory_order_relaxed )) > next->length + nbeg )
+      {
+        auto  ncut = std::min( nlow - next->length - nbeg, uint64_t(events.size()) );
+
+        events.erase( events.begin(), events.begin() + ncut );
+      }
+
+      ndrops += ntop - next->footer - events.size();
+      next->footer = ntop;
+
+      output += mtc::strprintf( "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,"
+        "\"args\":{\"name\":\"DeliriX %u\"}}", nfirst ? "" : ",", next->thread, next->thread );
+
+      for ( auto& event: events )
+        output += ',' + GetEvent( event, next->thread );
+
+      nfirst = false;
+    }
+
+  // the rings of the threads finished are flushed for the last time
+    threads.erase( std::remove_if( threads.begin(), threads.end(), []( const std::shared_ptr<Ring>& next )
+      {  return next.use_count() == 1 && next->footer == next->header.load();  } ), threads.end() );
+
+    return output += mtc::strprintf( "],\"displayTimeUnit\":\"ms\",\"otherData\":{\"droppedEvents\":%llu}}",
+      (unsigned long long)ndrops );
+  }
+
+}}
@@ -0,0 +1,863 @@
+# include "transcode.hpp"
+# include <moonycode/codes.h>
+# include <algorithm>
+# include <cstdint>
+# include <cstring>
+
+# if defined( __x86_64__ ) || defined( _M_X64 )
+#   define DELIRIX_TRANSCODE_SSE2
+#   include <emmintrin.h>
+#   if defined( __GNUC__ )
+#     define DELIRIX_TRANSCODE_AVX2
+#     include <immintrin.h>
+#   endif
+# endif
+
+namespace DeliriX {
+namespace transcode {
+
+  /*
+    Kernels - the ASCII run converters: each one converts the leading ASCII
+    characters of the source and returns the count of characters converted,
+    stopping at the first one out of ASCII; the dumpers escape scanners
+    returning the count of leading characters to be output as they are; and
+    the json block classifier setting the quotes, backslashes and non-space
+    characters bit masks for the 64-byte block.
+  */
+  struct Kernels
+  {
+    const char* name;
+    size_t      (*widen)( widechar*, const char*, size_t );
+    size_t      (*narrow)( char*, const widechar*, size_t );
+    size_t      (*copy)( char*, const char*, size_t );
+    size_t      (*jsonScan)( const char*, size_t );
+    size_t      (*tagsScan)( const char*, size_t );
+    void        (*jsonBlock)( const char*, uint64_t* );
+  };
+
+  /*
+    ByteTable - the single-byte codepage conversion table; the bytes with no
+    one-to-one conversion to the BMP character have zero utf8 size.
+  */
+  struct ByteTable
+  {
+    widechar  wide[0x100];
+    char      utf8[0x100][4];
+    uint8_t   size[0x100];
+    bool      ascii;          // the lower half is ASCII
+  };
+
+  // scalar kernels
+
+  static  size_t  WidenScalar( widechar* out, const char* src, size_t len )
+  {
+    size_t  n = 0;
+
+    for ( ; n != len && (unsigned char)src[n] < 0x80; ++n )
+      out[n] = widechar(src[n]);
+
+    return n;
+  }
+
+  static  size_t  NarrowScalar( char* out, const widechar* src, size_t len )
+  {
+    size_t  n = 0;
+
+    for ( ; n != len && src[n] < 0x80; ++n )
+      out[n] = char(src[n]);
+
+    return n;
+  }
+
+  static  size_t  CopyScalar( char* out, const char* src, size_t len )
+  {
+    size_t  n = 0;
+
+    for ( ; n != len && (unsigned char)src[n] < 0x80; ++n )
+      out[n] = src[n];
+
+    return n;
+  }
+
+  // json escapes '"', '\\', '/' and \b, \t, \n, \f, \r, that are 8..13 but \v
+  static  bool  IsJsonEscape( char c )
+  {
+    return c == '\"' || c == '\\' || c == '/' || (c >= '\b' && c <= '\r' && c != '\v');
+  }
+
+  static  bool  IsTagsEscape( char c )
+  {
+    return c == '<' || c == '>' || c == '&';
+  }
+
+  static  size_t  JsonScanScalar( const char* src, size_t len )
+  {
+    size_t  n = 0;
+
+    while ( n != len && !IsJsonEscape( src[n] ) )
+      ++n;
+
+    return n;
+  }
+
+  static  size_t  TagsScanScalar( const char* src, size_t len )
+  {
+    size_t  n = 0;
+
+    while ( n != len && !IsTagsEscape( src[n] ) )
+      ++n;
+
+    return n;
+  }
+
+# if !defined( DELIRIX_TRANSCODE_SSE2 )
+  // masks[0] - '"', masks[1] - '\\', masks[2] - the characters above ' '
+  static  void  JsonBlockScalar( const char* src, uint64_t* masks )
+  {
+    masks[0] = masks[1] = masks[2] = 0;
+
+    for ( auto n = 0; n != 64; ++n )
+    {
+      masks[0] |= uint64_t(src[n] == '"') << n;
+      masks[1] |= uint64_t(src[n] == '\\') << n;
+      masks[2] |= uint64_t((unsigned char)src[n] > 0x20) << n;
+    }
+  }
+# endif   // !DELIRIX_TRANSCODE_SSE2
+
+  static  size_t  LowestBit( uint32_t mask )
+  {
+# if defined( __GNUC__ )
+    return __builtin_ctz( mask );
+# else
+    size_t  n = 0;
+
+    for ( ; (mask & 1) == 0; mask >>= 1 )
+      ++n;
+
+    return n;
+# endif
+  }
+
+  static  size_t  LowestBit64( uint64_t mask )
+  {
+# if defined( __GNUC__ )
+    return __builtin_ctzll( mask );
+# else
+    size_t  n = 0;
+
+    for ( ; (mask & 1) == 0; mask >>= 1 )
+      ++n;
+
+    return n;
+# endif
+  }
+
+# if defined( DELIRIX_TRANSCODE_SSE2 )
+
+  // SSE2 kernels, 16 characters a step
+
+  static  size_t  WidenSSE2( widechar* out, const char* src, size_t len )
+  {
+    const auto  zero = _mm_setzero_si128();
+    size_t      n = 0;
+
+    for ( ; n + 16 <= len; n += 16 )
+    {
+      auto  v = _mm_loadu_si128( (const __m128i*)(src + n) );
+
+      if ( _mm_movemask_epi8( v ) != 0 )
+        break;
+
+      _mm_storeu_si128( (__m128i*)(out + n), _mm_unpacklo_epi8( v, zero ) );
+      _mm_storeu_si128( (__m128i*)(out + n + 8), _mm_unpackhi_epi8( v, zero ) );
+    }
+
+    return n + WidenScalar( out + n, src + n, len - n );
+  }
+
+  static  size_t  NarrowSSE2( char* out, const widechar* src, size_t len )
+  {
+    const auto  zero = _mm_setzero_si128();
+    const auto  high = _mm_set1_epi16( short(0xff80) );
+    size_t      n = 0;
+
+    for ( ; n + 16 <= len; n += 16 )
+    {
+      auto  lo = _mm_loadu_si128( (const __m128i*)(src + n) );
+      auto  hi = _mm_loadu_si128( (const __m128i*)(src + n + 8) );
+
+      if ( _mm_movemask_epi8( _mm_cmpeq_epi16( _mm_and_si128( _mm_or_si128( lo, hi ), high ), zero ) ) != 0xffff )
+        break;
+
+      _mm_storeu_si128( (__m128i*)(out + n), _mm_packus_epi16( lo, hi ) );
+    }
+
+    return n + NarrowScalar( out + n, src + n, len - n );
+  }
+
+  static  size_t  CopySSE2( char* out, const char* src, size_t len )
+  {
+    size_t  n = 0;
+
+    for ( ; n + 16 <= len; n += 16 )
+    {
+      auto  v = _mm_loadu_si128( (const __m128i*)(src + n) );
+
+      if ( _mm_movemask_epi8( v ) != 0 )
+        break;
+
+      _mm_storeu_si128( (__m128i*)(out + n), v );
+    }
+
+    return n + CopyScalar( out + n, src + n, len - n );
+  }
+
+  static  int   JsonMaskSSE2( __m128i v )
+  {
+    auto  chars = _mm_or_si128( _mm_or_si128(
+      _mm_cmpeq_epi8( v, _mm_set1_epi8( '"' ) ),
+      _mm_cmpeq_epi8( v, _mm_set1_epi8( '\\' ) ) ),
+      _mm_cmpeq_epi8( v, _mm_set1_epi8( '/' ) ) );
+    auto  ctrls = _mm_andnot_si128( _mm_cmpeq_epi8( v, _mm_set1_epi8( '\v' ) ), _mm_and_si128(
+      _mm_cmpgt_epi8( v, _mm_set1_epi8( '\b' - 1 ) ),
+      _mm_cmplt_epi8( v, _mm_set1_epi8( '\r' + 1 ) ) ) );
+
+    return _mm_movemask_epi8( _mm_or_si128( chars, ctrls ) );
+  }
+
+  static  int   TagsMaskSSE2( __m128i v )
+  {
+    return _mm_movemask_epi8( _mm_or_si128( _mm_or_si128(
+      _mm_cmpeq_epi8( v, _mm_set1_epi8( '<' ) ),
+      _mm_cmpeq_epi8( v, _mm_set1_epi8( '>' ) ) ),
+      _mm_cmpeq_epi8( v, _mm_set1_epi8( '&' ) ) ) );
+  }
+
+  static  size_t  JsonScanSSE2( const char* src, size_t len )
+  {
+    size_t  n = 0;
+
+    for ( int mask; n + 16 <= len; n += 16 )
+      if ( (mask = JsonMaskSSE2( _mm_loadu_si128( (const __m128i*)(src + n) ) )) != 0 )
+        return n + LowestBit( mask );
+
+    return n + JsonScanScalar( src + n, len - n );
+  }
+
+  static  size_t  TagsScanSSE2( const char* src, size_t len )
+  {
+    size_t  n = 0;
+
+    for ( int mask; n + 16 <= len; n += 16 )
+      if ( (mask = TagsMaskSSE2( _mm_loadu_si128( (const __m128i*)(src + n) ) )) != 0 )
+        return n + LowestBit( mask );
+
+    return n + TagsScanScalar( src + n, len - n );
+  }
+
+  static  void  JsonBlockSSE2( const char* src, uint64_t* masks )
+  {
+    const auto  quote = _mm_set1_epi8( '"' );
+    const auto  slash = _mm_set1_epi8( '\\' );
+    const auto  space = _mm_set1_epi8( ' ' );
+
+    masks[0] = masks[1] = masks[2] = 0;
+
+    for ( auto n = 0; n != 64; n += 16 )
+    {
+      auto  v = _mm_loadu_si128( (const __m128i*)(src + n) );
+
+      masks[0] |= uint64_t(uint32_t(_mm_movemask_epi8( _mm_cmpeq_epi8( v, quote ) ))) << n;
+      masks[1] |= uint64_t(uint32_t(_mm_movemask_epi8( _mm_cmpeq_epi8( v, slash ) ))) << n;
+      masks[2] |= uint64_t(uint32_t(_mm_movemask_epi8( _mm_cmpeq_epi8( _mm_max_epu8( v, space ), space ) )) ^ 0xffff) << n;
+    }
+  }
+
+# endif   // DELIRIX_TRANSCODE_SSE2
+
+# if defined( DELIRIX_TRANSCODE_AVX2 )
+
+  // AVX2 kernels, 32 characters a step, compiled for the target only; the
+  // tails are scalar not to mix the VEX and legacy SSE code
+
+  __attribute__((target("avx2")))
+  static  size_t  WidenAVX2( widechar* out, const char* src, size_t len )
+  {
+    size_t  n = 0;
+
+    for ( ; n + 32 <= len; n += 32 )
+    {
+      auto  v = _mm256_loadu_si256( (const __m256i*)(src + n) );
+
+      if ( _mm256_movemask_epi8( v ) != 0 )
+        break;
+
+      _mm256_storeu_si256( (__m256i*)(out + n), _mm256_cvtepu8_epi16( _mm256_castsi256_si128( v ) ) );
+      _mm256_storeu_si256( (__m256i*)(out + n + 16), _mm256_cvtepu8_epi16( _mm256_extracti128_si256( v, 1 ) ) );
+    }
+
+    return n + WidenScalar( out + n, src + n, len - n );
+  }
+
+  __attribute__((target("avx2")))
+  static  size_t  NarrowAVX2( char* out, const widechar* src, size_t len )
+  {
+    const auto  high = _mm256_set1_epi16( short(0xff80) );
+    size_t      n = 0;
+
+    for ( ; n + 32 <= len; n += 32 )
+    {
+      auto  lo = _mm256_loadu_si256( (const __m256i*)(src + n) );
+      auto  hi = _mm256_loadu_si256( (const __m256i*)(src + n + 16) );
+
+      if ( !_mm256_testz_si256( _mm256_or_si256( lo, hi ), high ) )
+        break;
+
+    // packus interleaves the 128-bit lanes, so put them in order
+      _mm256_storeu_si256( (__m256i*)(out + n), _mm256_permute4x64_epi64( _mm256_packus_epi16( lo, hi ), 0xd8 ) );
+    }
+
+    return n + NarrowScalar( out + n, src + n, len - n );
+  }
+
+  __attribute__((target("avx2")))
+  static  size_t  CopyAVX2( char* out, const char* src, size_t len )
+  {
+    size_t  n = 0;
+
+    for ( ; n + 32 <= len; n += 32 )
+    {
+      auto  v = _mm256_loadu_si256( (const __m256i*)(src + n) );
+
+      if ( _mm256_movemask_epi8( v ) != 0 )
+        break;
+
+      _mm256_storeu_si256( (__m256i*)(out + n), v );
+    }
+
+    return n + CopyScalar( out + n, src + n, len - n );
+  }
+
+  __attribute__((target("avx2")))
+  static  uint32_t  JsonMaskAVX2( __m256i v )
+  {
+    auto  chars = _mm256_or_si256( _mm256_or_si256(
+      _mm256_cmpeq_epi8( v, _mm256_set1_epi8( '"' ) ),
+      _mm256_cmpeq_epi8( v, _mm256_set1_epi8( '\\' ) ) ),
+      _mm256_cmpeq_epi8( v, _mm256_set1_epi8( '/' ) ) );
+    auto  ctrls = _mm256_andnot_si256( _mm256_cmpeq_epi8( v, _mm256_set1_epi8( '\v' ) ), _mm256_and_si256(
+      _mm256_cmpgt_epi8( v, _mm256_set1_epi8( '\b' - 1 ) ),
+      _mm256_cmpgt_epi8( _mm256_set1_epi8( '\r' + 1 ), v ) ) );
+
+    return uint32_t(_mm256_movemask_epi8( _mm256_or_si256( chars, ctrls ) ));
+  }
+
+  __attribute__((target("avx2")))
+  static  uint32_t  TagsMaskAVX2( __m256i v )
+  {
+    return uint32_t(_mm256_movemask_epi8( _mm256_or_si256( _mm256_or_si256(
+      _mm256_cmpeq_epi8( v, _mm256_set1_epi8( '<' ) ),
+      _mm256_cmpeq_epi8( v, _mm256_set1_epi8( '>' ) ) ),
+      _mm256_cmpeq_epi8( v, _mm256_set1_epi8( '&' ) ) ) ));
+  }
+
+  __attribute__((target("avx2")))
+  static  size_t  JsonScanAVX2( const char* src, size_t len )
+  {
+    size_t  n = 0;
+
+    for ( uint32_t mask; n + 32 <= len; n += 32 )
+      if ( (mask = JsonMaskAVX2( _mm256_loadu_si256( (const __m256i*)(src + n) ) )) != 0 )
+        return n + LowestBit( mask );
+
+    return n + JsonScanScalar( src + n, len - n );
+  }
+
+  __attribute__((target("avx2")))
+  static  size_t  TagsScanAVX2( const char* src, size_t len )
+  {
+    size_t  n = 0;
+
+    for ( uint32_t mask; n + 32 <= len; n += 32 )
+      if ( (mask = TagsMaskAVX2( _mm256_loadu_si256( (const __m256i*)(src + n) ) )) != 0 )
+        return n + LowestBit( mask );
+
+    return n + TagsScanScalar( src + n, len - n );
+  }
+
+  __attribute__((target("avx2")))
+  static  void  JsonBlockAVX2( const char* src, uint64_t* masks )
+  {
+    const auto  quote = _mm256_set1_epi8( '"' );
+    const auto  slash = _mm256_set1_epi8( '\\' );
+    const auto  space = _mm256_set1_epi8( ' ' );
+    auto        lo = _mm256_loadu_si256( (const __m256i*)src );
+    auto        hi = _mm256_loadu_si256( (const __m256i*)(src + 32) );
+
+    masks[0] = uint32_t(_mm256_movemask_epi8( _mm256_cmpeq_epi8( lo, quote ) ))
+      | uint64_t(uint32_t(_mm256_movemask_epi8( _mm256_cmpeq_epi8( hi, quote ) ))) << 32;
+    masks[1] = uint32_t(_mm256_movemask_epi8( _mm256_cmpeq_epi8( lo, slash ) ))
+      | uint64_t(uint32_t(_mm256_movemask_epi8( _mm256_cmpeq_epi8( hi, slash ) ))) << 32;
+    masks[2] = ~(uint32_t(_mm256_movemask_epi8( _mm256_cmpeq_epi8( _mm256_max_epu8( lo, space ), space ) ))
+      | uint64_t(uint32_t(_mm256_movemask_epi8( _mm256_cmpeq_epi8( _mm256_max_epu8( hi, space ), space ) ))) << 32);
+  }
+
+# endif   // DELIRIX_TRANSCODE_AVX2
+
+  static  auto  GetKernels() -> const Kernels&
+  {
+    static const Kernels  kernels = []() -> Kernels
+      {
+# if defined( DELIRIX_TRANSCODE_AVX2 )
+        if ( __builtin_cpu_supports( "avx2" ) )
+          return { "avx2", WidenAVX2, NarrowAVX2, CopyAVX2, JsonScanAVX2, TagsScanAVX2, JsonBlockAVX2 };
+# endif
+# if defined( DELIRIX_TRANSCODE_SSE2 )
+        return { "sse2", WidenSSE2, NarrowSSE2, CopySSE2, JsonScanSSE2, TagsScanSSE2, JsonBlockSSE2 };
+# else
+        return { "scalar", WidenScalar, NarrowScalar, CopyScalar, JsonScanScalar, TagsScanScalar, JsonBlockScalar };
+# endif
+      }();
+
+    return kernels;
+  }
+
+  // codepage tables
+
+  static  auto  EncodeUtf8( char* out, uint32_t u ) -> uint8_t
+  {
+    if ( u < 0x80 )
+      return out[0] = char(u), 1;
+    if ( u < 0x800 )
+      return out[0] = char(0xc0 | (u >> 6)), out[1] = char(0x80 | (u & 0x3f)), 2;
+    if ( u < 0x10000 )
+    {
+      out[0] = char(0xe0 | (u >> 12));
+      out[1] = char(0x80 | ((u >> 6) & 0x3f));
+      out[2] = char(0x80 | (u & 0x3f));
+      return 3;
+    }
+    out[0] = char(0xf0 | (u >> 18));
+    out[1] = char(0x80 | ((u >> 12) & 0x3f));
+    out[2] = char(0x80 | ((u >> 6) & 0x3f));
+    out[3] = char(0x80 | (u & 0x3f));
+    return 4;
+  }
+
+  static  auto  MakeTable( unsigned codepage ) -> ByteTable
+  {
+    ByteTable table;
+
+    table.ascii = true;
+
+    for ( unsigned c = 0; c != 0x100; ++c )
+    {
+      auto      chr = char(c);
+      widechar  wcs[4];
+
+      if ( codepages::mbcstowide( codepage, wcs, 4, &chr, 1 ) == 1 && (wcs[0] < 0xd800 || wcs[0] >= 0xe000) )
+        table.size[c] = EncodeUtf8( table.utf8[c], table.wide[c] = wcs[0] );
+      else
+        table.size[c] = 0;
+
+      if ( c < 0x80 && (table.size[c] == 0 || table.wide[c] != c) )
+        table.ascii = false;
+    }
+    return table;
+  }
+
+  static  auto  GetTable( unsigned codepage ) -> const ByteTable*
+  {
+    switch ( codepage )
+    {
+      case codepages::codepage_1251:
+        {  static const auto  table = MakeTable( codepage );  return &table;  }
+      case codepages::codepage_koi8:
+        {  static const auto  table = MakeTable( codepage );  return &table;  }
+      case codepages::codepage_iso:
+        {  static const auto  table = MakeTable( codepage );  return &table;  }
+      default:
+        return nullptr;
+    }
+  }
+
+  // converters; return size_t(-1) for the input to be passed to codepages::
+
+  static  auto  Utf8ToWide( widechar* out, const char* src, size_t len ) -> size_t
+  {
+    auto& kernel = GetKernels();
+    auto  outorg = out;
+    auto  srcend = src + len;
+
+    while ( src != srcend )
+    {
+      auto  nascii = kernel.widen( out, src, srcend - src );
+
+      out += nascii;
+      src += nascii;
+
+    // decode the non-ASCII run; strictly valid sequences only
+      while ( src != srcend && (unsigned char)*src >= 0x80 )
+      {
+        auto      c = (unsigned char)*src;
+        uint32_t  u;
+        uint32_t  umin;
+        size_t    l;
+
+        if ( c >= 0xc2 && c <= 0xdf )       u = c & 0x1f, umin = 0x80, l = 2;
+          else if ( c >= 0xe0 && c <= 0xef )  u = c & 0x0f, umin = 0x800, l = 3;
+          else if ( c >= 0xf0 && c <= 0xf4 )  u = c & 0x07, umin = 0x10000, l = 4;
+          else return size_t(-1);
+
+        if ( size_t(srcend - src) < l )
+          return size_t(-1);
+
+        for ( size_t i = 1; i != l; ++i )
+        {
+          if ( (src[i] & 0xc0) != 0x80 )
+            return size_t(-1);
+          u = (u << 6) | (src[i] & 0x3f);
+        }
+
+        if ( u < umin || u > 0x10ffff || (u >= 0xd800 && u < 0xe000) )
+          return size_t(-1);
+
+        if ( u >= 0x10000 )
+        {
+          *out++ = widechar(0xd800 + ((u - 0x10000) >> 10));
+          *out++ = widechar(0xdc00 + ((u - 0x10000) & 0x3ff));
+        }
+          else
+        *out++ = widechar(u);
+
+        src += l;
+      }
+    }
+    return out - outorg;
+  }
+
+  static  auto  WideToUtf8( char* out, const widechar* src, size_t len ) -> size_t
+  {
+    auto& kernel = GetKernels();
+    auto  outorg = out;
+    auto  srcend = src + len;
+
+    while ( src != srcend )
+    {
+      auto  nascii = kernel.narrow( out, src, srcend - src );
+
+      out += nascii;
+      src += nascii;
+
+      while ( src != srcend && *src >= 0x80 )
+      {
+        uint32_t  u = *src++;
+
+        if ( u >= 0xd800 && u < 0xe000 )
+        {
+          if ( u >= 0xdc00 || src == srcend || *src < 0xdc00 || *src >= 0xe000 )
+            return size_t(-1);
+          u = 0x10000 + ((u - 0xd800) << 10) + (*src++ - 0xdc00);
+        }
+        out += EncodeUtf8( out, u );
+      }
+    }
+    return out - outorg;
+  }
+
+  static  auto  ByteToWide( widechar* out, const ByteTable& table, const char* src, size_t len ) -> size_t
+  {
+    auto& kernel = GetKernels();
+    auto  outorg = out;
+    auto  srcend = src + len;
+
+    while ( src != srcend )
+    {
+      if ( table.ascii )
+      {
+        auto  nascii = kernel.widen( out, src, srcend - src );
+
+        out += nascii;
+        src += nascii;
+      }
+
+      for ( ; src != srcend && (!table.ascii || (unsigned char)*src >= 0x80); ++src )
+      {
+        if ( table.size[(unsigned char)*src] == 0 )
+          return size_t(-1);
+        *out++ = table.wide[(unsigned char)*src];
+      }
+    }
+    return out - outorg;
+  }
+
+  static  auto  ByteToUtf8( char* out, const ByteTable& table, const char* src, size_t len ) -> size_t
+  {
+    auto& kernel = GetKernels();
+    auto  outorg = out;
+    auto  srcend = src + len;
+
+    while ( src != srcend )
+    {
+      if ( table.ascii )
+      {
+        auto  nascii = kernel.copy( out, src, srcend - src );
+
+        out += nascii;
+        src += nascii;
+      }
+
+      for ( ; src != srcend && (!table.ascii || (unsigned char)*src >= 0x80); ++src )
+      {
+        auto  nchars = table.size[(unsigned char)*src];
+
+        if ( nchars == 0 )
+          return size_t(-1);
+        memcpy( out, table.utf8[(unsigned char)*src], nchars );
+          out += nchars;
+      }
+    }
+    return out - outorg;
+  }
+
+  // public functions
+
+  void  AppendWide( mtc::widestr& output, unsigned codepage, const std::string_view& src )
+  {
+    auto  origin = output.size();
+    auto  length = size_t(-1);
+    auto  ptable = (const ByteTable*)nullptr;
+
+  // no codepage gives more characters than bytes
+    output.resize( origin + src.size() );
+
+    if ( codepage == codepages::codepage_utf8 )
+      length = Utf8ToWide( (widechar*)output.data() + origin, src.data(), src.size() );
+    else if ( (ptable = GetTable( codepage )) != nullptr )
+      length = ByteToWide( (widechar*)output.data() + origin, *ptable, src.data(), src.size() );
+
+    if ( length != size_t(-1) )
+      return output.resize( origin + length );
+
+    output.resize( origin );
+    output += codepages::mbcstowide( codepage, src );
+  }
+
+  auto  ToWide( unsigned codepage, const std::string_view& src ) -> mtc::widestr
+  {
+    mtc::widestr  output;
+
+    return AppendWide( output, codepage, src ), output;
+  }
+
+  auto  ToWide( unsigned codepage, widechar* output, size_t maxlen, const std::string_view& src ) -> size_t
+  {
+    auto  length = size_t(-1);
+    auto  ptable = (const ByteTable*)nullptr;
+
+    if ( src.size() <= maxlen )
+    {
+      if ( codepage == codepages::codepage_utf8 )
+        length = Utf8ToWide( output, src.data(), src.size() );
+      else if ( (ptable = GetTable( codepage )) != nullptr )
+        length = ByteToWide( output, *ptable, src.data(), src.size() );
+
+      if ( length != size_t(-1) )
+        return length;
+    }
+    return codepages::mbcstowide( codepage, output, maxlen, src.data(), src.size() );
+  }
+
+  void  AppendUtf8( std::string& output, const std::basic_string_view<widechar>& src )
+  {
+    auto  origin = output.size();
+    auto  length = size_t(-1);
+
+  // a widechar gives 3 bytes at most, a surrogate pair gives 4
+    output.resize( origin + src.size() * 3 );
+
+    if ( (length = WideToUtf8( (char*)output.data() + origin, src.data(), src.size() )) != size_t(-1) )
+      return output.resize( origin + length );
+
+    output.resize( origin );
+    output += codepages::widetombcs( codepages::codepage_utf8, src );
+  }
+
+  void  AppendUtf8( std::string& output, unsigned codepage, const std::string_view& src )
+  {
+    auto  origin = output.size();
+    auto  length = size_t(-1);
+    auto  ptable = GetTable( codepage );
+
+    if ( ptable != nullptr )
+    {
+      output.resize( origin + src.size() * 3 );
+
+      if ( (length = ByteToUtf8( (char*)output.data() + origin, *ptable, src.data(), src.size() )) != size_t(-1) )
+        return output.resize( origin + length );
+
+      output.resize( origin );
+    }
+    output += codepages::mbcstombcs( codepages::codepage_utf8, codepage, src );
+  }
+
+  auto  ToUtf8( const std::basic_string_view<widechar>& src ) -> std::string
+  {
+    std::string output;
+
+    return AppendUtf8( output, src ), output;
+  }
+
+  auto  ToUtf8( unsigned codepage, const std::string_view& src ) -> std::string
+  {
+    std::string output;
+
+    return AppendUtf8( output, codepage, src ), output;
+  }
+
+  void  ToUtf8Chunks( const std::basic_string_view<widechar>& src, const std::function<void( const std::string_view& )>& fn )
+  {
+    char  buffer[0x1000];
+    auto  srcptr = src.data();
+    auto  srcend = srcptr + src.size();
+
+    while ( srcptr != srcend )
+    {
+      auto  nwides = std::min( size_t(srcend - srcptr), sizeof(buffer) / 3 );
+      auto  length = size_t(-1);
+
+    // do not split the surrogate pairs
+      if ( srcptr + nwides != srcend && srcptr[nwides - 1] >= 0xd800 && srcptr[nwides - 1] < 0xdc00 )
+        --nwides;
+
+      if ( (length = WideToUtf8( buffer, srcptr, nwides )) != size_t(-1) )
+        fn( { buffer, length } );
+      else
+        fn( codepages::widetombcs( codepages::codepage_utf8, { srcptr, nwides } ) );
+
+      srcptr += nwides;
+    }
+  }
+
+  void  ToUtf8Chunks( unsigned codepage, const std::string_view& src, const std::function<void( const std::string_view& )>& fn )
+  {
+    auto  ptable = GetTable( codepage );
+
+    if ( codepage == codepages::codepage_utf8 )
+      return fn( src );
+
+    if ( ptable == nullptr )
+      return fn( ToUtf8( codepage, src ) );
+
+    for ( size_t offset = 0; offset != src.size(); )
+    {
+      char  buffer[0x1000];
+      auto  nchars = std::min( src.size() - offset, sizeof(buffer) / 3 );
+      auto  length = ByteToUtf8( buffer, *ptable, src.data() + offset, nchars );
+
+      if ( length != size_t(-1) )
+        fn( { buffer, length } );
+      else
+        fn( codepages::mbcstombcs( codepages::codepage_utf8, codepage, src.substr( offset, nchars ) ) );
+
+      offset += nchars;
+    }
+  }
+
+  auto  FindJsonEscape( const char* src, size_t len ) -> size_t
+  {
+    return GetKernels().jsonScan( src, len );
+  }
+
+  auto  FindTagsEscape( const char* src, size_t len ) -> size_t
+  {
+    return GetKernels().tagsScan( src, len );
+  }
+
+  /*
+    The json structural index is built in 64-byte blocks by the bit masks:
+    the characters escaped by the backslashes are found, the strings are got
+    by the prefix xor of the unescaped quotes, and the positions of quotes,
+    escaping backslashes in the strings and any non-space characters out of
+    the strings are collected.
+  */
+
+  // the characters escaped by the backslashes; carry is set if the first
+  // character of the next block is escaped
+  static  auto  FindEscaped( uint64_t slashes, uint64_t& carry ) -> uint64_t
+  {
+    auto  escaped = carry;
+
+    carry = 0;
+
+    for ( auto bits = slashes & ~escaped; bits != 0; )
+    {
+      auto  bitpos = LowestBit64( bits );
+
+      if ( bitpos == 63 )
+        return carry = 1, escaped;
+
+      escaped |= uint64_t(2) << bitpos;
+      bits &= ~(uint64_t(3) << bitpos);
+    }
+    return escaped;
+  }
+
+  // each bit is the xor of the bits up to it, so the bits are set from each
+  // odd quote up to the next one
+  static  auto  PrefixXor( uint64_t bits ) -> uint64_t
+  {
+    bits ^= bits << 1;
+    bits ^= bits << 2;
+    bits ^= bits << 4;
+    bits ^= bits << 8;
+    bits ^= bits << 16;
+    bits ^= bits << 32;
+    return bits;
+  }
+
+  auto  JsonIndex::Fill( const char** output, size_t size ) -> size_t
+  {
+    auto  classify = GetKernels().jsonBlock;
+    auto  count = size_t(0);
+    char  padding[64];
+
+    for ( ; offset < length && size - count >= 64; offset += 64 )
+    {
+      auto      block = source + offset;
+      uint64_t  masks[3];
+      uint64_t  escaped;
+      uint64_t  quotes;
+      uint64_t  tokens;
+
+    // the last block is padded with spaces
+      if ( length - offset < 64 )
+      {
+        memset( padding, ' ', sizeof(padding) );
+        memcpy( padding, block, length - offset );
+        classify( padding, masks );
+      }
+        else
+      classify( block, masks );
+
+      escaped = FindEscaped( masks[1], carried );
+      quotes = masks[0] & ~escaped;
+      tokens = PrefixXor( quotes ) ^ instring;
+      instring = uint64_t(0) - (tokens >> 63);
+
+    // the escaping backslashes in the strings are indexed, too
+      tokens = quotes | (masks[1] & ~escaped & tokens) | (masks[2] & ~masks[0] & ~tokens);
+
+      for ( ; tokens != 0; tokens &= tokens - 1 )
+        output[count++] = block + LowestBit64( tokens );
+    }
+    return count;
+  }
+
+  auto  GetKernelsName() -> const char*
+  {
+    return GetKernels().name;
+  }
+
+}}
@@ -0,0 +1,85 @@
+# if !defined( __DeliriX_src_transcode_hpp__ )
+# define __DeliriX_src_transcode_hpp__
+# include <mtc/wcsstr.h>
+# include <string_view>
+# include <functional>
+# include <cstdint>
+# include <string>
+
+namespace DeliriX {
+namespace transcode {
+
+  /*
+    The text conversions used by the adapters and the dumps, giving the same
+    result as the codepages:: functions they replace.
+
+    UTF-8 and the table-driven single-byte codepages (1251, KOI8, ISO) are
+    converted by the vectorized kernels copying the ASCII runs in 16 or 32
+    byte strides, selected once by the CPU features; the characters out of
+    ASCII are converted by the tables built from codepages:: on first use.
+    The other codepages and any invalid input, such as broken UTF-8 or the
+    unpaired surrogates, are passed to codepages:: as they are.
+  */
+  void  AppendWide( mtc::widestr&, unsigned codepage, const std::string_view& );
+  auto  ToWide( unsigned codepage, const std::string_view& ) -> mtc::widestr;
+
+  // converts to the buffer; returns size_t(-1) if the output does not fit
+  auto  ToWide( unsigned codepage, widechar*, size_t, const std::string_view& ) -> size_t;
+
+  void  AppendUtf8( std::string&, const std::basic_string_view<widechar>& );
+  void  AppendUtf8( std::string&, unsigned codepage, const std::string_view& );
+  auto  ToUtf8( const std::basic_string_view<widechar>& ) -> std::string;
+  auto  ToUtf8( unsigned codepage, const std::string_view& ) -> std::string;
+
+  /*
+    ToUtf8Chunks( ..., fn )
+
+    Converts to UTF-8 by the chunks of up to 4K passed to fn() not splitting
+    the characters, with no temporary string for the whole text; UTF-8 text
+    is passed as it is.
+  */
+  void  ToUtf8Chunks( const std::basic_string_view<widechar>&, const std::function<void( const std::string_view& )>& );
+  void  ToUtf8Chunks( unsigned codepage, const std::string_view&, const std::function<void( const std::string_view& )>& );
+
+  /*
+    FindJsonEscape(), FindTagsEscape()
+
+    Return the count of the leading characters needing no escape in json
+    strings ('"', '\\', '/' and \b, \t, \n, \f, \r are escaped) and in the
+    tags dump text ('<', '>', '&'); scan 16 or 32 bytes a step.
+  */
+  auto  FindJsonEscape( const char*, size_t ) -> size_t;
+  auto  FindTagsEscape( const char*, size_t ) -> size_t;
+
+  /*
+    JsonIndex - the structural index of the json source built by the 64-byte
+    blocks on demand: Fill() puts the positions of all the unescaped quotes,
+    opening and closing the strings, of the backslashes escaping the string
+    characters, and of any non-space characters out of the strings, that are
+    the brackets, braces, colons and commas for valid json.
+
+    The blocks are classified by the kernels, and the escapes and the strings
+    are found by the bit masks, not by the characters.
+  */
+  class JsonIndex
+  {
+    const char* source;
+    size_t      length;
+    size_t      offset = 0;
+    uint64_t    carried = 0;      // the next block starts with the escaped char
+    uint64_t    instring = 0;     // all ones if the next block starts in a string
+
+  public:
+    JsonIndex( const char* src, size_t len ): source( src ), length( len ) {}
+
+  // fills the buffer of 64 positions at least while it has space for the
+  // next block; returns the count of positions, 0 at the end of source only
+    auto  Fill( const char**, size_t ) -> size_t;
+  };
+
+  // the kernels set selected: "avx2", "sse2" or "scalar"
+  auto  GetKernelsName() -> const char*;
+
+}}
+
+# endif   // !__DeliriX_src_transcode_hpp__
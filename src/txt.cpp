@@ -1,4 +1,7 @@
 # include "../DOM-text.hpp"
+# include "text-index.hpp"
+# include "stats-scope.hpp"
+# include "dump-v2.hpp"
 # include <moonycode/codes.h>
 # include <mtc/wcsstr.h>
 
@@ -12,6 +15,7 @@ namespace DeliriX
   protected:
     auto  AddMarkupTag( const std::string_view&, const markup_attribute& ) -> mtc::api<IText> override;
     auto  AddParagraph( const Paragraph& ) -> Paragraph override;
+    auto  GetArena() -> ParagraphArena* override  {  return docptr->GetArena();  }
 
     void  Close();
 
@@ -30,6 +34,14 @@ namespace DeliriX
 
   };
 
+  // counts the parse stats allocations: the objects created and the vector growth
+  template <class T>
+  static  void  CountAllocs( const std::vector<T>& vec, size_t count = 0 )
+  {
+    if ( stats::Enabled() )
+      stats::Count( &ParseStats::allocs, count + (vec.size() == vec.capacity() ? 1 : 0) );
+  }
+
   // Text implementation
 
   Text::Text( int ): refCount( 0 ) {}
@@ -44,6 +56,9 @@ namespace DeliriX
     blocks = std::move( r.blocks );
     markup = std::move( r.markup );
     length = std::move( r.length );  r.length = 0;
+    blkoff = std::move( r.blkoff );
+    arena = std::move( r.arena );
+      r.tindex.reset();
   }
 
   Text::Text( const wide_string_view& str ): refCount( 1 )
@@ -94,6 +109,10 @@ namespace DeliriX
       nested = nullptr;
     length = std::move( txt.length );
       txt.length = 0;
+    blkoff = std::move( txt.blkoff );
+    arena = std::move( txt.arena );
+    tindex.reset();
+      txt.tindex.reset();
     return *this;
   }
 
@@ -126,6 +145,10 @@ namespace DeliriX
     if ( nested != nullptr )
       nested->Close();
 
+    tindex.reset();
+
+    CountAllocs( markup, 1 );
+
     return nested = new Markup( this, tag );
   }
 
@@ -134,6 +157,13 @@ namespace DeliriX
     if ( nested != nullptr )
       nested->Close();
 
+    tindex.reset();
+
+    CountAllocs( blocks );
+
+    if ( blkoff.size() == blocks.size() )
+      CountAllocs( blkoff ), blkoff.push_back( length );
+
     blocks.emplace_back( p );
       length += p.GetTextSize();
     return blocks.back();
@@ -145,11 +175,60 @@ namespace DeliriX
       nested->Close();
     blocks.clear();
     markup.clear();
+    blkoff.clear();
     length = 0;
+    tindex.reset();
+
+    if ( arena != nullptr )
+      arena->Reset();
+  }
+
+  void  Text::SetArena( size_t chunkSize )
+  {
+    if ( chunkSize != 0 )
+      arena = std::make_unique<ParagraphArena>( chunkSize );
+    else
+      arena.reset();
+  }
+
+  auto  Text::GetIndex() const -> std::shared_ptr<const TextIndex>
+  {
+    auto  exlock = std::unique_lock<std::mutex>( mxlock );
+
+    if ( tindex == nullptr )
+    {
+    // the offsets dropped by the blocks access are got again, and are then
+    // kept by AddParagraph() as usual
+      if ( blkoff.size() != blocks.size() )
+      {
+        auto  offset = uint32_t(0);
+
+        blkoff.clear();
+        blkoff.reserve( blocks.size() );
+
+        for ( auto& next: blocks )
+          blkoff.push_back( offset ), offset += next.GetTextSize();
+      }
+      tindex = std::make_shared<const TextIndex>( blocks, markup, blkoff );
+    }
+    return tindex;
   }
 
-  auto  Text::GetBufLen() const -> size_t
+  auto  Text::GetBlockPos( uint32_t offset ) const -> BlockPos
   {
+    return GetIndex()->GetBlockPos( offset, 0, blocks.size() );
+  }
+
+  auto  Text::GetText( uint32_t offset, uint32_t cchtxt ) const -> std::vector<TextChunk>
+  {
+    return GetIndex()->GetText( offset, cchtxt, 0, blocks.size() );
+  }
+
+  auto  Text::GetBufLen( unsigned version ) const -> size_t
+  {
+    if ( version != dump_v1 )
+      return ITextView::GetBufLen( version );
+
     auto  cch = ::GetBufLen( blocks.size() ) + ::GetBufLen( markup.size() );
 
     for ( auto& str: blocks )
@@ -164,13 +243,93 @@ namespace DeliriX
     for ( auto& tag: markup )
     {
       cch +=
-        ::GetBufLen( tag.tagKey )
+        ::GetBufLen( tag.tagKey.str() )
       + ::GetBufLen( tag.uLower )
       + ::GetBufLen( tag.uUpper );
     }
     return cch + ::GetBufLen( length );
   }
 
+  /*
+    FetchDump( fetch )
+
+    Reads the v1 or the columnar v2 dump by the checked readers shared with
+    the dump view; the compressed dump is read whole and passed to FetchZ().
+    The text length stored last is checked by the blocks read.
+  */
+  bool  Text::FetchDump( std::function<bool( void*, size_t )> fetch )
+  {
+    auto      source = FetchSource{ fetch };
+    auto      srcptr = &source;
+    auto      tagKeys = std::vector<TagKey>();
+    auto      columns = std::vector<uint32_t>();
+    auto      zipped = std::string();
+    unsigned  version;
+    size_t    ncount;
+    uint32_t  cchdoc;
+
+    clear();
+
+  // get strings vector length value; the empty one may be the v2 signature
+    if ( (srcptr = ::FetchFrom( srcptr, ncount )) == nullptr )
+      return false;
+
+    if ( ncount != 0 )
+    {
+      blocks.reserve( std::min( ncount, dump_v2::growStep ) );
+
+      while ( blocks.size() != ncount )
+      {
+        if ( !blocks.emplace_back().FetchFrom( fetch, arena.get() ) )
+          return false;
+        blkoff.push_back( length );
+          length += blocks.back().GetTextSize();
+      }
+      srcptr = dump_v2::GetTags( ::FetchFrom( srcptr, ncount ), ncount, markup );
+    }
+      else
+    if ( (srcptr = ::FetchFrom( srcptr, ncount )) == nullptr )
+      return false;
+      else
+    if ( ncount != v2signature )
+      srcptr = dump_v2::GetTags( srcptr, ncount, markup );
+      else
+    {
+      if ( (srcptr = ::FetchFrom( srcptr, version )) == nullptr )
+        return false;
+
+    // the compressed dump is read whole and inflated
+      if ( version == dump_z )
+      {
+        if ( (srcptr = dump_v2::GetCount( srcptr, ncount )) == nullptr )
+          return false;
+        return dump_v2::GetString( srcptr, zipped, ncount ) != nullptr && FetchZ( zipped.data(), zipped.size() );
+      }
+
+    // the encodings and the lengths columns, then the text
+      if ( version != dump_v2 || (srcptr = dump_v2::GetHead( srcptr, columns, ncount )) == nullptr )
+        return false;
+
+      blocks.reserve( ncount );
+      blkoff.reserve( ncount );
+
+      for ( size_t i = 0; i != ncount; ++i )
+      {
+        if ( !blocks.emplace_back().FetchFrom( columns[i] - 1, columns[ncount + i], fetch, arena.get() ) )
+          return false;
+        blkoff.push_back( length );
+          length += columns[ncount + i];
+      }
+
+    // the tag names table and the markup columns
+      if ( (srcptr = dump_v2::GetTagKeys( srcptr, tagKeys )) != nullptr )
+        srcptr = dump_v2::GetMarkup( srcptr, tagKeys, markup );
+    }
+
+  // the text length is stored after the markup
+    return ::FetchFrom( srcptr, cchdoc ) != nullptr && cchdoc == length;
+  }
+
   // Text::Markup implementation
   
   Text::Markup::Markup( Text* owner, const std::string_view& tag ):
@@ -179,7 +338,7 @@ namespace DeliriX
     nested( nullptr ),
     tagBeg( owner->markup.size() )
   {
-    owner->markup.push_back( { std::string( tag.data(), tag.length() ), uint32_t(owner->length), uint32_t(-1) } );
+    owner->markup.push_back( { TagKey( tag ), uint32_t(owner->length), uint32_t(-1) } );
   }
 
   Text::Markup::Markup( Markup* owner, const std::string_view& tag ):
@@ -188,7 +347,7 @@ namespace DeliriX
     nested( nullptr ),
     tagBeg( docptr->markup.size() )
   {
-    docptr->markup.push_back( { std::string( tag.data(), tag.length() ), uint32_t(docptr->length), uint32_t(-1) } );
+    docptr->markup.push_back( { TagKey( tag ), uint32_t(docptr->length), uint32_t(-1) } );
   }
 
   Text::Markup::~Markup()
@@ -201,6 +360,10 @@ namespace DeliriX
     if ( nested != nullptr )
       nested->Close();
 
+    docptr->tindex.reset();
+
+    CountAllocs( docptr->markup, 1 );
+
     return nested = new Markup( this, tag );
   }
 
@@ -212,6 +375,13 @@ namespace DeliriX
     if ( nested != nullptr )
       nested->Close();
 
+    docptr->tindex.reset();
+
+    CountAllocs( docptr->blocks );
+
+    if ( docptr->blkoff.size() == docptr->blocks.size() )
+      CountAllocs( docptr->blkoff ), docptr->blkoff.push_back( docptr->length );
+
     docptr->blocks.emplace_back( str );
       docptr->length += str.GetTextSize();
     return docptr->blocks.back();
@@ -227,6 +397,8 @@ namespace DeliriX
       if ( *ppself != nullptr )
         *ppself = nullptr;
 
+      docptr->tindex.reset();
+
       if ( docptr->length < docptr->markup[tagBeg].uLower + 1 )
       {
         assert( docptr->markup.size() == tagBeg + 1 );
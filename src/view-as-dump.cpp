@@ -0,0 +1,213 @@
+# include "../DOM-view.hpp"
+# include "text-index.hpp"
+# include "paragraph.hpp"
+# include "dump-v2.hpp"
+# include <stdexcept>
+# include <mutex>
+
+namespace DeliriX {
+namespace view_as {
+
+  /*
+    DumpView - the document view with the paragraphs over the source buffer.
+
+    Both v1 and v2 dumps are accepted. The paragraph headers are allocated in
+    one chunk holding the buffer; the wide strings misaligned in the buffer
+    are copied to the same chunk.
+  */
+  class DumpView final: public ITextView
+  {
+    struct BlockRef
+    {
+      uint32_t    encode;
+      uint32_t    length;
+      const char* ptrstr;
+    };
+
+    std::vector<Paragraph>  blocks;
+    std::vector<MarkupTag>  markup;
+    std::vector<uint32_t>   blkoff;
+    uint32_t                length = 0;
+
+    mutable std::mutex                        mxlock;
+    mutable std::shared_ptr<const TextIndex>  tindex;
+
+    implement_lifetime_control
+
+  public:
+    auto  Load( const mtc::api<const mtc::IByteBuffer>& ) -> DumpView*;
+
+    auto  GetBlocks() const -> mtc::span<const Paragraph> override  {  return blocks;  }
+    auto  GetMarkup() const -> mtc::span<const MarkupTag> override  {  return markup;  }
+    auto  GetLength() const -> uint32_t override                    {  return length;  }
+    auto  GetBlockPos( uint32_t offset ) const -> BlockPos override
+      {  return GetIndex()->GetBlockPos( offset, 0, blocks.size() );  }
+    auto  GetText( uint32_t offset, uint32_t cchtxt ) const -> std::vector<TextChunk> override
+      {  return GetIndex()->GetText( offset, cchtxt, 0, blocks.size() );  }
+
+  protected:
+    auto  GetIndex() const -> std::shared_ptr<const TextIndex> override;
+
+    auto  LoadV1( DumpSource*, size_t, std::vector<BlockRef>& ) -> DumpSource*;
+    auto  LoadV2( DumpSource*, std::vector<BlockRef>& ) -> DumpSource*;
+    auto  LoadTags( DumpSource*, size_t ) -> DumpSource*;
+
+  };
+
+  // DumpView implementation
+
+  auto  DumpView::Load( const mtc::api<const mtc::IByteBuffer>& buffer ) -> DumpView*
+  {
+    auto  source = DumpSource{ buffer->GetPtr(), buffer->GetPtr() + buffer->GetLen() };
+    auto  srcptr = &source;
+    auto  blkref = std::vector<BlockRef>();
+    auto  nblock = size_t(0);
+    auto  extlen = size_t(0);
+    auto  cchsum = uint32_t(0);
+
+  // check the dump and list the blocks; the empty v1 blocks list may be the
+  // v2 signature
+    if ( (srcptr = ::FetchFrom( srcptr, nblock )) == nullptr )
+      return nullptr;
+
+    if ( nblock != 0 )
+      srcptr = LoadV1( srcptr, nblock, blkref );
+    else if ( (srcptr = ::FetchFrom( srcptr, nblock )) != nullptr )
+      srcptr = nblock == v2signature ? LoadV2( srcptr, blkref ) : LoadTags( srcptr, nblock );
+
+    if ( (srcptr = ::FetchFrom( srcptr, length )) == nullptr )
+      return nullptr;
+
+  // create the paragraphs; the data is checked, so nothing fails here
+    for ( auto& next: blkref )
+    {
+      if ( next.encode == uint32_t(-1) && (uintptr_t)next.ptrstr % alignof(widechar) != 0 )
+        extlen += (next.length * sizeof(widechar) + sizeof(ParagraphCtl) - 1) / sizeof(ParagraphCtl) * sizeof(ParagraphCtl);
+      cchsum += next.length;
+    }
+
+  // the text length stored is the blocks length
+    if ( cchsum != length )
+      return nullptr;
+
+    if ( !blkref.empty() )
+    {
+      auto  header = ParagraphArena::Chunk::HeaderSize();
+      auto  pchunk = ParagraphArena::Chunk::Create( header + blkref.size() * sizeof(ParagraphCtl) + extlen, 0 );
+      auto  ctlptr = (ParagraphCtl*)((char*)pchunk + header);
+      auto  extptr = (char*)(ctlptr + blkref.size());
+
+      pchunk->rcount = blkref.size();
+      pchunk->holder = buffer.ptr();
+
+      blocks.resize( blkref.size() );
+      blkoff.reserve( blkref.size() );
+      length = 0;
+
+      for ( size_t i = 0; i != blkref.size(); ++i )
+      {
+        auto& next = blkref[i];
+        auto  ptrstr = next.ptrstr;
+
+        if ( next.encode == uint32_t(-1) && (uintptr_t)ptrstr % alignof(widechar) != 0 )
+        {
+          ptrstr = (const char*)memcpy( extptr, ptrstr, next.length * sizeof(widechar) );
+          extptr += (next.length * sizeof(widechar) + sizeof(ParagraphCtl) - 1) / sizeof(ParagraphCtl) * sizeof(ParagraphCtl);
+        }
+
+        ParagraphCtl::Attach( blocks[i], new( ctlptr++ ) ParagraphCtl{ next.encode, next.length, 1, pchunk, ptrstr } );
+
+        blkoff.push_back( length );
+          length += next.length;
+      }
+    }
+    return this;
+  }
+
+  auto  DumpView::LoadV1( DumpSource* srcptr, size_t nblock, std::vector<BlockRef>& blkref ) -> DumpSource*
+  {
+    if ( nblock > size_t(srcptr->end - srcptr->ptr) )
+      return nullptr;
+
+    blkref.reserve( nblock );
+
+    for ( size_t i = 0; i != nblock; ++i )
+    {
+      uint32_t  encode;
+      uint32_t  cchstr;
+
+      if ( (srcptr = ::FetchFrom( ::FetchFrom( srcptr, encode ), cchstr )) == nullptr )
+        return nullptr;
+
+      blkref.push_back( { --encode, cchstr, srcptr->ptr } );
+
+      if ( (srcptr = srcptr->Skip( encode == uint32_t(-1) ? cchstr * sizeof(widechar) : cchstr )) == nullptr )
+        return nullptr;
+    }
+
+    return (srcptr = ::FetchFrom( srcptr, nblock )) != nullptr ? LoadTags( srcptr, nblock ) : nullptr;
+  }
+
+  auto  DumpView::LoadV2( DumpSource* srcptr, std::vector<BlockRef>& blkref ) -> DumpSource*
+  {
+    auto      tagKeys = std::vector<TagKey>();
+    auto      columns = std::vector<uint32_t>();
+    unsigned  version;
+    size_t    ncount;
+
+    if ( (srcptr = ::FetchFrom( srcptr, version )) == nullptr || version != dump_v2 )
+      return nullptr;
+
+  // the encodings and the lengths columns, then the text blob
+    if ( (srcptr = dump_v2::GetHead( srcptr, columns, ncount )) == nullptr )
+      return nullptr;
+
+    blkref.resize( ncount );
+
+    for ( size_t i = 0; i != ncount; ++i )
+    {
+      auto& next = blkref[i];
+
+      next.encode = columns[i] - 1;
+      next.length = columns[ncount + i];
+      next.ptrstr = srcptr->ptr;
+
+      if ( (srcptr = srcptr->Skip( next.encode == uint32_t(-1) ? next.length * sizeof(widechar) : next.length )) == nullptr )
+        return nullptr;
+    }
+
+  // the tag names table and the markup columns
+    if ( (srcptr = dump_v2::GetTagKeys( srcptr, tagKeys )) == nullptr )
+      return nullptr;
+
+    return dump_v2::GetMarkup( srcptr, tagKeys, markup );
+  }
+
+  auto  DumpView::LoadTags( DumpSource* srcptr, size_t ntotal ) -> DumpSource*
+  {
+    return dump_v2::GetTags( srcptr, ntotal, markup );
+  }
+
+  auto  DumpView::GetIndex() const -> std::shared_ptr<const TextIndex>
+  {
+    auto  exlock = std::unique_lock<std::mutex>( mxlock );
+
+    if ( tindex == nullptr )
+      tindex = std::make_shared<const TextIndex>( blocks, markup, blkoff );
+
+    return tindex;
+  }
+
+  // public functions
+
+  auto  Dump( const mtc::api<const mtc::IByteBuffer>& buffer ) -> mtc::api<const ITextView>
+  {
+    mtc::api<DumpView>  dumped;
+
+    if ( buffer == nullptr )
+      throw std::invalid_argument( "view_as::Dump source buffer is empty" );
+
+    return (dumped = new DumpView())->Load( buffer );
+  }
+
+}}
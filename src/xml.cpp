@@ -1,31 +1,185 @@
 # include "../formats.hpp"
 # include "../compat.hpp"
+# include "stats-scope.hpp"
+# include "trace-scope.hpp"
 # include <moonycode/codes.h>
 # include <mtc/wcsstr.h>
-# include <tinyxml2.h>
+# include <cstring>
+# include <vector>
 # include <map>
 
 namespace DeliriX
 {
 
+  /*
+    Parser - streaming xml tokenizer.
+
+    Reads the source bytes once and passes elements and text nodes to IText
+    interface as soon as they are read; the only state kept is the stack of
+    open elements, so the memory used depends on the nesting depth and not on
+    the document size.
+
+    The tokenizer follows tinyxml2 rules used before: whitespace-only text
+    nodes are skipped, text nodes keep their spaces, newlines are normalized
+    to '\n', predefined and numeric character entities are expanded.
+  */
   class Parser
   {
-    unsigned  encode = codepages::codepage_utf8;
+    struct Node
+    {
+      mtc::api<IText>   output;
+      std::string_view  tagKey;
+    };
+
+    const char* const xmltop;
+    const char* const xmlend;
+    const char*       xmlptr;
+    unsigned          encode = codepages::codepage_utf8;
+    bool              isHead = true;
+    std::vector<Node> nested;
+    std::string       buffer;
 
   public:
-    auto  Decl( IText* text, const char* decl ) -> IText*;
-    auto  Elem( IText* text, const tinyxml2::XMLElement& ) -> IText*;
-    auto  List( IText* text, const tinyxml2::XMLElement& ) -> IText*;
-    auto  Load( IText* text, const tinyxml2::XMLNode& ) -> IText*;
+    Parser( const char* src, size_t len ):
+      xmltop( src ),
+      xmlend( src + len ),
+      xmlptr( src ) {}
+   ~Parser();
+
+    void  Load( IText* );
 
   protected:
-    auto  Decl( const char* ) const -> std::map<std::string, std::string>;
+    void  Decl( const std::string_view& );
+    void  Elem( IText* );
+    void  Tail();
+    void  AddText( IText*, const std::string_view& );
+
+  protected:
+    auto  Args( const char* ) const -> std::map<std::string, std::string>;
+    auto  Name() -> std::string_view;
+    auto  Find( const char* ) const -> const char*;
+    auto  Copy( const char*, const char*, bool entities ) -> std::string_view;
+    void  Skip();
+    bool  Look( const char* ) const;
+    auto  Fail( const char* ) const -> Error;
 
   };
 
-  auto  Parser::Decl( IText* text, const char* dcl ) -> IText*
+  inline  bool  IsSpace( char c )
+  {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' || c == '\f';
+  }
+
+  inline  bool  IsNameStartChar( char c )
+  {
+    return (unsigned char)c >= 0x80 || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == ':' || c == '_';
+  }
+
+  inline  bool  IsNameChar( char c )
+  {
+    return IsNameStartChar( c ) || (c >= '0' && c <= '9') || c == '.' || c == '-';
+  }
+
+  // Parser implementation
+
+  Parser::~Parser()
+  {
+    auto  charge = stats::Stage( ParseStats::adapter );
+
+    while ( !nested.empty() )
+      nested.pop_back();
+  }
+
+  void  Parser::Load( IText* text )
+  {
+    auto  xmlorg = xmlptr;
+
+    if ( xmlend - xmlptr >= 3 && memcmp( xmlptr, "\xef\xbb\xbf", 3 ) == 0 )
+      xmlptr = xmlorg += 3;
+
+    if ( Skip(), xmlptr == xmlend )
+      throw Fail( "document is empty" );
+
+    for ( auto txtorg = (xmlptr = xmlorg); Skip(), xmlptr != xmlend; txtorg = xmlptr )
+    {
+      auto  output = nested.empty() ? text : nested.back().output.ptr();
+      auto  txtend = (const char*)nullptr;
+
+    // text node: whitespace-only text is skipped, other keeps the leading spaces
+      if ( *xmlptr != '<' )
+      {
+        if ( (txtend = (const char*)memchr( xmlptr, '<', xmlend - xmlptr )) == nullptr )
+          throw Fail( nested.empty() ? "text outside the root element" : "unexpected end of text" );
+
+        if ( output != nullptr )
+          AddText( output, Copy( txtorg, txtend, true ) );
+
+        isHead = false;
+        xmlptr = txtend;
+        continue;
+      }
+
+    // declaration: '<?' ... '?>'
+      if ( Look( "<?" ) )
+      {
+        if ( !isHead || !nested.empty() )
+          throw Fail( "declaration is allowed only at the document start" );
+
+        if ( (txtend = Find( "?>" )) == nullptr )
+          throw Fail( "unterminated declaration" );
+
+        Decl( Copy( xmlptr + 2, txtend, false ) );
+          xmlptr = txtend + 2;
+        continue;
+      }
+
+      isHead = false;
+
+    // comment: '<!--' ... '-->'
+      if ( Look( "<!--" ) )
+      {
+        if ( (txtend = Find( "-->" )) == nullptr )
+          throw Fail( "unterminated comment" );
+        xmlptr = txtend + 3;
+        continue;
+      }
+
+    // cdata: '<![CDATA[' ... ']]>'
+      if ( Look( "<![CDATA[" ) )
+      {
+        if ( (txtend = Find( "]]>" )) == nullptr )
+          throw Fail( "unterminated CDATA section" );
+
+        if ( output != nullptr )
+          AddText( output, Copy( xmlptr + 9, txtend, false ) );
+
+        xmlptr = txtend + 3;
+        continue;
+      }
+
+    // doctype and other unknown nodes: '<!' ... '>'
+      if ( Look( "<!" ) )
+      {
+        if ( (txtend = Find( ">" )) == nullptr )
+          throw Fail( "unterminated node" );
+        xmlptr = txtend + 1;
+        continue;
+      }
+
+      if ( Look( "</" ) ) Tail();
+        else Elem( output );
+    }
+
+    if ( !nested.empty() )
+    {
+      throw Fail( mtc::strprintf( "element '%s' is not closed",
+        std::string( nested.back().tagKey ).c_str() ).c_str() );
+    }
+  }
+
+  void  Parser::Decl( const std::string_view& dcl )
   {
-    auto  decmap = Decl( dcl );
+    auto  decmap = Args( std::string( dcl ).c_str() );
     auto  encode = decmap.find( "encoding" );
 
     if ( encode != decmap.end() )
@@ -53,53 +207,114 @@ namespace DeliriX
         else
       throw Error( mtc::strprintf( "invalid encoding '%s' @" __FILE__ ":" LINE_STRING, encode->second.c_str() ) );
     }
-    return text;
   }
 
-  auto  Parser::Elem( IText* text, const tinyxml2::XMLElement& elem ) -> IText*
+  /*
+    Elem( output )
+
+    Reads the opening tag with attributes and creates the markup tag in the
+    current output; if the output rejects the tag (or the tag is inside the
+    rejected one), the element body is still parsed, but nothing is passed.
+  */
+  void  Parser::Elem( IText* output )
   {
-    if ( elem.Value() != nullptr )
+    auto  attrib = IText::markup_attribute();
+    auto  tagKey = std::string_view();
+    auto  closed = false;
+
+    ++xmlptr;
+
+    if ( (tagKey = Name()).empty() )
+      throw Fail( "invalid element name" );
+
+  // get provided attributes for tag
+    for ( ; ; )
     {
-      auto  attrib = IText::markup_attribute();
-      auto  addtag = mtc::api<IText>();
+      if ( Skip(), xmlptr == xmlend )
+        throw Fail( "unexpected end of element" );
 
-    // get provided attributes for tag
-      for ( auto attr = elem.FirstAttribute(); attr != nullptr; attr = attr->Next() )
-        attrib.emplace( attr->Name(), attr->Value() );
+      if ( IsNameStartChar( *xmlptr ) )
+      {
+        auto  attkey = Name();
+        auto  valend = (const char*)nullptr;
+        char  quotes[2] = { 0, 0 };
 
-    // try add tag and add elements if the tag is added
-      if ( (addtag = text->AddMarkupTag( elem.Value(), attrib )) != nullptr )
-        for ( auto next = elem.FirstChild(); next != nullptr; next = next->NextSibling() )
-          Load( addtag, *next );
+        if ( Skip(), xmlptr == xmlend || *xmlptr++ != '=' )
+          throw Fail( "'=' expected" );
+
+        if ( Skip(), xmlptr == xmlend || (*xmlptr != '\"' && *xmlptr != '\'') )
+          throw Fail( "quoted attribute value expected" );
+
+        quotes[0] = *xmlptr++;
+
+        if ( (valend = Find( quotes )) == nullptr )
+          throw Fail( "unterminated attribute value" );
+
+        attrib.emplace( attkey, Copy( xmlptr, valend, true ) );
+          xmlptr = valend + 1;
+      }
+        else
+      if ( *xmlptr == '>' )
+      {
+        ++xmlptr;
+        break;
+      }
+        else
+      if ( Look( "/>" ) )
+      {
+        xmlptr += 2;
+        closed = true;
+        break;
+      }
+        else
+      throw Fail( "invalid character in element" );
     }
-    return text;
-  }
 
-  auto  Parser::List( IText* text, const tinyxml2::XMLElement& elem ) -> IText*
-  {
-    if ( elem.Value() != nullptr )
+    stats::Count( &ParseStats::elements );
+
+  // try add tag; rejected tags are skipped with all the nested elements
+    auto  addtag = mtc::api<IText>();
+
+    if ( output != nullptr )
     {
-      for ( auto next = elem.FirstChild(); next != nullptr; next = next->NextSibling() )
-        Load( text, *next );
+      auto  charge = stats::Stage( ParseStats::adapter );
+
+      addtag = output->AddMarkupTag( tagKey, attrib );
     }
-    return text;
+
+    if ( !closed )
+      nested.push_back( { std::move( addtag ), tagKey } );
   }
 
-  auto  Parser::Load( IText* text, const tinyxml2::XMLNode& node ) -> IText*
+  void  Parser::Tail()
   {
-    if ( node.ToDeclaration() != nullptr )
-      return Decl( text, node.ToDeclaration()->Value() );
+    std::string_view  tagKey;
+
+    xmlptr += 2;
+
+    if ( (tagKey = Name()).empty() )
+      throw Fail( "invalid closing element name" );
+
+    if ( Skip(), xmlptr == xmlend || *xmlptr++ != '>' )
+      throw Fail( "'>' expected" );
 
-    if ( node.ToElement() != nullptr )
-      return Elem( text, *node.ToElement() );
+    if ( nested.empty() || nested.back().tagKey != tagKey )
+      throw Fail( mtc::strprintf( "mismatched closing element '%s'", std::string( tagKey ).c_str() ).c_str() );
 
-    if ( node.ToText() != nullptr && node.ToText()->Value() != nullptr )
-      text->AddBlock( encode, node.ToText()->Value() );
+  // the adapters may output the text collected when released
+    auto  charge = stats::Stage( ParseStats::adapter );
+
+    nested.pop_back();
+  }
+
+  void  Parser::AddText( IText* output, const std::string_view& str )
+  {
+    auto  charge = stats::Stage( ParseStats::adapter );
 
-    return text;
+    output->AddBlock( encode, str );
   }
 
-  auto  Parser::Decl( const char* decl ) const -> std::map<std::string, std::string>
+  auto  Parser::Args( const char* decl ) const -> std::map<std::string, std::string>
   {
     auto  outmap = std::map<std::string, std::string>();
 
@@ -132,23 +347,177 @@ namespace DeliriX
     return outmap;
   }
 
-  int   ParseXML( IText* text, const mtc::api<const mtc::IByteBuffer>& buff )
+  auto  Parser::Name() -> std::string_view
   {
-    Parser                load;
-    tinyxml2::XMLDocument xdoc;
-    tinyxml2::XMLError    xres;
+    auto  keyorg = xmlptr;
 
-    if ( buff == nullptr )
-      throw std::invalid_argument( "XML source is null @" __FILE__ ":" LINE_STRING );
+    if ( xmlptr != xmlend && IsNameStartChar( *xmlptr ) )
+      for ( ++xmlptr; xmlptr != xmlend && IsNameChar( *xmlptr ); ++xmlptr )
+        (void)NULL;
 
-    if ( (xres = xdoc.Parse( buff->GetPtr(), buff->GetLen() )) != tinyxml2::XML_SUCCESS )
+    return { keyorg, size_t(xmlptr - keyorg) };
+  }
+
+  auto  Parser::Find( const char* pattern ) const -> const char*
+  {
+    auto  patlen = strlen( pattern );
+
+    for ( auto ptr = xmlptr; xmlend - ptr >= ptrdiff_t(patlen); ++ptr )
     {
-      throw Error( mtc::strprintf( "failed to parse XML, error '%s' @" __FILE__ ":" LINE_STRING,
-        xdoc.ErrorStr() ) );
+      if ( (ptr = (const char*)memchr( ptr, *pattern, xmlend - ptr )) == nullptr )
+        break;
+      if ( xmlend - ptr >= ptrdiff_t(patlen) && memcmp( ptr, pattern, patlen ) == 0 )
+        return ptr;
     }
+    return nullptr;
+  }
+
+  /*
+    Copy( org, end, entities )
+
+    Returns the source fragment with newlines normalized and, optionally,
+    character entities expanded; fragments that need no changes are returned
+    as is, other ones are decoded into the internal reusable buffer.
+  */
+  auto  Parser::Copy( const char* org, const char* end, bool entities ) -> std::string_view
+  {
+    static const std::initializer_list<std::pair<std::string_view, char>> predefined = {
+      { "quot", '\"' },
+      { "amp",  '&' },
+      { "apos", '\'' },
+      { "lt",   '<' },
+      { "gt",   '>' } };
+    auto  ptr = org;
+
+    while ( ptr != end && *ptr != '\r' && !(*ptr == '\n' && ptr + 1 != end && ptr[1] == '\r') && !(entities && *ptr == '&') )
+      ++ptr;
+
+    if ( ptr == end )
+      return { org, size_t(end - org) };
+
+    for ( buffer.assign( org, ptr ); ptr != end; )
+    {
+      if ( *ptr == '\r' || *ptr == '\n' )
+      {
+        ptr += ptr + 1 != end && (ptr[1] == '\r' || ptr[1] == '\n') && ptr[1] != ptr[0] ? 2 : 1;
+        buffer += '\n';
+      }
+        else
+      if ( entities && *ptr == '&' && ptr + 1 != end && ptr[1] == '#' )
+      {
+        auto      semptr = (const char*)memchr( ptr, ';', end - ptr );
+        auto      numptr = ptr + 2;
+        auto      radix = 10;
+        uint32_t  ucchar = 0;
+
+        if ( numptr != end && *numptr == 'x' )
+          ++numptr, radix = 16;
+
+        for ( ; semptr != nullptr && numptr != semptr; ++numptr )
+        {
+          if ( *numptr >= '0' && *numptr <= '9' ) ucchar = ucchar * radix + *numptr - '0';
+            else
+          if ( radix == 16 && *numptr >= 'a' && *numptr <= 'f' ) ucchar = ucchar * radix + *numptr - 'a' + 10;
+            else
+          if ( radix == 16 && *numptr >= 'A' && *numptr <= 'F' ) ucchar = ucchar * radix + *numptr - 'A' + 10;
+            else
+          break;
+
+          if ( ucchar > 0x10ffff )
+            break;
+        }
+
+        if ( semptr == nullptr || numptr != semptr || semptr == ptr + 2 + (radix == 16) )
+        {
+          buffer += *ptr++;
+          continue;
+        }
+
+      // the surrogates are not the characters and have no valid utf-8 form
+        if ( ucchar >= 0xd800 && ucchar <= 0xdfff )
+          ucchar = 0xfffd;
+
+        if ( ucchar < 0x80 )
+        {
+          buffer += char(ucchar);
+        }
+          else
+        if ( ucchar < 0x800 )
+        {
+          buffer += char(0xc0 | (ucchar >> 6));
+          buffer += char(0x80 | (ucchar & 0x3f));
+        }
+          else
+        if ( ucchar < 0x10000 )
+        {
+          buffer += char(0xe0 | (ucchar >> 12));
+          buffer += char(0x80 | ((ucchar >> 6) & 0x3f));
+          buffer += char(0x80 | (ucchar & 0x3f));
+        }
+          else
+        {
+          buffer += char(0xf0 | (ucchar >> 18));
+          buffer += char(0x80 | ((ucchar >> 12) & 0x3f));
+          buffer += char(0x80 | ((ucchar >> 6) & 0x3f));
+          buffer += char(0x80 | (ucchar & 0x3f));
+        }
+        ptr = semptr + 1;
+      }
+        else
+      if ( entities && *ptr == '&' )
+      {
+        auto  entity = predefined.begin();
+
+        for ( ; entity != predefined.end(); ++entity )
+        {
+          auto  enterm = ptr + 1 + entity->first.length();
+
+          if ( enterm < end && *enterm == ';' && std::string_view( ptr + 1, entity->first.length() ) == entity->first )
+            break;
+        }
+
+        if ( entity != predefined.end() )
+        {
+          buffer += entity->second;
+          ptr += entity->first.length() + 2;
+        } else buffer += *ptr++;
+      }
+        else
+      buffer += *ptr++;
+    }
+    return buffer;
+  }
+
+  void  Parser::Skip()
+  {
+    while ( xmlptr != xmlend && IsSpace( *xmlptr ) )
+      ++xmlptr;
+  }
+
+  bool  Parser::Look( const char* pattern ) const
+  {
+    auto  patlen = strlen( pattern );
+
+    return size_t(xmlend - xmlptr) >= patlen && memcmp( xmlptr, pattern, patlen ) == 0;
+  }
+
+  auto  Parser::Fail( const char* msg ) const -> Error
+  {
+    return Error( mtc::strprintf( "failed to parse XML, error '%s' at offset %u @" __FILE__ ":" LINE_STRING,
+      msg, unsigned(xmlptr - xmltop) ) );
+  }
+
+  int   ParseXML( IText* text, const mtc::api<const mtc::IByteBuffer>& buff, ParseStats* pstats )
+  {
+    auto  scope = stats::Scope( pstats, buff.ptr() );
+
+    if ( buff == nullptr )
+      throw std::invalid_argument( "XML source is null @" __FILE__ ":" LINE_STRING );
+
+    auto  charge = stats::Stage( ParseStats::xml );
+    auto  traced = trace::Span( "xml parse", buff->GetLen() );
 
-    for ( auto child = xdoc.FirstChild(); child != nullptr; child = child->NextSibling() )
-      load.Load( text, *child );
+    Parser( buff->GetPtr(), buff->GetLen() ).Load( scope.Output( text ) );
 
     return 0;
   }
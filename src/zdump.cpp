@@ -0,0 +1,698 @@
+# include "../DOM-zdump.hpp"
+# include "../DOM-text.hpp"
+# include "../formats.hpp"
+# include "../compat.hpp"
+# include "dump-v2.hpp"
+# include "trace-scope.hpp"
+# include <mtc/byteBuffer.h>
+# include <mtc/wcsstr.h>
+# include <zlib.h>
+# include <algorithm>
+# include <stdexcept>
+# include <unordered_map>
+# include <unordered_set>
+# include <queue>
+# include <mutex>
+
+namespace DeliriX {
+namespace zdump {
+
+  /*
+    The compressed dump layout following the signature and the payload size:
+
+      dictionary id (0 for none), text chunks count;
+      raw and packed sizes of the head, the tail and each text chunk;
+      blocks count of each text chunk;
+      the packed head, tail and text chunks.
+
+    The head and the tail are the v2 dump parts, the text chunks hold the
+    text of whole blocks.
+  */
+  struct Reader::Chunk
+  {
+    size_t      nblock = 0;
+    size_t      rawlen;
+    size_t      length;
+    const char* packed;
+    size_t      origin = 0;   // the first block
+  };
+
+  struct Layout
+  {
+    using Chunk = Reader::Chunk;
+
+    uint32_t            dictid;
+    Chunk               head;
+    Chunk               tail;
+    std::vector<Chunk>  text;
+
+    bool  Load( const char*, size_t );
+  };
+
+  class Deflater
+  {
+    z_stream        zstream = {};
+    const Options&  options;
+
+  public:
+    Deflater( const Options& );
+   ~Deflater()  {  deflateEnd( &zstream );  }
+
+    auto  Pack( const char*, size_t ) -> std::string;
+    auto  Bound( size_t ) -> size_t;
+  };
+
+  class Inflater
+  {
+    z_stream  zstream = {};
+
+  public:
+    Inflater();
+   ~Inflater()  {  inflateEnd( &zstream );  }
+
+    bool  Unpack( char*, const Layout::Chunk& );
+  };
+
+  // dictionaries registry
+
+  static  std::mutex                                                      dictLock;
+  static  std::unordered_map<uint32_t, mtc::api<const mtc::IByteBuffer>>  dictList;
+
+  static  auto  GetDictId( const mtc::api<const mtc::IByteBuffer>& dict ) -> uint32_t
+  {
+    return uint32_t(adler32( adler32( 0, nullptr, 0 ), (const Bytef*)dict->GetPtr(), uInt(dict->GetLen()) ));
+  }
+
+  static  auto  GetDictionary( uint32_t dictid ) -> mtc::api<const mtc::IByteBuffer>
+  {
+    auto  exlock = std::unique_lock<std::mutex>( dictLock );
+    auto  pfound = dictList.find( dictid );
+
+    return pfound != dictList.end() ? pfound->second : nullptr;
+  }
+
+  // Layout implementation
+
+  bool  Layout::Load( const char* ptr, size_t len )
+  {
+    auto  source = DumpSource{ ptr, ptr + len };
+    auto  srcptr = &source;
+    auto  ntexts = size_t(0);
+
+    if ( (srcptr = ::FetchFrom( ::FetchFrom( srcptr, dictid ), ntexts )) == nullptr || ntexts > len )
+      return false;
+
+    text.resize( ntexts );
+
+    for ( auto chunk: { &head, &tail } )
+      if ( (srcptr = ::FetchFrom( ::FetchFrom( srcptr, chunk->rawlen ), chunk->length )) == nullptr )
+        return false;
+
+    for ( auto& chunk: text )
+      if ( (srcptr = ::FetchFrom( ::FetchFrom( srcptr, chunk.rawlen ), chunk.length )) == nullptr )
+        return false;
+
+    for ( auto& chunk: text )
+      if ( (srcptr = ::FetchFrom( srcptr, chunk.nblock )) == nullptr )
+        return false;
+
+  // locate the packed chunks; deflate never packs better than 1:1032
+    for ( auto chunk: { &head, &tail } )
+    {
+      if ( (chunk->packed = source.ptr, srcptr = srcptr->Skip( chunk->length )) == nullptr || chunk->rawlen / 1032 > chunk->length )
+        return false;
+    }
+
+    for ( auto& chunk: text )
+    {
+      if ( (chunk.packed = source.ptr, srcptr = srcptr->Skip( chunk.length )) == nullptr || chunk.rawlen / 1032 > chunk.length )
+        return false;
+    }
+
+    return true;
+  }
+
+  // Deflater implementation
+
+  Deflater::Deflater( const Options& opts ): options( opts )
+  {
+    if ( deflateInit( &zstream, options.level ) != Z_OK )
+      throw Error( "zdump: deflateInit failed @" __FILE__ ":" LINE_STRING );
+  }
+
+  auto  Deflater::Pack( const char* src, size_t len ) -> std::string
+  {
+    auto  output = std::string();
+
+    deflateReset( &zstream );
+
+    if ( options.dictionary != nullptr )
+      deflateSetDictionary( &zstream, (const Bytef*)options.dictionary->GetPtr(), uInt(options.dictionary->GetLen()) );
+
+    output.resize( deflateBound( &zstream, uLong(len) ) );
+
+    zstream.next_in = (Bytef*)src;
+    zstream.avail_in = uInt(len);
+    zstream.next_out = (Bytef*)output.data();
+    zstream.avail_out = uInt(output.size());
+
+    if ( deflate( &zstream, Z_FINISH ) != Z_STREAM_END )
+      throw Error( "zdump: deflate failed @" __FILE__ ":" LINE_STRING );
+
+    return output.resize( zstream.total_out ), output;
+  }
+
+  auto  Deflater::Bound( size_t len ) -> size_t
+  {
+    return deflateBound( &zstream, uLong(len) ) + (options.dictionary != nullptr ? 4 : 0);
+  }
+
+  // Inflater implementation
+
+  Inflater::Inflater()
+  {
+    if ( inflateInit( &zstream ) != Z_OK )
+      throw Error( "zdump: inflateInit failed @" __FILE__ ":" LINE_STRING );
+  }
+
+  bool  Inflater::Unpack( char* output, const Layout::Chunk& chunk )
+  {
+    int   nerror;
+
+    inflateReset( &zstream );
+
+    zstream.next_in = (Bytef*)chunk.packed;
+    zstream.avail_in = uInt(chunk.length);
+    zstream.next_out = (Bytef*)output;
+    zstream.avail_out = uInt(chunk.rawlen);
+
+    if ( (nerror = inflate( &zstream, Z_FINISH )) == Z_NEED_DICT )
+    {
+      auto  dict = GetDictionary( uint32_t(zstream.adler) );
+
+      if ( dict == nullptr )
+      {
+        throw Error( mtc::strprintf( "zdump: unknown dictionary %08x @" __FILE__ ":" LINE_STRING,
+          unsigned(zstream.adler) ) );
+      }
+
+      if ( inflateSetDictionary( &zstream, (const Bytef*)dict->GetPtr(), uInt(dict->GetLen()) ) != Z_OK )
+        return false;
+
+      nerror = inflate( &zstream, Z_FINISH );
+    }
+
+    return nerror == Z_STREAM_END && zstream.total_out == chunk.rawlen;
+  }
+
+  // public functions
+
+  auto  AddDictionary( const mtc::api<const mtc::IByteBuffer>& dict ) -> uint32_t
+  {
+    uint32_t  dictid;
+
+    if ( dict == nullptr || dict->GetLen() == 0 )
+      throw std::invalid_argument( "zdump::AddDictionary dictionary is empty" );
+
+    dictid = GetDictId( dict );
+
+    auto  exlock = std::unique_lock<std::mutex>( dictLock );
+
+    return dictList.emplace( dictid, dict ), dictid;
+  }
+
+  /*
+    Serialize( fns, text, options )
+
+    Packs the head, the tail and the text chunks separately, then writes the
+    chunks table and the packed chunks; the dump is kept packed in memory
+    until the payload size is known.
+  */
+  bool  Serialize( std::function<bool( const void*, size_t )> fns, const ITextView& text, const Options& options )
+  {
+    auto  traced = trace::Span( "zdump" );
+    auto  zipper = Deflater( options );
+    auto  column = ColumnBuf();
+    auto  packed = std::vector<std::string>();
+    auto  rawlen = std::vector<size_t>();
+    auto  nblock = std::vector<size_t>();
+    auto  rawbuf = std::string();
+    auto  header = ColumnBuf();
+    auto  output = &fns;
+    auto  cbdump = size_t(0);
+
+  // the head and the tail
+    dump_v2::PutHead( column, text );
+      packed.push_back( zipper.Pack( column.data(), column.size() ) );
+      rawlen.push_back( column.size() );
+    column.clear();
+
+    dump_v2::PutTail( column, text );
+      packed.push_back( zipper.Pack( column.data(), column.size() ) );
+      rawlen.push_back( column.size() );
+
+  // the text chunks of whole blocks
+    nblock.push_back( 0 );
+
+    for ( auto& str: text.GetBlocks() )
+    {
+      auto  bytes = dump_v2::GetBytes( str );
+
+      rawbuf.append( bytes.data(), bytes.size() );
+        ++nblock.back();
+
+      if ( rawbuf.size() >= options.chunkSize )
+      {
+        packed.push_back( zipper.Pack( rawbuf.data(), rawbuf.size() ) );
+        rawlen.push_back( rawbuf.size() );
+        nblock.push_back( 0 );
+        rawbuf.clear();
+      }
+    }
+
+    if ( nblock.back() != 0 )
+    {
+      packed.push_back( zipper.Pack( rawbuf.data(), rawbuf.size() ) );
+      rawlen.push_back( rawbuf.size() );
+    }
+      else
+    nblock.pop_back();
+
+  // the chunks table
+    ::Serialize( ::Serialize( &header,
+      options.dictionary != nullptr ? GetDictId( options.dictionary ) : 0U ),
+      nblock.size() );
+
+    for ( size_t i = 0; i != packed.size(); ++i )
+      ::Serialize( ::Serialize( &header, rawlen[i] ), packed[i].size() );
+
+    for ( auto count: nblock )
+      ::Serialize( &header, count );
+
+    for ( auto& chunk: packed )
+      cbdump += chunk.size();
+
+  // the signature, the payload size and the payload
+    column.clear();
+
+    ::Serialize( ::Serialize( ::Serialize( ::Serialize( &column,
+      size_t(0) ),
+      ITextView::v2signature ),
+      unsigned(ITextView::dump_z) ),
+      header.size() + cbdump );
+
+    if ( (output = ::Serialize( ::Serialize( output, column.data(), column.size() ), header.data(), header.size() )) == nullptr )
+      return false;
+
+    for ( auto& chunk: packed )
+      if ( (output = ::Serialize( output, chunk.data(), chunk.size() )) == nullptr )
+        return false;
+
+    return true;
+  }
+
+  /*
+    GetBufLen( text, options )
+
+    Sums the deflateBound() of the chunks cut as Serialize() does and the
+    chunks table with the bounds for the packed sizes, so the text is
+    serialized to the columns, but never deflated.
+  */
+  auto  GetBufLen( const ITextView& text, const Options& options ) -> size_t
+  {
+    auto  zipper = Deflater( options );
+    auto  column = ColumnBuf();
+    auto  rawlen = std::vector<size_t>();
+    auto  nblock = std::vector<size_t>{ 0 };
+    auto  cbtext = size_t(0);
+    auto  header = size_t(0);
+    auto  cbdump = size_t(0);
+
+    dump_v2::PutHead( column, text );
+      rawlen.push_back( column.size() );
+    column.clear();
+
+    dump_v2::PutTail( column, text );
+      rawlen.push_back( column.size() );
+
+    for ( auto& str: text.GetBlocks() )
+    {
+      cbtext += dump_v2::GetBytes( str ).size();
+        ++nblock.back();
+
+      if ( cbtext >= options.chunkSize )
+      {
+        rawlen.push_back( cbtext );
+        nblock.push_back( 0 );
+        cbtext = 0;
+      }
+    }
+
+    if ( nblock.back() != 0 )
+      rawlen.push_back( cbtext );
+        else
+    nblock.pop_back();
+
+    header = ::GetBufLen( options.dictionary != nullptr ? GetDictId( options.dictionary ) : 0U )
+           + ::GetBufLen( nblock.size() );
+
+    for ( auto length: rawlen )
+    {
+      auto  packed = zipper.Bound( length );
+
+      header += ::GetBufLen( length ) + ::GetBufLen( packed );
+      cbdump += packed;
+    }
+
+    for ( auto count: nblock )
+      header += ::GetBufLen( count );
+
+    return ::GetBufLen( size_t(0) ) + ::GetBufLen( ITextView::v2signature )
+         + ::GetBufLen( unsigned(ITextView::dump_z) ) + ::GetBufLen( header + cbdump )
+         + header + cbdump;
+  }
+
+  /*
+    Train( samples, maxSize )
+
+    The simplified cover algorithm: the 8-byte sequences are counted once
+    per sample dump, the fixed size segments of the dumps are scored by the
+    counts of the sequences occurring in more than one sample, and the best
+    segments are picked greedily with the sequences already covered scored
+    no more. The best segments go to the dictionary end, where zlib finds
+    them at the shortest distances.
+  */
+  auto  Train( const std::vector<mtc::api<const ITextView>>& samples, size_t maxSize ) -> mtc::api<const mtc::IByteBuffer>
+  {
+    constexpr size_t  gramLen = 8;
+    constexpr size_t  segLen = 0x40;
+
+    struct Segment
+    {
+      size_t  score;
+      size_t  sample;
+      size_t  offset;
+
+      bool  operator < ( const Segment& s ) const {  return score < s.score;  }
+    };
+
+    auto  corpus = std::vector<ColumnBuf>( samples.size() );
+    auto  counts = std::unordered_map<uint64_t, uint32_t>();
+    auto  scored = std::priority_queue<Segment>();
+    auto  chosen = std::vector<Segment>();
+    auto  output = std::string();
+
+    auto  GetGram = []( const char* p ){  uint64_t g;  return memcpy( &g, p, sizeof(g) ), g;  };
+    auto  GetScore = [&]( const Segment& seg )
+    {
+      auto& sample = corpus[seg.sample];
+      auto  ending = std::min( seg.offset + segLen, sample.size() ) - gramLen + 1;
+      auto  nscore = size_t(0);
+
+      for ( auto offset = seg.offset; offset < ending; ++offset )
+      {
+        auto  pfound = counts.find( GetGram( sample.data() + offset ) );
+
+        if ( pfound != counts.end() && pfound->second > 1 )
+          nscore += pfound->second;
+      }
+      return nscore;
+    };
+
+  // get the sample dumps and count the sequences
+    for ( size_t i = 0; i != samples.size(); ++i )
+    {
+      auto  unique = std::unordered_set<uint64_t>();
+      auto& sample = corpus[i];
+
+      dump_v2::PutHead( sample, *samples[i] );
+
+      for ( auto& str: samples[i]->GetBlocks() )
+      {
+        auto  bytes = dump_v2::GetBytes( str );
+
+        sample.insert( sample.end(), bytes.begin(), bytes.end() );
+      }
+
+      dump_v2::PutTail( sample, *samples[i] );
+
+      for ( size_t offset = 0; offset + gramLen <= sample.size(); ++offset )
+        if ( unique.insert( GetGram( sample.data() + offset ) ).second )
+          ++counts[GetGram( sample.data() + offset )];
+    }
+
+  // score the segments
+    for ( size_t i = 0; i != corpus.size(); ++i )
+      for ( size_t offset = 0; offset + gramLen <= corpus[i].size(); offset += segLen )
+      {
+        auto  segment = Segment{ 0, i, offset };
+
+        if ( (segment.score = GetScore( segment )) != 0 )
+          scored.push( segment );
+      }
+
+  // pick the segments rescoring the ones left
+    for ( auto length = size_t(0); length < maxSize && !scored.empty(); )
+    {
+      auto  segment = scored.top();
+
+      scored.pop();
+
+      if ( (segment.score = GetScore( segment )) == 0 )
+        continue;
+
+      if ( !scored.empty() && segment.score < scored.top().score )
+      {
+        scored.push( segment );
+        continue;
+      }
+
+      for ( auto offset = segment.offset; offset + gramLen <= std::min( segment.offset + segLen, corpus[segment.sample].size() ); ++offset )
+        counts.erase( GetGram( corpus[segment.sample].data() + offset ) );
+
+      chosen.push_back( segment );
+        length += std::min( segLen, corpus[segment.sample].size() - segment.offset );
+    }
+
+    for ( auto it = chosen.rbegin(); it != chosen.rend(); ++it )
+    {
+      auto& sample = corpus[it->sample];
+
+      output.append( sample.data() + it->offset, std::min( segLen, sample.size() - it->offset ) );
+    }
+
+    if ( output.size() > maxSize )
+      output.erase( 0, output.size() - maxSize );
+
+    return mtc::CreateByteBuffer( output.data(), output.size() ).ptr();
+  }
+
+  // Reader implementation
+
+  Reader::Reader( const mtc::api<const mtc::IByteBuffer>& src ): buffer( src )
+  {
+    auto  source = DumpSource{};
+    auto  srcptr = &source;
+    auto  layout = Layout();
+    auto  unpack = Inflater();
+    auto  rawbuf = std::string();
+    auto  origin = size_t(0);
+    size_t    zeroes;
+    size_t    signature;
+    unsigned  version;
+    size_t    cbdump;
+
+    if ( buffer == nullptr )
+      throw std::invalid_argument( "zdump::Reader source buffer is empty" );
+
+    source = DumpSource{ buffer->GetPtr(), buffer->GetPtr() + buffer->GetLen() };
+
+    srcptr = ::FetchFrom( ::FetchFrom( ::FetchFrom( ::FetchFrom( srcptr,
+      zeroes ),
+      signature ),
+      version ),
+      cbdump );
+
+    if ( srcptr == nullptr || zeroes != 0 || signature != ITextView::v2signature || version != ITextView::dump_z )
+      throw std::invalid_argument( "zdump::Reader source is not the compressed dump" );
+
+    if ( cbdump > size_t(source.end - source.ptr) || !layout.Load( source.ptr, cbdump ) )
+      throw Error( "zdump::Reader invalid chunks table @" __FILE__ ":" LINE_STRING );
+
+  // the blocks columns
+    rawbuf.resize( layout.head.rawlen );
+
+    if ( unpack.Unpack( (char*)rawbuf.data(), layout.head ) )
+    {
+      auto  columns = std::vector<uint32_t>();
+
+      source = DumpSource{ rawbuf.data(), rawbuf.data() + rawbuf.size() };
+
+      if ( (srcptr = dump_v2::GetHead( &source, columns, cbdump )) != nullptr )
+      {
+        blocks.resize( cbdump );
+
+        for ( size_t i = 0; i != cbdump; ++i )
+          blocks[i] = { columns[i] - 1, columns[cbdump + i] };
+      }
+    }
+      else
+    srcptr = nullptr;
+
+    if ( srcptr == nullptr )
+      throw Error( "zdump::Reader invalid blocks columns @" __FILE__ ":" LINE_STRING );
+
+  // the text chunks have to cover the blocks exactly, each chunk the text of its blocks
+    for ( auto& chunk: layout.text )
+    {
+      auto  cbtext = size_t(0);
+
+      if ( chunk.nblock > blocks.size() - origin )
+        throw Error( "zdump::Reader text chunks do not match the blocks @" __FILE__ ":" LINE_STRING );
+
+      chunk.origin = origin;
+      origin += chunk.nblock;
+
+      for ( auto i = chunk.origin; i != origin; ++i )
+        cbtext += (blocks[i].encode == uint32_t(-1) ? sizeof(widechar) : 1) * size_t(blocks[i].length);
+
+      if ( cbtext != chunk.rawlen )
+        throw Error( "zdump::Reader text chunks do not match the blocks @" __FILE__ ":" LINE_STRING );
+    }
+
+    if ( origin != blocks.size() )
+      throw Error( "zdump::Reader text chunks do not match the blocks @" __FILE__ ":" LINE_STRING );
+
+    for ( auto& next: blocks )
+      length += next.length;
+
+  // the markup is read from the v2 dump tail by the shared readers
+    rawbuf.resize( layout.tail.rawlen );
+
+    if ( unpack.Unpack( (char*)rawbuf.data(), layout.tail ) )
+    {
+      auto      source = DumpSource{ (const char*)rawbuf.data(), (const char*)rawbuf.data() + rawbuf.size() };
+      auto      srcptr = &source;
+      auto      tagKeys = std::vector<TagKey>();
+      uint32_t  cchdoc;
+
+      if ( (srcptr = dump_v2::GetTagKeys( srcptr, tagKeys )) != nullptr )
+        srcptr = dump_v2::GetMarkup( srcptr, tagKeys, markup );
+
+      if ( ::FetchFrom( srcptr, cchdoc ) != nullptr && cchdoc == length )
+      {
+        chunks = std::move( layout.text );
+        return;
+      }
+    }
+    throw Error( "zdump::Reader invalid markup @" __FILE__ ":" LINE_STRING );
+  }
+
+  Reader::~Reader()
+  {
+  }
+
+  auto  Reader::GetBlocks( size_t first, size_t count ) const -> std::vector<Paragraph>
+  {
+    auto  output = std::vector<Paragraph>();
+    auto  unpack = Inflater();
+    auto  rawbuf = std::string();
+    auto  ending = first + std::min( count, blocks.size() - std::min( first, blocks.size() ) );
+    auto  pchunk = std::upper_bound( chunks.begin(), chunks.end(), first,
+      []( size_t index, const Chunk& chunk ){  return index < chunk.origin;  } );
+
+    if ( first >= ending )
+      return output;
+
+    output.reserve( ending - first );
+
+    for ( --pchunk; pchunk != chunks.end() && pchunk->origin < ending; ++pchunk )
+    {
+      auto  srcptr = (const char*)nullptr;
+
+      rawbuf.resize( pchunk->rawlen );
+
+      if ( !unpack.Unpack( (char*)(srcptr = rawbuf.data()), *pchunk ) )
+        throw Error( "zdump::Reader invalid text chunk @" __FILE__ ":" LINE_STRING );
+
+      for ( auto i = pchunk->origin; i != pchunk->origin + pchunk->nblock && i < ending; ++i )
+      {
+        auto& block = blocks[i];
+        auto  cbtext = (block.encode == uint32_t(-1) ? sizeof(widechar) : 1) * block.length;
+
+        if ( i >= first )
+        {
+          output.emplace_back().FetchFrom( block.encode, block.length, [&]( void* p, size_t l )
+            {  return memcpy( p, srcptr, l ), true;  } );
+        }
+        srcptr += cbtext;
+      }
+    }
+
+    return output;
+  }
+
+}}
+
+// Text compressed dump support
+
+namespace DeliriX {
+
+  bool  ITextView::SerializeZ( std::function<bool( const void*, size_t )> fns ) const
+  {
+    return zdump::Serialize( std::move( fns ), *this );
+  }
+
+  auto  ITextView::GetBufLenZ() const -> size_t
+  {
+    return zdump::GetBufLen( *this );
+  }
+
+  /*
+    FetchZ( payload, size )
+
+    Inflates the compressed dump to the v2 one and loads it.
+  */
+  bool  Text::FetchZ( const char* ptr, size_t len )
+  {
+    auto  layout = zdump::Layout();
+    auto  unpack = zdump::Inflater();
+    auto  v2dump = ColumnBuf();
+    auto  cbdump = size_t(0);
+
+    if ( !layout.Load( ptr, len ) )
+      return false;
+
+    for ( auto& chunk: layout.text )
+      cbdump += chunk.rawlen;
+
+    ::Serialize( ::Serialize( ::Serialize( &v2dump,
+      size_t(0) ),
+      v2signature ),
+      unsigned(dump_v2) );
+
+    v2dump.reserve( v2dump.size() + layout.head.rawlen + cbdump + layout.tail.rawlen );
+
+    auto  Append = [&]( const zdump::Layout::Chunk& chunk )
+    {
+      auto  offset = v2dump.size();
+
+      v2dump.resize( offset + chunk.rawlen );
+
+      return unpack.Unpack( v2dump.data() + offset, chunk );
+    };
+
+    if ( !Append( layout.head ) )
+      return false;
+
+    for ( auto& chunk: layout.text )
+      if ( !Append( chunk ) )
+        return false;
+
+    if ( !Append( layout.tail ) )
+      return false;
+
+    return FetchFrom( mtc::sourcebuf( v2dump.data(), v2dump.size() ).ptr() ) != nullptr;
+  }
+
+}
@@ -1,18 +1,38 @@
 # include "../archive.hpp"
+# include "stats-scope.hpp"
+# include "trace-scope.hpp"
 # include <minizip/unzip.h>
+# include <algorithm>
 # include <stdexcept>
 # include <cstring>
+# include <cstdlib>
+# include <mutex>
+# include <unordered_map>
 # include <vector>
 
 namespace DeliriX {
 
   class ZipArchive final: public IArchive
   {
-    mtc::api<const mtc::IByteBuffer>  buffer;
-    unzFile                           zipped;
-    bool                              inRead = false;
+    struct Entry
+    {
+      std::string     name;
+      unz_file_info64 info;
+      unz64_file_pos  fpos;
+    };
+
+    mtc::api<const mtc::IByteBuffer>              buffer;
+    std::vector<Entry>                            entries;
+    std::unordered_map<std::string_view, size_t>  nameMap;
+    size_t                                        dirPos = 0;
+
+  // minizip handles are stateful, so every extraction takes its own one;
+  // the spare handles are kept for reuse
+    std::mutex                                    mxlock;
+    std::vector<unzFile>                          spares;
 
     class ZipEntry;
+    class Unzip;
 
   public:
     ZipArchive( const mtc::api<const mtc::IByteBuffer>&, unzFile );
@@ -21,115 +41,311 @@ namespace DeliriX {
     auto  GetFile( const char* path ) -> mtc::api<const mtc::IByteBuffer> override;
     auto  ReadDir() -> mtc::api<IEntry> override;
 
+    auto  GetCount() const -> size_t override  {  return entries.size();  }
+    auto  GetEntry( size_t ) -> mtc::api<IEntry> override;
+    auto  FindEntry( const char* ) -> mtc::api<IEntry> override;
+
+  protected:
+    auto  GetFile( const Entry& ) -> mtc::api<const mtc::IByteBuffer>;
+
     implement_lifetime_control
   };
 
   class ZipArchive::ZipEntry final: public IEntry
   {
-    unz_file_info         fiinfo;
-    char                  szname[0x400];
+    const Entry&          zentry;
     mtc::api<ZipArchive>  parent;
 
   public:
-    ZipEntry( const unz_file_info&, const char*, ZipArchive* );
+    ZipEntry( const Entry& ent, ZipArchive* zip ):
+      zentry( ent ),
+      parent( zip ) {}
 
     auto  GetName() const noexcept -> std::string override
-      {  return szname;  }
-    auto  GetAttr() const noexcept -> uint32_t
-      {  return uint32_t(fiinfo.internal_fa);  }
+      {  return zentry.name;  }
+    auto  GetAttr() const noexcept -> uint32_t override
+      {  return uint32_t(zentry.info.internal_fa);  }
     auto  GetFile() const -> mtc::api<const mtc::IByteBuffer> override
-      {  return parent->GetFile( szname ); }
+      {  return parent->GetFile( zentry ); }
+
+    auto  GetSize() const noexcept -> uint64_t override
+      {  return zentry.info.uncompressed_size;  }
+    auto  GetPackedSize() const noexcept -> uint64_t override
+      {  return zentry.info.compressed_size;  }
+    auto  GetMethod() const noexcept -> uint32_t override
+      {  return uint32_t(zentry.info.compression_method);  }
+    auto  GetCRC32() const noexcept -> uint32_t override
+      {  return uint32_t(zentry.info.crc);  }
 
     implement_lifetime_control
   };
 
-  class ByteBuff final: public std::vector<char>, public mtc::IByteBuffer
+  class ZipArchive::Unzip
+  {
+    ZipArchive* parent;
+    unzFile     handle;
+
+  public:
+    Unzip( ZipArchive* );
+   ~Unzip();
+
+    operator unzFile() const  {  return handle;  }
+  };
+
+  /*
+    ByteBuff - the inflated member; the buffer is grown by the data read with
+    no zero-fill, so the size recorded in the archive is only a hint.
+  */
+  class ByteBuff final: public mtc::IByteBuffer
   {
     implement_lifetime_control
 
   public:
-    const char* GetPtr() const override {  return data();  }
-    size_t      GetLen() const override {  return size();  }
+   ~ByteBuff()  {  free( buffer );  }
+
+    const char* GetPtr() const override {  return buffer;  }
+    size_t      GetLen() const override {  return length;  }
+    int         SetBuf( const void*, size_t ) override  {  return -1;  }
+    int         SetLen( size_t ) override {  return -1;  }
+
+  // the free space after the data read and the allocation growing it
+    auto  GetEnd() -> char*     {  return buffer + length;  }
+    auto  GetRoom() const -> size_t {  return nalloc - length;  }
+    void  Reserve( size_t );
+    void  Append( size_t cb ) {  length += cb;  }
+
+  protected:
+    char*   buffer = nullptr;
+    size_t  length = 0;
+    size_t  nalloc = 0;
+
+  };
+
+  /*
+    ByteView - the read-only window into the archive source buffer used for
+    stored (uncompressed) members; keeps the source alive by reference.
+  */
+  class ByteView final: public mtc::IByteBuffer
+  {
+    mtc::api<const mtc::IByteBuffer>  source;
+    const char*                       viewPtr;
+    size_t                            viewLen;
+
+    implement_lifetime_control
+
+  public:
+    ByteView( const mtc::api<const mtc::IByteBuffer>& src, size_t pos, size_t len ):
+      source( src ),
+      viewPtr( src->GetPtr() + pos ),
+      viewLen( len )  {}
+
+    const char* GetPtr() const override {  return viewPtr;  }
+    size_t      GetLen() const override {  return viewLen;  }
     int         SetBuf( const void*, size_t ) override  {  return -1;  }
     int         SetLen( size_t ) override {  return -1;  }
   };
 
   extern zlib_filefunc_def_s zlib_funcs;
 
+  // ByteBuff implementation
+
+  void  ByteBuff::Reserve( size_t size )
+  {
+    if ( size > nalloc )
+    {
+      auto  palloc = (char*)realloc( buffer, size );
+
+      if ( palloc == nullptr )
+        throw std::bad_alloc();
+
+      buffer = palloc;
+      nalloc = size;
+    }
+  }
+
   // ZipArchive implementation
 
-  ZipArchive::ZipArchive( const mtc::api<const mtc::IByteBuffer>& buf, unzFile zip ):
+  /*
+    The directory is read once on open: every entry keeps its info and the
+    position in the central directory, and the name map gives the entry by
+    name with no linear directory scan.
+  */
+  ZipArchive::ZipArchive( const mtc::api<const mtc::IByteBuffer>& buf, unzFile zipped ):
     buffer( buf ),
-    zipped( zip )
+    spares{ zipped }
   {
+    unz_file_info64 fiinfo;
+    char            szname[0x400];
+
+    for ( auto nerror = unzGoToFirstFile( zipped ); nerror == UNZ_OK; nerror = unzGoToNextFile( zipped ) )
+    {
+      auto  zentry = Entry();
+
+      if ( unzGetCurrentFileInfo64( zipped, &fiinfo, szname, sizeof(szname), nullptr, 0, nullptr, 0 ) != UNZ_OK )
+        break;
+
+      if ( fiinfo.size_filename < sizeof(szname) )
+      {
+        zentry.name.assign( szname, fiinfo.size_filename );
+      }
+        else
+      {
+        zentry.name.resize( fiinfo.size_filename );
+
+        if ( unzGetCurrentFileInfo64( zipped, nullptr, (char*)zentry.name.data(), fiinfo.size_filename, nullptr, 0, nullptr, 0 ) != UNZ_OK )
+          break;
+      }
+
+      if ( unzGetFilePos64( zipped, &zentry.fpos ) != UNZ_OK )
+        break;
+
+      zentry.info = fiinfo;
+      entries.emplace_back( std::move( zentry ) );
+    }
+
+  // the first of duplicate names is found, as unzLocateFile() does
+    nameMap.reserve( entries.size() );
+
+    for ( size_t i = 0; i != entries.size(); ++i )
+      nameMap.emplace( entries[i].name, i );
   }
 
   ZipArchive::~ZipArchive()
   {
-    if ( zipped != nullptr )
+    for ( auto zipped: spares )
       unzClose( zipped );
   }
 
   auto  ZipArchive::GetFile( const char* objectname ) -> mtc::api<const mtc::IByteBuffer>
   {
-    if ( zipped != nullptr && unzLocateFile( zipped, objectname, 1 ) == UNZ_OK && unzOpenCurrentFile( zipped ) == UNZ_OK )
+    auto  pfound = nameMap.find( objectname );
+
+    return pfound != nameMap.end() ? GetFile( entries[pfound->second] ) : nullptr;
+  }
+
+  auto  ZipArchive::GetFile( const Entry& zentry ) -> mtc::api<const mtc::IByteBuffer>
+  {
+    auto  charge = stats::Stage( ParseStats::unzip );
+    auto  traced = trace::Span( "member inflate" );
+    auto& fiinfo = zentry.info;
+    auto  zipped = Unzip( this );
+
+    if ( zipped != nullptr && unzGoToFilePos64( zipped, &zentry.fpos ) == UNZ_OK && unzOpenCurrentFile( zipped ) == UNZ_OK )
     {
+    // stored members are already contiguous in the source buffer, so there is
+    // no need to copy them; encrypted ones are still read through minizip
+      if ( fiinfo.compression_method == 0 && (fiinfo.flag & 1) == 0 && fiinfo.compressed_size == fiinfo.uncompressed_size )
+      {
+        auto  offset = unzGetCurrentFileZStreamPos64( zipped );
+
+        unzCloseCurrentFile( zipped );
+
+        if ( offset <= buffer->GetLen() && fiinfo.uncompressed_size <= buffer->GetLen() - offset )
+        {
+          stats::Count( &ParseStats::bytesUnpacked, fiinfo.uncompressed_size );
+          traced.SetBytes( fiinfo.uncompressed_size );
+          return new ByteView( buffer, offset, fiinfo.uncompressed_size );
+        }
+
+        return nullptr;
+      }
+
       auto  zipbuf = mtc::api( new ByteBuff );
-      char  buffer[0x400];
       long  cbread;
 
-      while ( (cbread = unzReadCurrentFile( zipped, buffer, sizeof(buffer) )) > 0 )
-        zipbuf->insert( zipbuf->end(), buffer, buffer + cbread );
+    // the output is allocated by the size from the central directory, but not
+    // more than deflate may produce from the packed size and not more than
+    // the limit, so the archives lying about the size do not force the large
+    // allocations; the output grows on demand, inflated straight into it
+      zipbuf->Reserve( size_t(std::min( { fiinfo.uncompressed_size,
+        std::min( fiinfo.compressed_size, ZPOS64_T(0x4000000) ) * 1032,
+        ZPOS64_T(0x4000000) } )) );
+
+      for ( ; ; )
+      {
+        if ( zipbuf->GetRoom() == 0 )
+          zipbuf->Reserve( std::max( zipbuf->GetLen() * 2, size_t(0x10000) ) );
+
+        if ( (cbread = unzReadCurrentFile( zipped, zipbuf->GetEnd(), unsigned(std::min( zipbuf->GetRoom(), size_t(0x40000000) )) )) <= 0 )
+          break;
+
+        zipbuf->Append( cbread );
+      }
 
       unzCloseCurrentFile( zipped );
 
+      stats::Count( &ParseStats::bytesUnpacked, zipbuf->GetLen() );
+      traced.SetBytes( zipbuf->GetLen() );
+
       return zipbuf.ptr();
     }
     return nullptr;
   }
 
-  auto ZipArchive::ReadDir() -> mtc::api<IEntry>
+  auto  ZipArchive::ReadDir() -> mtc::api<IEntry>
   {
-    unz_file_info fiinfo;
-    char          szname[0x400];
+    auto  exlock = std::unique_lock<std::mutex>( mxlock );
 
-    if ( !inRead )
-    {
-      if ( unzGoToFirstFile( zipped ) == UNZ_OK ) inRead = true;
-        else return nullptr;
-    }
-      else
-    {
-      if ( unzGoToNextFile( zipped ) != UNZ_OK )
-        return inRead = false, nullptr;
-    }
+    if ( dirPos < entries.size() )
+      return GetEntry( dirPos++ );
+
+    return dirPos = 0, nullptr;
+  }
+
+  auto  ZipArchive::GetEntry( size_t index ) -> mtc::api<IEntry>
+  {
+    return index < entries.size() ? new ZipEntry( entries[index], this ) : nullptr;
+  }
 
-    if ( unzGetCurrentFileInfo( zipped, &fiinfo, szname, sizeof(szname), nullptr, 0, nullptr, 0 ) != UNZ_OK )
-      return inRead = false, nullptr;
+  auto  ZipArchive::FindEntry( const char* objectname ) -> mtc::api<IEntry>
+  {
+    auto  pfound = nameMap.find( objectname );
 
-    return new ZipEntry( fiinfo, szname, this );
+    return pfound != nameMap.end() ? GetEntry( pfound->second ) : nullptr;
   }
 
   auto  OpenZip( const mtc::api<const mtc::IByteBuffer>& src ) -> mtc::api<IArchive>
   {
+    auto    charge = stats::Stage( ParseStats::unzip );
     unzFile zip;
 
     if ( src == nullptr )
       throw std::invalid_argument( "archive::OpenZip source buffer is empty" );
 
+    auto  traced = trace::Span( "zip open", src->GetLen() );
+
     if ( (zip = unzOpen2( (const char*)src.ptr(), &zlib_funcs ) ) == nullptr )
       return nullptr;
 
     return new ZipArchive( src, zip );
   }
 
-  // ZipArchive::ZipEntry implementation
+  // ZipArchive::Unzip implementation
+
+  ZipArchive::Unzip::Unzip( ZipArchive* zip ): parent( zip ), handle( nullptr )
+  {
+    auto  exlock = std::unique_lock<std::mutex>( parent->mxlock );
+
+    if ( !parent->spares.empty() )
+    {
+      handle = parent->spares.back();
+      parent->spares.pop_back();
+    }
+      else
+    {
+      exlock.unlock();
+      handle = unzOpen2( (const char*)parent->buffer.ptr(), &zlib_funcs );
+    }
+  }
 
-  ZipArchive::ZipEntry::ZipEntry( const unz_file_info& unz, const char* str, ZipArchive* zip ):
-    fiinfo( unz ),
-    parent( zip )
+  ZipArchive::Unzip::~Unzip()
   {
-    strcpy( szname, str );
+    if ( handle != nullptr )
+    {
+      auto  exlock = std::unique_lock<std::mutex>( parent->mxlock );
+
+      parent->spares.push_back( handle );
+    }
   }
 
   // zip interface functions
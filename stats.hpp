@@ -0,0 +1,57 @@
+# if !defined( __DeliriX_stats_hpp__ )
+# define __DeliriX_stats_hpp__
+# include <cstdint>
+
+namespace DeliriX
+{
+
+  /*
+    ParseStats - the parse pipeline counters collected on request: the Parse*
+    functions called with the ParseStats pointer add the values got for the
+    document to the ones in the structure, so one ParseStats may be used for
+    a single document as well as for a set of them; nullptr costs one check
+    per counted event.
+
+    The time is the wall time in nanoseconds charged to the stage running,
+    exclusive of the nested ones: the time the adapter waits for the output
+    is the output time, so the stages sum up to the time of the Parse* call.
+
+    The tags, blocks and bytesOut are counted by the calls to the output
+    IText; the allocs are the paragraph bodies heap blocks and arena chunks
+    and the Text storage growth, so the other outputs report only their own
+    paragraph bodies.
+  */
+  struct ParseStats
+  {
+    enum Stage: unsigned
+    {
+      other = 0,          // arguments check and format detection
+      unzip,              // the archive directory read and the members inflate
+      xml,                // the xml tokenizer
+      adapter,            // the format adapters mapping the elements to the output
+      convert,            // the codepage conversions
+      output,             // the output IText calls
+      stage_count
+    };
+
+    uint64_t  nanoseconds[stage_count] = {};
+    uint64_t  bytesIn = 0;            // the source documents size
+    uint64_t  bytesUnpacked = 0;      // the archive members extracted
+    uint64_t  bytesOut = 0;           // the text added to the output, in the block encoding
+    uint64_t  elements = 0;           // the xml elements parsed
+    uint64_t  tags = 0;               // the markup tags added to the output
+    uint64_t  blocks = 0;             // the text blocks added to the output
+    uint64_t  allocs = 0;             // the heap allocations for the output
+    uint64_t  conversions = 0;        // the strings converted to other encoding
+
+  // the sum of the stages time
+    auto  GetTime() const -> uint64_t;
+
+    auto  operator += ( const ParseStats& ) -> ParseStats&;
+
+    static  auto  GetStageName( Stage ) -> const char*;
+  };
+
+}
+
+# endif   // !__DeliriX_stats_hpp__
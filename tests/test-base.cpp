@@ -1,12 +1,20 @@
 # include "../archive.hpp"
+# include "../filemap.hpp"
 # include "mock-buff.hpp"
 # include <mtc/byteBuffer.h>
 # include <mtc/test-it-easy.hpp>
+# include <thread>
+# include <atomic>
+# include <cstring>
+# include <cstdio>
+# include <system_error>
 
 using namespace DeliriX;
 
 extern unsigned char  sample_zipzip_buf[];
 extern unsigned       sample_zipzip_len;
+extern unsigned char  sample_odtzip_buf[];
+extern unsigned       sample_odtzip_len;
 
 TestItEasy::RegisterFunc  test_text_base( []()
 {
@@ -45,6 +53,18 @@ TestItEasy::RegisterFunc  test_text_base( []()
                   REQUIRE( memcmp( buffer->GetPtr(), "this is a test zip file data", 28 ) == 0 );
               }
             }
+            SECTION( "stored objects are not copied, but point to the source buffer" )
+            {
+              auto  source = mtc::CreateByteBuffer( sample_odtzip_buf, sample_odtzip_len );
+
+              if ( REQUIRE_NOTHROW( buffer = OpenZip( source.ptr() )->GetFile( "mimetype" ) )
+                && REQUIRE( buffer != nullptr ) )
+              {
+                REQUIRE( buffer->GetPtr() > source->GetPtr() );
+                REQUIRE( buffer->GetPtr() + buffer->GetLen() < source->GetPtr() + source->GetLen() );
+                REQUIRE( std::string( buffer->GetPtr(), buffer->GetLen() ) == "application/vnd.oasis.opendocument.text" );
+              }
+            }
           }
           SECTION( "files may be listed as directory" )
           {
@@ -58,6 +78,135 @@ TestItEasy::RegisterFunc  test_text_base( []()
                 REQUIRE( entry == nullptr );
             }
           }
+          SECTION( "objects may be extracted from several threads at once" )
+          {
+            auto  source = OpenZip( mtc::CreateByteBuffer( sample_odtzip_buf, sample_odtzip_len ).ptr() );
+            auto  sample = std::vector<std::string>();
+            auto  failed = std::atomic_int( 0 );
+            auto  worker = std::vector<std::thread>();
+
+            for ( size_t i = 0; i != source->GetCount(); ++i )
+            {
+              auto  buffer = source->GetEntry( i )->GetFile();
+
+              sample.push_back( buffer != nullptr ? std::string( buffer->GetPtr(), buffer->GetLen() ) : "" );
+            }
+
+            for ( int i = 0; i != 4; ++i )
+              worker.emplace_back( [&]()
+                {
+                  for ( int n = 0; n != 20; ++n )
+                    for ( size_t i = 0; i != sample.size(); ++i )
+                    {
+                      auto  buffer = source->GetEntry( i )->GetFile();
+
+                      if ( (buffer != nullptr ? std::string( buffer->GetPtr(), buffer->GetLen() ) : "") != sample[i] )
+                        ++failed;
+                    }
+                } );
+
+            for ( auto& next: worker )
+              next.join();
+
+            REQUIRE( failed == 0 );
+          }
+          SECTION( "inflated objects do not rely on the size recorded in the archive" )
+          {
+            auto  sample = OpenZip( mtc::CreateByteBuffer( sample_odtzip_buf, sample_odtzip_len ).ptr() )->GetFile( "content.xml" );
+            auto  forged = std::string( (const char*)sample_odtzip_buf, sample_odtzip_len );
+            auto  nfound = 0;
+
+          // set the huge uncompressed size in both the local and the central headers
+            for ( auto npos = forged.find( "content.xml" ); npos != std::string::npos; npos = forged.find( "content.xml", npos + 1 ) )
+            {
+              if ( npos >= 30 && forged.compare( npos - 30, 4, "PK\3\4" ) == 0 )
+                forged.replace( npos - 30 + 22, 4, "\xf0\xff\xff\x7f" ), ++nfound;
+              if ( npos >= 46 && forged.compare( npos - 46, 4, "PK\1\2" ) == 0 )
+                forged.replace( npos - 46 + 24, 4, "\xf0\xff\xff\x7f" ), ++nfound;
+            }
+
+            if ( REQUIRE( sample != nullptr ) && REQUIRE( nfound == 2 ) )
+            {
+              auto  buffer = mtc::api<const mtc::IByteBuffer>();
+
+              if ( REQUIRE_NOTHROW( buffer = OpenZip( mtc::CreateByteBuffer( forged.data(), forged.size() ).ptr() )->GetFile( "content.xml" ) )
+                && REQUIRE( buffer != nullptr ) )
+              {
+                REQUIRE( std::string( buffer->GetPtr(), buffer->GetLen() ) == std::string( sample->GetPtr(), sample->GetLen() ) );
+              }
+            }
+          }
+          SECTION( "files may be accessed by index or by name" )
+          {
+            mtc::api<IArchive::IEntry>  entry;
+
+            REQUIRE( archive->GetCount() == 1U );
+            REQUIRE( archive->GetEntry( 1 ) == nullptr );
+            REQUIRE( archive->FindEntry( "non-existing-object" ) == nullptr );
+
+            if ( REQUIRE_NOTHROW( entry = archive->GetEntry( 0 ) ) && REQUIRE( entry != nullptr ) )
+              REQUIRE( entry->GetName() == "zip_data.txt" );
+
+            if ( REQUIRE_NOTHROW( entry = archive->FindEntry( "zip_data.txt" ) ) && REQUIRE( entry != nullptr ) )
+            {
+              SECTION( "entries provide metadata with no decompression" )
+              {
+                REQUIRE( entry->GetSize() == 28U );
+                REQUIRE( entry->GetPackedSize() == 28U );
+                REQUIRE( entry->GetMethod() == IArchive::IEntry::stored );
+                REQUIRE( entry->GetCRC32() == 0x01bad41eU );
+              }
+            }
+          }
+        }
+      }
+    }
+    SECTION( "it supports memory-mapped files as source buffers" )
+    {
+      auto  tmpname = std::string( "DeliriX-test-filemap.tmp" );
+      auto  lpfile = fopen( tmpname.c_str(), "wb" );
+      auto  buffer = mtc::api<const mtc::IByteBuffer>();
+
+      if ( REQUIRE( lpfile != nullptr ) )
+      {
+        fwrite( sample_odtzip_buf, 1, sample_odtzip_len, lpfile );
+        fclose( lpfile );
+
+        SECTION( "non-existing files throw system_error" )
+        {
+          REQUIRE_EXCEPTION( MapFile( "non-existing-file.tmp" ), std::system_error );
+          REQUIRE_EXCEPTION( MapFile( "" ), std::invalid_argument );
+        }
+        SECTION( "file contents are mapped as is" )
+        {
+          if ( REQUIRE_NOTHROW( buffer = MapFile( tmpname.c_str(), Access::random ) ) && REQUIRE( buffer != nullptr ) )
+          {
+            REQUIRE( buffer->GetLen() == sample_odtzip_len );
+            REQUIRE( memcmp( buffer->GetPtr(), sample_odtzip_buf, sample_odtzip_len ) == 0 );
+          }
+        }
+        SECTION( "mapped archives may be opened and read" )
+        {
+          auto  archive = OpenZip( MapFile( tmpname.c_str(), Access::random ) );
+
+          if ( REQUIRE( archive != nullptr ) )
+          {
+            if ( REQUIRE_NOTHROW( buffer = archive->GetFile( "mimetype" ) ) && REQUIRE( buffer != nullptr ) )
+              REQUIRE( std::string( buffer->GetPtr(), buffer->GetLen() ) == "application/vnd.oasis.opendocument.text" );
+          }
+        }
+        remove( tmpname.c_str() );
+      }
+      SECTION( "empty files are mapped as empty buffers" )
+      {
+        if ( REQUIRE( (lpfile = fopen( tmpname.c_str(), "wb" )) != nullptr ) )
+        {
+          fclose( lpfile );
+
+          if ( REQUIRE_NOTHROW( buffer = MapFile( tmpname.c_str() ) ) && REQUIRE( buffer != nullptr ) )
+            REQUIRE( buffer->GetLen() == 0U );
+
+          remove( tmpname.c_str() );
         }
       }
     }
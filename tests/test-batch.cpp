@@ -0,0 +1,202 @@
+# include "../batch.hpp"
+# include "../DOM-dump.hpp"
+# include "../trace.hpp"
+# include <mtc/test-it-easy.hpp>
+# include <atomic>
+# include <thread>
+
+using namespace DeliriX;
+
+extern unsigned char  sample_odtzip_buf[];
+extern unsigned       sample_odtzip_len;
+extern unsigned char  sample_docxDeliriX_buf[];
+extern unsigned       sample_docxDeliriX_len;
+extern unsigned char  sample_fb2Panov_buf[];
+extern unsigned       sample_fb2Panov_len;
+
+static  auto  CountOf( const std::string& str, const char* what ) -> size_t
+{
+  auto  ncount = size_t(0);
+
+  for ( auto npos = str.find( what ); npos != std::string::npos; npos = str.find( what, npos + 1 ) )
+    ++ncount;
+
+  return ncount;
+}
+
+TestItEasy::RegisterFunc  test_batch( []()
+{
+  TEST_CASE( "DeliriX/batch" )
+  {
+    auto  samples = std::vector<mtc::api<const mtc::IByteBuffer>>{
+      mtc::CreateByteBuffer( sample_odtzip_buf, sample_odtzip_len ).ptr(),
+      mtc::CreateByteBuffer( sample_docxDeliriX_buf, sample_docxDeliriX_len ).ptr(),
+      mtc::CreateByteBuffer( sample_fb2Panov_buf, sample_fb2Panov_len ).ptr(),
+      mtc::CreateByteBuffer( "plain text", 10 ).ptr() };
+    auto  sources = std::vector<mtc::api<const mtc::IByteBuffer>>();
+    auto  expects = std::vector<std::string>();
+
+    for ( size_t i = 0; i != 64; ++i )
+      sources.push_back( samples[i % samples.size()] );
+
+    for ( auto& next: samples )
+    {
+      auto  output = Text::Create();
+      auto  string = std::string();
+
+      try
+      {
+        ParseAny( output, next );
+        output->Serialize( dump_as::Tags( dump_as::MakeOutput( &string ) ) );
+      }
+      catch ( ... ) {}
+
+      expects.push_back( string );
+    }
+
+    SECTION( "ParseBatch() parses a set of documents on several threads" )
+    {
+      SECTION( "with different count of sources and outputs, it throws std::invalid_argument" )
+      {
+        REQUIRE_EXCEPTION( ParseBatch( sources, std::vector<mtc::api<IText>>( 1 ) ), std::invalid_argument );
+      }
+      SECTION( "empty batches are processed" )
+      {
+        REQUIRE( ParseBatch( {}, 4 ).empty() );
+      }
+      SECTION( "documents are parsed to the created texts" )
+      {
+        for ( auto nthreads: { 1U, 3U, 0U } )
+        {
+          auto  results = ParseBatch( sources, nthreads );
+          auto  nfailed = size_t(0);
+
+          if ( REQUIRE( results.size() == sources.size() ) )
+            for ( size_t i = 0; i != results.size(); ++i )
+            {
+              auto  string = std::string();
+
+              if ( results[i].output != nullptr )
+                results[i].output->Serialize( dump_as::Tags( dump_as::MakeOutput( &string ) ) );
+
+              if ( string != expects[i % samples.size()] )
+                ++nfailed;
+            }
+          REQUIRE( nfailed == 0U );
+        }
+      }
+      SECTION( "documents are parsed to the outputs passed" )
+      {
+        auto  outputs = std::vector<mtc::api<IText>>();
+        auto  results = std::vector<BatchResult>();
+
+        for ( size_t i = 0; i != sources.size(); ++i )
+          outputs.push_back( Text::Create().ptr() );
+
+        if ( REQUIRE_NOTHROW( results = ParseBatch( sources, outputs, 4 ) ) )
+        {
+          REQUIRE( results[0].format == Format::odt );
+          REQUIRE( results[1].format == Format::docx );
+          REQUIRE( results[2].format == Format::fb2 );
+        }
+      }
+      SECTION( "errors are reported per document" )
+      {
+        auto  results = ParseBatch( sources, 4 );
+
+        for ( size_t i = 0; i != results.size(); ++i )
+          if ( i % samples.size() == 3 )
+          {
+            REQUIRE( !results[i].Succeeded() );
+            REQUIRE( results[i].output == nullptr );
+          }
+            else
+          {
+            REQUIRE( results[i].Succeeded() );
+          }
+      }
+    }
+    SECTION( "the trace records the pipeline events of the batch threads" )
+    {
+      SECTION( "with the trace stopped, nothing is recorded" )
+      {
+        trace::Flush();
+
+        ParseBatch( sources, 2 );
+
+        REQUIRE( !trace::Enabled() );
+        REQUIRE( CountOf( trace::Flush(), "\"ph\":\"X\"" ) == 0U );
+      }
+      SECTION( "the events are flushed as Chrome Trace JSON" )
+      {
+        auto  traced = std::string();
+
+        trace::Start();
+          ParseBatch( sources, 3 );
+          traced = trace::Flush();
+        trace::Stop();
+
+        REQUIRE( traced.substr( 0, 16 ) == "{\"traceEvents\":[" );
+        REQUIRE( traced.back() == '}' );
+        REQUIRE( CountOf( traced, "\"name\":\"batch document\"" ) == sources.size() );
+        REQUIRE( CountOf( traced, "\"name\":\"odt adapter\"" ) == sources.size() / samples.size() );
+        REQUIRE( CountOf( traced, "\"name\":\"docx adapter\"" ) == sources.size() / samples.size() );
+        REQUIRE( CountOf( traced, "\"name\":\"fb2 adapter\"" ) == sources.size() / samples.size() );
+        REQUIRE( CountOf( traced, "\"name\":\"zip open\"" ) != 0U );
+        REQUIRE( CountOf( traced, "\"name\":\"member inflate\"" ) != 0U );
+        REQUIRE( CountOf( traced, "\"name\":\"xml parse\"" ) != 0U );
+        REQUIRE( CountOf( traced, "\"name\":\"thread_name\"" ) >= 3U );
+        REQUIRE( CountOf( traced, "\"droppedEvents\":0}" ) == 1U );
+      }
+      SECTION( "the events flushed are not flushed again" )
+      {
+        REQUIRE( CountOf( trace::Flush(), "\"ph\":\"X\"" ) == 0U );
+      }
+      SECTION( "the rings are flushed while the threads write them" )
+      {
+        auto  traced = std::string();
+        auto  finish = std::atomic<bool>( false );
+
+        trace::Start();
+        {
+          auto  worker = std::thread( [&]()
+            {
+              ParseBatch( sources, 4 );
+              finish = true;
+            } );
+
+          while ( !finish )
+            traced += trace::Flush();
+
+          worker.join();
+        }
+        traced += trace::Flush();
+        trace::Stop();
+
+        REQUIRE( CountOf( traced, "\"name\":\"batch document\"" ) == sources.size() );
+      }
+      SECTION( "the ring keeps the last events, the older ones are dropped" )
+      {
+        auto  traced = std::string();
+
+        trace::Start( 0x10 );
+        std::thread( [&]()
+          {
+            for ( int i = 0; i != 10; ++i )
+            {
+              Text  text;
+
+              ParseAny( &text, samples[1] );
+            }
+          } ).join();
+        traced = trace::Flush();
+        trace::Stop();
+        trace::Start();
+        trace::Stop();
+
+        REQUIRE( CountOf( traced, "\"ph\":\"X\"" ) == 0x10U );
+        REQUIRE( CountOf( traced, "\"droppedEvents\":0}" ) == 0U );
+      }
+    }
+  }
+} );
@@ -0,0 +1,293 @@
+# include "../formats.hpp"
+# include "../DOM-text.hpp"
+# include "../DOM-dump.hpp"
+# include <mtc/test-it-easy.hpp>
+# include <moonycode/codes.h>
+# include <zlib.h>
+# include <chrono>
+# include <tuple>
+
+using namespace DeliriX;
+
+extern unsigned char  sample_zipzip_buf[];
+extern unsigned       sample_zipzip_len;
+extern unsigned char  sample_odtzip_buf[];
+extern unsigned       sample_odtzip_len;
+extern unsigned char  sample_docxDeliriX_buf[];
+extern unsigned       sample_docxDeliriX_len;
+extern unsigned char  sample_fb2Panov_buf[];
+extern unsigned       sample_fb2Panov_len;
+
+// the zip archive of the members stored uncompressed
+static  auto  MakeZip( const std::vector<std::pair<std::string, std::string>>& members ) -> std::string
+{
+  auto  output = std::string();
+  auto  direct = std::string();
+  auto  Put = []( std::string& out, uint32_t value, int size )
+    {
+      for ( ; size-- != 0; value >>= 8 )
+        out += char(value & 0xff);
+    };
+
+  for ( auto& member: members )
+  {
+    auto  crc = uint32_t(crc32( 0, (const Bytef*)member.second.data(), uInt(member.second.size()) ));
+    auto  pos = uint32_t(output.size());
+
+    Put( output, 0x04034b50, 4 );   Put( output, 10, 2 );   Put( output, 0, 2 );  Put( output, 0, 2 );
+    Put( output, 0, 2 );            Put( output, 0, 2 );    Put( output, crc, 4 );
+    Put( output, uint32_t(member.second.size()), 4 );       Put( output, uint32_t(member.second.size()), 4 );
+    Put( output, uint32_t(member.first.size()), 2 );        Put( output, 0, 2 );
+    output += member.first + member.second;
+
+    Put( direct, 0x02014b50, 4 );   Put( direct, 20, 2 );   Put( direct, 10, 2 ); Put( direct, 0, 2 );
+    Put( direct, 0, 2 );            Put( direct, 0, 2 );    Put( direct, 0, 2 );  Put( direct, crc, 4 );
+    Put( direct, uint32_t(member.second.size()), 4 );       Put( direct, uint32_t(member.second.size()), 4 );
+    Put( direct, uint32_t(member.first.size()), 2 );        Put( direct, 0, 2 );  Put( direct, 0, 2 );
+    Put( direct, 0, 2 );            Put( direct, 0, 2 );    Put( direct, 0, 4 );  Put( direct, pos, 4 );
+    direct += member.first;
+  }
+
+  Put( direct, 0x06054b50, 4 );     Put( direct, 0, 2 );    Put( direct, 0, 2 );
+  Put( direct, uint32_t(members.size()), 2 );               Put( direct, uint32_t(members.size()), 2 );
+  Put( direct, uint32_t(direct.size() - 8), 4 );            Put( direct, uint32_t(output.size()), 4 );
+  Put( direct, 0, 2 );
+
+  return output + direct;
+}
+
+TestItEasy::RegisterFunc  test_formats( []()
+{
+  TEST_CASE( "DeliriX/formats" )
+  {
+    SECTION( "document format is detected by the content" )
+    {
+      SECTION( "with empty buffer, it throws std::invalid_argument" )
+      {
+        REQUIRE_EXCEPTION( GetFormat( nullptr ), std::invalid_argument );
+      }
+      SECTION( "zip archives are detected by the members" )
+      {
+        REQUIRE( GetFormat( mtc::CreateByteBuffer( sample_odtzip_buf, sample_odtzip_len ).ptr() ) == Format::odt );
+        REQUIRE( GetFormat( mtc::CreateByteBuffer( sample_docxDeliriX_buf, sample_docxDeliriX_len ).ptr() ) == Format::docx );
+        REQUIRE( GetFormat( mtc::CreateByteBuffer( sample_zipzip_buf, sample_zipzip_len ).ptr() ) == Format::unknown );
+      }
+      SECTION( "the odt 'mimetype' is decisive, 'content.xml' is checked only with no 'mimetype'" )
+      {
+        auto  content = std::make_pair( std::string( "content.xml" ), std::string( "<office:document-content/>" ) );
+        auto  odszip = MakeZip( { { "mimetype", "application/vnd.oasis.opendocument.spreadsheet" }, content } );
+        auto  odtzip = MakeZip( { { "mimetype", "application/vnd.oasis.opendocument.text" }, content } );
+        auto  anyzip = MakeZip( { content } );
+
+        REQUIRE( GetFormat( mtc::CreateByteBuffer( odszip.data(), odszip.size() ).ptr() ) == Format::unknown );
+        REQUIRE( GetFormat( mtc::CreateByteBuffer( odtzip.data(), odtzip.size() ).ptr() ) == Format::odt );
+        REQUIRE( GetFormat( mtc::CreateByteBuffer( anyzip.data(), anyzip.size() ).ptr() ) == Format::odt );
+      }
+      SECTION( "xml documents are detected by the root element" )
+      {
+        REQUIRE( GetFormat( mtc::CreateByteBuffer( sample_fb2Panov_buf, sample_fb2Panov_len ).ptr() ) == Format::fb2 );
+        REQUIRE( GetFormat( mtc::CreateByteBuffer( "<?xml version='1.0'?><!-- <FictionBook> --><fb:FictionBook/>", 60 ).ptr() ) == Format::fb2 );
+        REQUIRE( GetFormat( mtc::CreateByteBuffer( "\xef\xbb\xbf<!DOCTYPE html><html/>", 25 ).ptr() ) == Format::xml );
+      }
+      SECTION( "anything else is unknown" )
+      {
+        REQUIRE( GetFormat( mtc::CreateByteBuffer( "plain text", 10 ).ptr() ) == Format::unknown );
+        REQUIRE( GetFormat( mtc::CreateByteBuffer( "PK\x03\x04 broken", 11 ).ptr() ) == Format::unknown );
+        REQUIRE( GetFormat( mtc::CreateByteBuffer( "", 0 ).ptr() ) == Format::unknown );
+      }
+    }
+    SECTION( "ParseAny() loads documents of any supported format" )
+    {
+      SECTION( "with empty buffer or output, it throws std::invalid_argument" )
+      {
+        Text  text;
+
+        REQUIRE_EXCEPTION( ParseAny( nullptr, mtc::CreateByteBuffer( "<a/>", 4 ).ptr() ), std::invalid_argument );
+        REQUIRE_EXCEPTION( ParseAny( &text, nullptr ), std::invalid_argument );
+        REQUIRE_EXCEPTION( ParseAny( &text, mtc::CreateByteBuffer( "plain text", 10 ).ptr() ), std::invalid_argument );
+      }
+      SECTION( "it produces the same text as the format-specific parsers" )
+      {
+        auto  sample = std::initializer_list<std::tuple<const void*, unsigned, Format, int(*)( IText*, const mtc::api<const mtc::IByteBuffer>&, TextOutput, ParseStats* )>>{
+          { sample_odtzip_buf, sample_odtzip_len, Format::odt, ParseODT },
+          { sample_docxDeliriX_buf, sample_docxDeliriX_len, Format::docx, ParseDOCX },
+          { sample_fb2Panov_buf, sample_fb2Panov_len, Format::fb2, ParseFB2 } };
+
+        for ( auto& next: sample )
+        {
+          auto  source = mtc::api<const mtc::IByteBuffer>( mtc::CreateByteBuffer( std::get<0>( next ), std::get<1>( next ) ).ptr() );
+          Text  direct;
+          Text  detect;
+          auto  expect = std::string();
+          auto  output = std::string();
+
+          std::get<3>( next )( &direct, source, TextOutput::source, nullptr );
+          direct.Serialize( dump_as::Tags( dump_as::MakeOutput( &expect ) ) );
+
+          if ( REQUIRE( ParseAny( &detect, source ) == std::get<2>( next ) ) )
+          {
+            detect.Serialize( dump_as::Tags( dump_as::MakeOutput( &output ) ) );
+            REQUIRE( output == expect );
+          }
+        }
+      }
+      SECTION( "the text is output in the source encoding or in UTF-16 by request" )
+      {
+        for ( auto& next: {
+          mtc::CreateByteBuffer( sample_odtzip_buf, sample_odtzip_len ),
+          mtc::CreateByteBuffer( sample_docxDeliriX_buf, sample_docxDeliriX_len ),
+          mtc::CreateByteBuffer( sample_fb2Panov_buf, sample_fb2Panov_len ) } )
+        {
+          Text  source;
+          Text  widened;
+          auto  expect = std::string();
+          auto  output = std::string();
+          auto  nchars = size_t(0);
+          auto  nwides = size_t(0);
+
+          ParseAny( &source, next, TextOutput::source );
+          ParseAny( &widened, next, TextOutput::utf16 );
+
+          for ( auto& block: source.GetBlocks() )
+            nchars += block.GetEncoding() == codepages::codepage_utf8 ? 1 : 0;
+          for ( auto& block: widened.GetBlocks() )
+            nwides += block.GetEncoding() == uint32_t(-1) ? 1 : 0;
+
+          REQUIRE( nchars == source.GetBlocks().size() );
+          REQUIRE( nwides == widened.GetBlocks().size() );
+
+          source.Serialize( dump_as::Tags( dump_as::MakeOutput( &expect ) ) );
+          widened.Serialize( dump_as::Tags( dump_as::MakeOutput( &output ) ) );
+          REQUIRE( output == expect );
+        }
+      }
+      SECTION( "plain xml documents are loaded as is" )
+      {
+        Text  text;
+        auto  tags = std::string();
+
+        if ( REQUIRE( ParseAny( &text, mtc::CreateByteBuffer( "<p>text</p>", 11 ).ptr() ) == Format::xml ) )
+        {
+          text.Serialize( dump_as::Tags( dump_as::MakeOutput( &tags ) ) );
+          REQUIRE( tags == "<p>\n  text\n</p>\n" );
+        }
+      }
+    }
+    SECTION( "ParseStats collects the pipeline counters by request" )
+    {
+      auto  docx = mtc::api<const mtc::IByteBuffer>( mtc::CreateByteBuffer( sample_docxDeliriX_buf, sample_docxDeliriX_len ).ptr() );
+      auto  fb2 = mtc::api<const mtc::IByteBuffer>( mtc::CreateByteBuffer( sample_fb2Panov_buf, sample_fb2Panov_len ).ptr() );
+
+      SECTION( "the output is the same as with no stats" )
+      {
+        ParseStats  stats;
+        Text        direct;
+        Text        actual;
+        auto        expect = std::string();
+        auto        output = std::string();
+
+        ParseDOCX( &direct, docx );
+        ParseDOCX( &actual, docx, TextOutput::source, &stats );
+
+        direct.Serialize( dump_as::Tags( dump_as::MakeOutput( &expect ) ) );
+        actual.Serialize( dump_as::Tags( dump_as::MakeOutput( &output ) ) );
+        REQUIRE( output == expect );
+      }
+      SECTION( "the counters match the document and the output" )
+      {
+        ParseStats  stats;
+        Text        text;
+        auto        nbytes = uint64_t(0);
+
+        ParseDOCX( &text, docx, TextOutput::source, &stats );
+
+        for ( auto& block: text.GetBlocks() )
+          nbytes += block.GetTextSize();
+
+        REQUIRE( stats.bytesIn == sample_docxDeliriX_len );
+        REQUIRE( stats.bytesUnpacked > stats.bytesIn );
+        REQUIRE( stats.bytesOut == nbytes );
+        REQUIRE( stats.blocks == text.GetBlocks().size() );
+        REQUIRE( stats.tags >= text.GetMarkup().size() );
+        REQUIRE( stats.elements > stats.tags );
+        REQUIRE( stats.allocs >= stats.blocks );
+        REQUIRE( stats.conversions == 0 );
+      }
+      SECTION( "the stages time sums up to the whole parse time" )
+      {
+        ParseStats  stats;
+        Text        text;
+        auto        tstart = std::chrono::steady_clock::now();
+
+        ParseDOCX( &text, docx, TextOutput::source, &stats );
+
+        auto        nwhole = uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now() - tstart ).count());
+
+        REQUIRE( stats.nanoseconds[ParseStats::unzip] != 0 );
+        REQUIRE( stats.nanoseconds[ParseStats::xml] != 0 );
+        REQUIRE( stats.nanoseconds[ParseStats::adapter] != 0 );
+        REQUIRE( stats.nanoseconds[ParseStats::output] != 0 );
+
+      // the stages cover the call but the argument passing and the clock calls
+        REQUIRE( stats.GetTime() <= nwhole );
+        REQUIRE( stats.GetTime() >= nwhole / 2 );
+        REQUIRE( std::string( ParseStats::GetStageName( ParseStats::convert ) ) == "convert" );
+      }
+      SECTION( "the conversions are counted for the UTF-16 output" )
+      {
+        ParseStats  stats;
+        Text        text;
+
+        ParseFB2( &text, fb2, TextOutput::utf16, &stats );
+
+        REQUIRE( stats.bytesUnpacked == 0 );
+        REQUIRE( stats.conversions != 0 );
+        REQUIRE( stats.nanoseconds[ParseStats::convert] != 0 );
+        REQUIRE( stats.nanoseconds[ParseStats::unzip] == 0 );
+      }
+      SECTION( "the nested parser calls are not counted twice" )
+      {
+        ParseStats  direct;
+        ParseStats  detect;
+        Text        text;
+
+        ParseFB2( &text, fb2, TextOutput::source, &direct );
+        ParseAny( &text, fb2, TextOutput::source, &detect );
+
+        REQUIRE( detect.bytesIn == direct.bytesIn );
+        REQUIRE( detect.elements == direct.elements );
+        REQUIRE( detect.tags == direct.tags );
+        REQUIRE( detect.blocks == direct.blocks );
+      }
+      SECTION( "the counters are added to the ones collected before" )
+      {
+        ParseStats  single;
+        ParseStats  twice;
+        Text        text;
+
+        ParseFB2( &text, fb2, TextOutput::source, &single );
+        ParseFB2( &text, fb2, TextOutput::source, &twice );
+        ParseFB2( &text, fb2, TextOutput::source, &twice );
+
+        REQUIRE( twice.bytesIn == single.bytesIn * 2 );
+        REQUIRE( twice.blocks == single.blocks * 2 );
+
+        single += single;
+        REQUIRE( twice.elements == single.elements );
+      }
+      SECTION( "with the parse failed, the stats are no more collected" )
+      {
+        ParseStats  stats;
+        Text        text;
+
+        REQUIRE_EXCEPTION( ParseXML( &text, mtc::CreateByteBuffer( "<a><b></a>", 10 ).ptr(), &stats ), Error );
+        REQUIRE( stats.bytesIn == 10 );
+        REQUIRE( stats.elements == 2 );
+
+        ParseXML( &text, mtc::CreateByteBuffer( "<a><b/></a>", 11 ).ptr() );
+        REQUIRE( stats.elements == 2 );
+      }
+    }
+  }
+} );
@@ -119,8 +119,8 @@ TestItEasy::RegisterFunc  test_odt( []()
               "        struct IText: mtc::Iface\n"
               "      </p>\n"
               "      <p>\n"
+              "        {\n"
               "      </p>\n"
-              "      {\n"
               "      <p>\n"
               "          auto  AddMarkupTag( const char*, size_t = -1 ) → mtc::api&lt;IText&gt;;\n"
               "      </p>\n"
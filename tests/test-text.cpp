@@ -1,10 +1,15 @@
 # include "../DOM-text.hpp"
 # include "../DOM-dump.hpp"
 # include "../DOM-load.hpp"
+# include "../DOM-view.hpp"
+# include <mtc/byteBuffer.h>
 # include <moonycode/codes.h>
 # include <mtc/serialize.h>
 # include <mtc/test-it-easy.hpp>
 # include <mtc/iStream.h>
+# include <algorithm>
+# include <atomic>
+# include <thread>
 
 template <> inline
 auto  Serialize( std::string* to, const void* s, size_t len ) -> std::string*
@@ -14,6 +19,21 @@ template <> inline
 auto  Serialize( std::vector<char>* to, const void* p, size_t l ) -> std::vector<char>*
   {  return to->insert( to->end(), (const char*)p, (const char*)p + l ), to;  }
 
+static  bool  SameMarkup( const DeliriX::ITextView& a, const DeliriX::ITextView& b )
+{
+  auto  ma = a.GetMarkup();
+  auto  mb = b.GetMarkup();
+
+  return std::equal( ma.begin(), ma.end(), mb.begin(), mb.end() );
+}
+
+static  auto  GetJson( const DeliriX::ITextView& text ) -> std::string
+{
+  auto  output = std::string();
+
+  return text.Serialize( DeliriX::dump_as::Json( DeliriX::dump_as::MakeOutput( &output ) ) ), output;
+}
+
 class ByteStreamOnString: public mtc::IByteStream
 {
   std::string& str;
@@ -33,6 +53,21 @@ public:
 
 using namespace DeliriX;
 
+// the view implemented by the user, with no index cached
+class BlocksView final: public ITextView
+{
+  const Text& text;
+
+  implement_lifetime_stub
+
+public:
+  BlocksView( const Text& t ): text( t ) {}
+
+  auto  GetBlocks() const -> mtc::span<const Paragraph> override  {  return text.GetBlocks();  }
+  auto  GetMarkup() const -> mtc::span<const MarkupTag> override  {  return text.GetMarkup();  }
+  auto  GetLength() const -> uint32_t override                    {  return text.GetLength();  }
+};
+
 const char  json[] =
   "[\n"
   "  \"aaa\",\n"
@@ -119,20 +154,195 @@ TestItEasy::RegisterFunc  test_text( []()
           }
         }
       }
-      /*
-      SECTION( "it may be created with alternate allocator" )
+      SECTION( "it may allocate paragraphs in arena" )
+      {
+        auto  text = Text();
+        auto  held = Paragraph();
+
+        text.SetArena( 0x100 );
+
+        SECTION( "paragraphs are allocated in arena with no need to deallocate" )
+        {
+          for ( int i = 0; i != 100; ++i )
+          {
+            text.AddBlock( "This is a test string object to be allocated in memory arena" );
+            text.AddBlock( codepages::mbcstowide( codepages::codepage_utf8,
+              "This is a test widestring to be allocated in memory arena" ) );
+          }
+          if ( REQUIRE( text.GetBlocks().size() == 200U ) )
+          {
+            REQUIRE( text.GetBlocks()[198].GetCharStr() == "This is a test string object to be allocated in memory arena" );
+            REQUIRE( text.GetBlocks()[199].GetWideStr() == codepages::mbcstowide( codepages::codepage_utf8,
+              "This is a test widestring to be allocated in memory arena" ) );
+          }
+        }
+        SECTION( "paragraphs longer than the chunk are allocated" )
+        {
+          auto  string = std::string( 0x1000, 'a' );
+
+          text.clear();
+
+          text.AddBlock( "short" );
+          text.AddBlock( string );
+          text.AddBlock( "short" );
+
+          if ( REQUIRE( text.GetBlocks().size() == 3U ) )
+          {
+            auto  before = text.GetBlocks()[0].GetCharStr().data();
+            auto  follow = text.GetBlocks()[2].GetCharStr().data();
+
+            REQUIRE( text.GetBlocks()[1].GetCharStr() == string );
+
+          // the long paragraph does not interrupt the chunk being filled
+            REQUIRE( follow > before );
+            REQUIRE( follow < before + 0x100 );
+          }
+        }
+        SECTION( "paragraphs escaping the document stay valid" )
+        {
+          text.clear();
+
+          text.AddBlock( "first" );
+          text.AddMarkupTag( "p" )->AddBlock( "second" );
+          held = text.GetBlocks()[1];
+          text.clear();
+
+          REQUIRE( held.GetCharStr() == "second" );
+
+          text.AddBlock( "third" );
+          text = Text();
+
+          REQUIRE( held.GetCharStr() == "second" );
+        }
+        SECTION( "paragraphs of one chunk may be released by several threads" )
+        {
+          auto  copies = std::vector<std::vector<Paragraph>>( 4 );
+          auto  worker = std::vector<std::thread>();
+          auto  failed = std::atomic_int( 0 );
+
+          text.SetArena( 0x10000 );
+
+          for ( int i = 0; i != 1000; ++i )
+            text.AddBlock( "paragraph" );
+
+        // each thread owns its paragraphs, but not the chunk they live in
+          for ( size_t i = 0; i != text.GetBlocks().size(); ++i )
+            copies[i % copies.size()].push_back( std::move( text.GetBlocks()[i] ) );
+
+          for ( auto& next: copies )
+            worker.emplace_back( [&]( std::vector<Paragraph>& held )
+              {
+                while ( !held.empty() )
+                {
+                  if ( held.back().GetCharStr() != "paragraph" )
+                    ++failed;
+                  held.pop_back();
+                }
+              }, std::ref( next ) );
+
+        // the document keeps allocating from the same chunk
+          for ( int i = 0; i != 1000; ++i )
+            text.AddBlock( "paragraph" );
+          text.clear();
+
+          for ( auto& next: worker )
+            next.join();
+
+          REQUIRE( failed == 0 );
+        }
+        SECTION( "deserialized paragraphs are allocated in arena" )
+        {
+          auto  source = Text{ "aaa", { "p", { "bbb" } }, "ccc" };
+          auto  buffer = std::string();
+
+          text.SetArena( 0x100 );
+          source.Serialize( &buffer );
+
+          if ( REQUIRE_NOTHROW( text.FetchFrom( mtc::sourcebuf( buffer ).ptr() ) ) )
+          {
+            REQUIRE( text.GetBlocks().size() == 3U );
+            REQUIRE( text.GetBlocks()[1].GetCharStr() == "bbb" );
+          }
+        }
+      }
+    }
+    SECTION( "markup tag names are interned" )
+    {
+      auto  text = Text();
+
+      text.AddMarkupTag( "interned-tag" )->AddBlock( "aaa" );
+      text.AddMarkupTag( std::string( "interned-tag" ) )->AddBlock( "bbb" );
+
+      if ( REQUIRE( text.GetMarkup().size() == 2U ) )
+      {
+        REQUIRE( text.GetMarkup()[0].tagKey == text.GetMarkup()[1].tagKey );
+        REQUIRE( text.GetMarkup()[0].tagKey.c_str() == text.GetMarkup()[1].tagKey.c_str() );
+        REQUIRE( text.GetMarkup()[0].tagKey == "interned-tag" );
+        REQUIRE( text.GetMarkup()[0].tagKey == TagKey::Find( "interned-tag" ) );
+      }
+      REQUIRE( TagKey::Find( "non-interned-tag" ).empty() );
+      REQUIRE( text.FindFirst( "non-interned-tag" ) == nullptr );
+      REQUIRE( text.FindFirst( "interned-tag" ) != nullptr );
+      REQUIRE( TagKey().str() == "" );
+
+      SECTION( "the names too long are not interned, but counted by the keys" )
+      {
+        auto  longer = std::string( 0x101, 'x' );
+
+        text.AddMarkupTag( longer )->AddBlock( "ccc" );
+        text.AddMarkupTag( longer )->AddBlock( "ddd" );
+
+        if ( REQUIRE( text.GetMarkup().size() == 4U ) )
+        {
+          REQUIRE( text.GetMarkup()[2].tagKey == text.GetMarkup()[3].tagKey );
+          REQUIRE( text.GetMarkup()[2].tagKey.c_str() == text.GetMarkup()[3].tagKey.c_str() );
+          REQUIRE( text.GetMarkup()[2].tagKey != text.GetMarkup()[0].tagKey );
+          REQUIRE( text.GetMarkup()[2].tagKey == longer );
+        }
+        REQUIRE( TagKey::Find( longer ) == TagKey( longer ) );
+        REQUIRE( text.FindFirst( longer.c_str() ) != nullptr );
+        REQUIRE( text.FindFirst( longer.c_str() )->FindNext() != nullptr );
+
+        SECTION( "* the names are released with the last key" )
+        {
+          auto  copied = text.GetMarkup()[2].tagKey;
+
+          text.clear();
+          REQUIRE( TagKey::Find( longer ) == copied );
+          copied = TagKey();
+          REQUIRE( TagKey::Find( longer ).empty() );
+          copied = TagKey( std::string( 0x101, 'y' ) );
+          REQUIRE( copied == std::string( 0x101, 'y' ).c_str() );
+          REQUIRE( TagKey::Find( longer ).empty() );
+        }
+      }
+      SECTION( "keys are 32-bit ids" )
+      {
+        REQUIRE( sizeof(TagKey) == 4U );
+        REQUIRE( sizeof(MarkupTag) == 12U );
+      }
+    }
+    SECTION( "Text may be replayed to other IText" )
+    {
+      auto  source = Text{ "aaa", { "p", { "b", { "q", { "c" } } } }, { "p", { "dd" } }, "eee" };
+      auto  output = Text();
+
+      if ( REQUIRE_NOTHROW( source.Serialize( (IText*)&output ) ) )
       {
-        auto  arena = mtc::Arena();
-        auto  image = arena.Create<BaseDocument<mtc::Arena::allocator<char>>>();
+        SECTION( "* markup is reproduced, single-character tags too" )
+        {
+          REQUIRE( output.GetMarkup().size() == source.GetMarkup().size() );
 
-        SECTION( "elements are allocated in arena with no need to deallocate" )
+          for ( size_t i = 0; i != output.GetMarkup().size() && i != source.GetMarkup().size(); ++i )
+            REQUIRE( output.GetMarkup()[i] == source.GetMarkup()[i] );
+        }
+        SECTION( "* paragraphs are shared with no copying" )
         {
-          image->AddString( "This is a test string object to be allocated in memory arena" );
-          image->AddString( codepages::mbcstowide( codepages::codepage_utf8,
-            "This is a test widestring to be allocated in memory arena" ) );
+          if ( REQUIRE( output.GetBlocks().size() == source.GetBlocks().size() ) )
+            for ( size_t i = 0; i != output.GetBlocks().size(); ++i )
+              REQUIRE( output.GetBlocks()[i].GetCharStr().data() == source.GetBlocks()[i].GetCharStr().data() );
         }
       }
-      */
     }
     SECTION( "Text may be serialized" )
     {
@@ -170,6 +380,57 @@ TestItEasy::RegisterFunc  test_text( []()
             "ccc\n" );
         }
       }
+      SECTION( "* as compact json and tags" )
+      {
+        auto  output = std::string();
+        auto  option = dump_as::Options{ 0x100, true };
+
+        if ( REQUIRE_NOTHROW( text.Serialize( dump_as::Json( dump_as::MakeOutput( &output ), option ).ptr() ) ) )
+          REQUIRE( output == "[\"aaa\",{\"bbb\":[\"bbb\"]},\"ccc\"]" );
+
+        output.clear();
+
+        if ( REQUIRE_NOTHROW( text.Serialize( dump_as::Tags( dump_as::MakeOutput( &output ), codepages::codepage_utf8, option ).ptr() ) ) )
+          REQUIRE( output == "aaa\n<bbb>\nbbb\n</bbb>\nccc\n" );
+      }
+      SECTION( "* with the output buffered" )
+      {
+        auto  chunks = std::vector<std::string>();
+        auto  joined = std::string();
+        auto  dumper = dump_as::Tags( [&]( const char* p, size_t l ){  chunks.emplace_back( p, l );  },
+          codepages::codepage_utf8, { 8 } );
+
+        text.Serialize( dumper.ptr() );
+
+        for ( auto& next: chunks )
+          joined += next;
+
+        REQUIRE( joined.size() < dump.size() );
+
+        if ( REQUIRE_NOTHROW( dump_as::Flush( dumper ) ) )
+        {
+          auto  nlarge = size_t(0);
+
+          joined.clear();
+
+          for ( auto& next: chunks )
+            nlarge += (joined += next, next.size() > 8 ? 1 : 0);
+
+          REQUIRE( dumper == nullptr );
+          REQUIRE( nlarge == 0U );
+          REQUIRE( chunks.size() > 3U );
+          REQUIRE( joined == dump );
+        }
+      }
+      SECTION( "* with the output errors thrown by Flush()" )
+      {
+        auto  dumper = dump_as::Tags( []( const char*, size_t ){  throw std::runtime_error( "disk full" );  } );
+
+        text.Serialize( dumper.ptr() );
+
+        REQUIRE_EXCEPTION( dump_as::Flush( dumper ), std::runtime_error );
+        REQUIRE_EXCEPTION( dump_as::Flush( dumper ), std::invalid_argument );
+      }
       SECTION( "* as dump" )
       {
         dump.clear();
@@ -177,6 +438,100 @@ TestItEasy::RegisterFunc  test_text( []()
         REQUIRE_NOTHROW( text.Serialize( &dump ) );
         REQUIRE( dump.length() == text.GetBufLen() );
       }
+      SECTION( "* as columnar v2 dump" )
+      {
+        auto  source = Text{ "aaa", { "p", { "bbb", { "q", { "c" } } } }, { "p", { "eee" } } };
+        auto  loaded = Text();
+        auto  output = std::string();
+        auto  expect = std::string();
+        auto  dumpv2 = std::string();
+
+        source.AddMarkupTag( "empty" );
+        source.AddBlock( codepages::mbcstowide( codepages::codepage_utf8, "широкая строка" ) );
+
+        REQUIRE_EXCEPTION( source.Serialize( &dumpv2, 0 ), std::invalid_argument );
+        REQUIRE_EXCEPTION( source.GetBufLen( 0 ), std::invalid_argument );
+        REQUIRE_EXCEPTION( source.GetBufLen( 4 ), std::invalid_argument );
+
+        if ( REQUIRE_NOTHROW( source.Serialize( &dumpv2, ITextView::dump_v2 ) ) )
+        {
+          REQUIRE( dumpv2.length() == source.GetBufLen( ITextView::dump_v2 ) );
+
+          SECTION( "v2 dump is loaded to the same document" )
+          {
+            if ( REQUIRE_NOTHROW( loaded.FetchFrom( mtc::sourcebuf( dumpv2 ).ptr() ) ) )
+            {
+              REQUIRE( loaded.GetLength() == source.GetLength() );
+              REQUIRE( SameMarkup( loaded, source ) );
+
+              loaded.Serialize( dump_as::Tags( dump_as::MakeOutput( &output ) ) );
+              source.Serialize( dump_as::Tags( dump_as::MakeOutput( &expect ) ) );
+
+              REQUIRE( output == expect );
+            }
+            REQUIRE( loaded.FetchFrom( mtc::sourcebuf( dumpv2.data(), dumpv2.size() - 1 ).ptr() ) == nullptr );
+          }
+          SECTION( "v2 dump may be viewed with no copying" )
+          {
+            auto  viewed = view_as::Dump( mtc::CreateByteBuffer( dumpv2.data(), dumpv2.size() ).ptr() );
+
+            if ( REQUIRE( viewed != nullptr ) )
+            {
+              REQUIRE( SameMarkup( *viewed, source ) );
+
+              if ( REQUIRE( viewed->GetBlocks().size() == source.GetBlocks().size() ) )
+                REQUIRE( viewed->GetBlocks().back().GetWideStr() == source.GetBlocks().back().GetWideStr() );
+            }
+            REQUIRE( view_as::Dump( mtc::CreateByteBuffer( dumpv2.data(), dumpv2.size() - 1 ).ptr() ) == nullptr );
+          }
+          SECTION( "truncated and corrupt dumps are rejected" )
+          {
+            auto  failed = 0;
+            auto  length = dumpv2;
+
+            for ( size_t cut = 0; cut != dumpv2.size(); ++cut )
+              if ( loaded.FetchFrom( mtc::sourcebuf( dumpv2.data(), cut ).ptr() ) != nullptr )
+                ++failed;
+
+            REQUIRE( failed == 0 );
+
+          // the text length stored last does not match the blocks
+            length.back() ^= 1;
+
+            REQUIRE( loaded.FetchFrom( mtc::sourcebuf( length ).ptr() ) == nullptr );
+            REQUIRE( view_as::Dump( mtc::CreateByteBuffer( length.data(), length.size() ).ptr() ) == nullptr );
+          }
+          SECTION( "the counts over the data are rejected with no allocation" )
+          {
+            auto  hugev1 = std::string( "\xff\xff\xff\xff\xff\xff\xff\x0f" "\x01\x01" "a", 11 );
+            auto  hugev2 = std::string( "\x00\xff\xff\xff\xff\x0f\x02" "\xff\xff\xff\xff\xff\xff\xff\x0f" "\x01\x01", 17 );
+            auto  hugetg = std::string( "\x00\xff\xff\xff\xff\xff\xff\xff\x0f" "\x01\x61\x00\x00", 13 );
+            auto  hugezz = std::string( "\x00\xff\xff\xff\xff\x0f\x03" "\xff\xff\xff\xff\xff\xff\xff\x0f" "\x01\x01", 17 );
+
+            for ( auto& next: { hugev1, hugev2, hugetg, hugezz } )
+            {
+              if ( REQUIRE_NOTHROW( loaded.FetchFrom( mtc::sourcebuf( next ).ptr() ) ) )
+                REQUIRE( loaded.FetchFrom( mtc::sourcebuf( next ).ptr() ) == nullptr );
+              REQUIRE( view_as::Dump( mtc::CreateByteBuffer( next.data(), next.size() ).ptr() ) == nullptr );
+            }
+          }
+        }
+        SECTION( "documents with no blocks are read in both formats" )
+        {
+          auto  tagged = Text();
+
+          tagged.AddMarkupTag( "empty" );
+
+          for ( auto version: { ITextView::dump_v1, ITextView::dump_v2 } )
+          {
+            dumpv2.clear();
+            tagged.Serialize( &dumpv2, version );
+
+            if ( REQUIRE( loaded.FetchFrom( mtc::sourcebuf( dumpv2 ).ptr() ) != nullptr ) )
+              REQUIRE( SameMarkup( loaded, tagged ) );
+          }
+        }
+      }
       SECTION( "Text keeps the tags order for all the tags including empty" )
       {
         auto  tags = std::string();
@@ -223,6 +578,87 @@ TestItEasy::RegisterFunc  test_text( []()
         REQUIRE( text.GetMarkup().size() == 3U );
       }
 
+      SECTION( "* from the contiguous buffers, the same as from characters" )
+      {
+        auto  escaped = std::string( "[ \"plain\", { \"tag\": [ \"quoted \\\"\\/\\n\\tstring\\\\\" ] }, \"tail\" ]" );
+
+        for ( auto& source: { std::string( json ), escaped } )
+        {
+          auto  bychar = Text();
+          auto  bufstr = Text();
+          auto  bufapi = Text();
+
+          load_as::Json( &bychar, load_as::MakeSource( source.c_str() ) );
+
+          if ( REQUIRE_NOTHROW( load_as::Json( &bufstr, std::string_view( source ) ) )
+            && REQUIRE_NOTHROW( load_as::Json( &bufapi, mtc::CreateByteBuffer( source.data(), source.size() ) ) ) )
+          {
+            REQUIRE( GetJson( bufstr ) == GetJson( bychar ) );
+            REQUIRE( GetJson( bufapi ) == GetJson( bychar ) );
+          }
+        }
+        for ( auto& source: { std::string( tags ), std::string( "text\n<a>\n  <b >\n    x &lt; y\n  </b>\n</a>" ) } )
+        {
+          auto  bychar = Text();
+          auto  bufstr = Text();
+
+          load_as::Tags( &bychar, load_as::MakeSource( source.c_str() ) );
+
+          if ( REQUIRE_NOTHROW( load_as::Tags( &bufstr, std::string_view( source ) ) ) )
+            REQUIRE( GetJson( bufstr ) == GetJson( bychar ) );
+        }
+      }
+
+      SECTION( "* by the structural index, the strings and escapes crossing the 64-byte blocks" )
+      {
+        auto  nmatch = size_t(0);
+        auto  ncheck = size_t(0);
+
+        for ( size_t shift = 0; shift < 70; ++shift )
+          for ( auto escape: { "", "\\\"", "\\\\", "\\\\\\\"", "\\\\\\\\\\n" } )
+          {
+            auto  source = "[" + std::string( shift, ' ' ) + "\"" + std::string( shift % 7, 'x' ) + escape
+              + "\", { \"t\": [ \"" + escape + std::string( 60, 'y' ) + "\" ] }, \"\xd0\xb0\" ]";
+            auto  bychar = Text();
+            auto  bufstr = Text();
+
+            load_as::Json( &bychar, load_as::MakeSource( source.c_str() ) );
+            load_as::Json( &bufstr, std::string_view( source ) );
+
+            nmatch += GetJson( bufstr ) == GetJson( bychar );
+            ++ncheck;
+          }
+        REQUIRE( nmatch == ncheck );
+      }
+
+      SECTION( "* by the structural index built by the chunks for the long sources" )
+      {
+        auto  source = std::string( "[" );
+        auto  bychar = Text();
+        auto  bufstr = Text();
+
+        for ( int i = 0; i != 3000; ++i )
+          source += mtc::strprintf( "{ \"t%d\": [ \"string\\t%d\" ] },\n", i % 7, i );
+
+        load_as::Json( &bychar, load_as::MakeSource( (source += "]").c_str() ) );
+        load_as::Json( &bufstr, std::string_view( source ) );
+
+        if ( REQUIRE( bufstr.GetBlocks().size() == 3000U ) )
+          REQUIRE( GetJson( bufstr ) == GetJson( bychar ) );
+      }
+
+      SECTION( "* from the contiguous buffers with errors reported" )
+      {
+        auto  output = Text();
+
+        REQUIRE_EXCEPTION( load_as::Json( &output, std::string_view( "[ \"unterminated" ) ), load_as::ParseError );
+        REQUIRE_EXCEPTION( load_as::Json( &output, std::string_view( "[ \"escaped\\" ) ), load_as::ParseError );
+        REQUIRE_EXCEPTION( load_as::Json( &output, std::string_view( "[ \"a\", x ]" ) ), load_as::ParseError );
+        REQUIRE_EXCEPTION( load_as::Json( &output, std::string_view( "[ \\\"a\" ]" ) ), load_as::ParseError );
+        REQUIRE_EXCEPTION( load_as::Tags( &output, std::string_view( "<tag" ) ), load_as::ParseError );
+        REQUIRE_EXCEPTION( load_as::Json( &output, mtc::api<const mtc::IByteBuffer>() ), std::invalid_argument );
+      }
+
       SECTION( "* as dump" )
       {
         text.clear();
@@ -230,6 +666,67 @@ TestItEasy::RegisterFunc  test_text( []()
 
         REQUIRE( text.GetBlocks().size() == 3U );
         REQUIRE( text.GetMarkup().size() == 1U );
+        REQUIRE( text.GetLength() == 9U );
+        REQUIRE( text.GetBlockPos( 4 ).block == 1U );
+      }
+    }
+    SECTION( "serialized Text may be viewed with no copying" )
+    {
+      auto  source = Text{ "aaa", { "p", { "bbb", { "q", { "c" } } } }, "ddd" };
+      auto  buffer = std::string();
+      auto  dumped = mtc::api<const mtc::IByteBuffer>();
+      auto  viewed = mtc::api<const ITextView>();
+
+      source.AddBlock( codepages::mbcstowide( codepages::codepage_utf8, "широкая строка" ) );
+      source.Serialize( &buffer );
+      dumped = mtc::CreateByteBuffer( buffer.data(), buffer.size() ).ptr();
+
+      SECTION( "* invalid data is not viewed" )
+      {
+        REQUIRE_EXCEPTION( view_as::Dump( nullptr ), std::invalid_argument );
+        REQUIRE( view_as::Dump( mtc::CreateByteBuffer( buffer.data(), buffer.size() - 1 ).ptr() ) == nullptr );
+        REQUIRE( view_as::Dump( mtc::CreateByteBuffer( "\xff\xff\xff\xff\x0f", 5 ).ptr() ) == nullptr );
+      }
+      if ( REQUIRE_NOTHROW( viewed = view_as::Dump( dumped ) ) && REQUIRE( viewed != nullptr ) )
+      {
+        SECTION( "* blocks and markup are the same" )
+        {
+          auto  output = std::string();
+          auto  expect = std::string();
+
+          REQUIRE( viewed->GetLength() == source.GetLength() );
+          REQUIRE( viewed->GetBlocks().size() == source.GetBlocks().size() );
+          REQUIRE( viewed->GetMarkup().size() == source.GetMarkup().size() );
+
+          viewed->Serialize( dump_as::Tags( dump_as::MakeOutput( &output ) ) );
+          source.Serialize( dump_as::Tags( dump_as::MakeOutput( &expect ) ) );
+
+          REQUIRE( output == expect );
+        }
+        SECTION( "* char strings point to the buffer" )
+        {
+          auto  string = viewed->GetBlocks()[1].GetCharStr();
+
+          REQUIRE( string == "bbb" );
+          REQUIRE( string.data() > dumped->GetPtr() );
+          REQUIRE( string.data() < dumped->GetPtr() + dumped->GetLen() );
+        }
+        SECTION( "* tags are found" )
+        {
+          auto  tagview = viewed->FindFirst( "q" );
+
+          if ( REQUIRE( tagview != nullptr ) && REQUIRE( tagview->GetBlocks().size() == 1U ) )
+            REQUIRE( tagview->GetBlocks()[0].GetCharStr() == "c" );
+        }
+        SECTION( "* paragraphs outlive the view" )
+        {
+          auto  para = viewed->GetBlocks().back();
+
+          viewed = nullptr;
+          dumped = nullptr;
+
+          REQUIRE( para.GetWideStr() == codepages::mbcstowide( codepages::codepage_utf8, "широкая строка" ) );
+        }
       }
     }
     SECTION( "Text may be initialized with initializer list" )
@@ -301,8 +798,146 @@ TestItEasy::RegisterFunc  test_text( []()
               REQUIRE_NOTHROW( tag2view = tag2view->FindNext() ) && REQUIRE( tag2view == nullptr );
             }
           }
+          if ( REQUIRE_NOTHROW( tag1view = tag1view->FindNext() ) && REQUIRE( tag1view != nullptr ) )
+          {
+            REQUIRE( tag1view->GetMarkup().size() == 1 );
+            REQUIRE( tag1view->GetBlocks().size() == 2 );
+            REQUIRE( tag1view->GetBlocks().front().GetCharStr() == "Строка" );
+
+            if ( REQUIRE_NOTHROW( tag2view = tag1view->FindFirst( "tag-2" ) ) && REQUIRE( tag2view != nullptr ) )
+            {
+              REQUIRE( tag2view->GetLength() == tag2view->GetBlocks().front().GetTextSize() );
+              REQUIRE( tag2view->FindNext() == nullptr );
+            }
+            REQUIRE( tag1view->FindNext() == nullptr );
+          }
+        }
+      }
+      SECTION( "* offsets are mapped to blocks" )
+      {
+        auto  blocks = ((const Text&)inText).GetBlocks();
+        auto  offset = blocks[0].GetTextSize() + blocks[1].GetTextSize();
+        auto  blkpos = ITextView::BlockPos();
+
+        blkpos = inText.GetBlockPos( 0 );
+          REQUIRE( blkpos.block == 0U );
+          REQUIRE( blkpos.offset == 0U );
+        blkpos = inText.GetBlockPos( offset + 3 );
+          REQUIRE( blkpos.block == 2U );
+          REQUIRE( blkpos.offset == 3U );
+        blkpos = inText.GetBlockPos( inText.GetLength() );
+          REQUIRE( blkpos.block == blocks.size() );
+
+        SECTION( "* in the views of tags, too" )
+        {
+          auto  tagview = inText.FindFirst( "tag-2" );
+
+          if ( REQUIRE( tagview != nullptr ) )
+          {
+            blkpos = tagview->GetBlockPos( offset + 3 );
+              REQUIRE( blkpos.block == 0U );
+              REQUIRE( blkpos.offset == 3U );
+            blkpos = tagview->GetBlockPos( 0 );
+              REQUIRE( blkpos.block == 0U );
+              REQUIRE( blkpos.offset == 0U );
+            blkpos = tagview->GetBlockPos( inText.GetLength() );
+              REQUIRE( blkpos.block == 2U );
+          }
         }
       }
+      SECTION( "* text ranges are got with no copying" )
+      {
+        auto  blocks = ((const Text&)inText).GetBlocks();
+        auto  offset = blocks[0].GetTextSize() - 3;
+        auto  chunks = inText.GetText( offset, 8 );
+
+        if ( REQUIRE( chunks.size() == 2U ) )
+        {
+          REQUIRE( chunks[0].block == &blocks[0] );
+          REQUIRE( chunks[0].GetCharStr().data() == blocks[0].GetCharStr().data() + offset );
+          REQUIRE( chunks[0].length == 3U );
+          REQUIRE( chunks[1].block == &blocks[1] );
+          REQUIRE( chunks[1].offset == 0U );
+          REQUIRE( chunks[1].length == 5U );
+        }
+
+        REQUIRE( inText.GetText( 0, inText.GetLength() + 100 ).size() == blocks.size() );
+        REQUIRE( inText.GetText( inText.GetLength(), 10 ).empty() );
+
+        SECTION( "* the views with no index get the same ranges" )
+        {
+          auto  inView = BlocksView( inText );
+          auto  viewed = inView.GetText( offset, 8 );
+          auto  blkpos = inView.GetBlockPos( offset + 4 );
+
+          if ( REQUIRE( viewed.size() == 2U ) )
+          {
+            REQUIRE( viewed[0].block == &blocks[0] );
+            REQUIRE( viewed[0].offset == offset );
+            REQUIRE( viewed[0].length == 3U );
+            REQUIRE( viewed[1].block == &blocks[1] );
+            REQUIRE( viewed[1].offset == 0U );
+            REQUIRE( viewed[1].length == 5U );
+          }
+          REQUIRE( blkpos.block == 1U );
+          REQUIRE( blkpos.offset == 1U );
+          REQUIRE( inView.GetBlockPos( inText.GetLength() ).block == blocks.size() );
+          REQUIRE( inView.GetText( 0, inText.GetLength() + 100 ).size() == blocks.size() );
+          REQUIRE( inView.GetText( inText.GetLength(), 10 ).empty() );
+        }
+
+        SECTION( "* the views of tags clip the range" )
+        {
+          auto  tagview = inText.FindFirst( "tag-2" );
+
+          if ( REQUIRE( tagview != nullptr ) )
+          {
+            chunks = tagview->GetText( 0, inText.GetLength() );
+
+            if ( REQUIRE( chunks.size() == 2U ) )
+            {
+              REQUIRE( chunks[0].block == &blocks[2] );
+              REQUIRE( chunks[1].block == &blocks[3] );
+              REQUIRE( chunks[1].length == blocks[3].GetTextSize() );
+            }
+          }
+        }
+      }
+      SECTION( "* tags are found in the modified text" )
+      {
+        auto  tagview = mtc::api<const ITextView>();
+
+        if ( REQUIRE( inText.FindFirst( "tag-3" ) == nullptr ) )
+        {
+          inText.AddMarkupTag( "tag-3" )->AddBlock( "Строка в tag-3" );
+
+          if ( REQUIRE_NOTHROW( tagview = inText.FindFirst( "tag-3" ) ) && REQUIRE( tagview != nullptr ) )
+          {
+            REQUIRE( tagview->GetBlocks().size() == 1 );
+            REQUIRE( tagview->GetBlocks().front().GetCharStr() == "Строка в tag-3" );
+          }
+        }
+      }
+      SECTION( "* offsets follow the blocks changed by the caller" )
+      {
+        auto  blkpos = ITextView::BlockPos();
+        auto  offset = uint32_t(0);
+
+        std::swap( inText.GetBlocks()[0], inText.GetBlocks()[1] );
+
+        blkpos = inText.GetBlockPos( inText.GetBlocks()[0].GetTextSize() + 1 );
+          REQUIRE( blkpos.block == 1U );
+          REQUIRE( blkpos.offset == 1U );
+
+        inText.AddBlock( "appended" );
+
+        for ( auto& next: inText.GetBlocks() )
+          offset += next.GetTextSize();
+
+        blkpos = inText.GetBlockPos( offset - 2 );
+          REQUIRE( blkpos.block == inText.GetBlocks().size() - 1 );
+          REQUIRE( blkpos.offset == 6U );
+      }
     }
   }
 } );
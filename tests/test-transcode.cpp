@@ -0,0 +1,193 @@
+# include "../src/transcode.hpp"
+# include <mtc/test-it-easy.hpp>
+# include <moonycode/codes.h>
+# include <algorithm>
+
+using namespace DeliriX;
+
+TestItEasy::RegisterFunc  test_transcode( []()
+{
+  TEST_CASE( "DeliriX/transcode" )
+  {
+    SECTION( "kernels are selected by the CPU features" )
+    {
+      auto  kernels = std::string( transcode::GetKernelsName() );
+
+      REQUIRE( (kernels == "avx2" || kernels == "sse2" || kernels == "scalar") );
+    }
+    SECTION( "UTF-8 is converted to widechars and back" )
+    {
+      auto  samples = std::vector<std::string>{ "", "a", "plain ASCII text", "текст", "a€b", "emoji 😀 pair" };
+      auto  nmatch = size_t(0);
+      auto  ncheck = size_t(0);
+
+    // build the strings crossing the 16 and 32 bytes strides at any offset
+      for ( size_t prefix = 0; prefix < 70; prefix += 3 )
+        for ( auto suffix: { "", "Ж", "😀", "tail" } )
+          samples.push_back( std::string( prefix, 'x' ) + suffix + std::string( 40 - prefix % 40, 'y' ) );
+
+      for ( auto& next: samples )
+      {
+        auto  widestr = transcode::ToWide( codepages::codepage_utf8, next );
+
+        nmatch += widestr == codepages::mbcstowide( codepages::codepage_utf8, next )
+          && transcode::ToUtf8( widestr ) == next;
+        ++ncheck;
+      }
+      REQUIRE( nmatch == ncheck );
+    }
+    SECTION( "UTF-8 is appended to the string" )
+    {
+      auto  widestr = codepages::mbcstowide( codepages::codepage_utf8, "head " );
+
+      transcode::AppendWide( widestr, codepages::codepage_utf8, "и хвост" );
+
+      REQUIRE( widestr == codepages::mbcstowide( codepages::codepage_utf8, "head и хвост" ) );
+    }
+    SECTION( "UTF-8 is converted to the buffer" )
+    {
+      widechar  buffer[0x40];
+      auto      source = std::string( "буфер" );
+      auto      length = transcode::ToWide( codepages::codepage_utf8, buffer, std::size( buffer ), source );
+
+      if ( REQUIRE( length == 5U ) )
+        REQUIRE( mtc::widestr( buffer, length ) == codepages::mbcstowide( codepages::codepage_utf8, source ) );
+    }
+    SECTION( "invalid UTF-8 is converted by codepages" )
+    {
+      for ( auto next: { "overlong \xc0\xaf", "truncated \xd0", "surrogate \xed\xa0\x80", "bad tail \xd0\x20" } )
+        REQUIRE( transcode::ToWide( codepages::codepage_utf8, next ) == codepages::mbcstowide( codepages::codepage_utf8, next ) );
+    }
+    SECTION( "unpaired surrogates are converted by codepages" )
+    {
+      auto  widestr = mtc::widestr( 20, widechar('a') );
+
+      widestr[17] = 0xd800;
+
+      REQUIRE( transcode::ToUtf8( widestr ) == codepages::widetombcs( codepages::codepage_utf8, widestr ) );
+    }
+    SECTION( "single-byte codepages are converted by the tables" )
+    {
+      auto  source = std::string();
+
+      for ( unsigned c = 0x20; c != 0x100; ++c )
+        source += char(c);
+
+      for ( auto codepage: { codepages::codepage_1251, codepages::codepage_koi8, codepages::codepage_iso } )
+      {
+        REQUIRE( transcode::ToWide( codepage, source ) == codepages::mbcstowide( codepage, source ) );
+        REQUIRE( transcode::ToUtf8( codepage, source ) == codepages::mbcstombcs( codepages::codepage_utf8, codepage, source ) );
+      }
+    }
+    SECTION( "long texts are converted by the chunks not splitting the characters" )
+    {
+      auto  widestr = mtc::widestr();
+      auto  charstr = std::string( 0x3000, 'z' );
+      auto  output = std::string();
+      auto  nparts = size_t(0);
+
+    // the surrogate pairs cross any chunk border
+      while ( widestr.size() < 0x3000 )
+        widestr += u"\xd83d\xde00 текст ";
+
+      transcode::ToUtf8Chunks( widestr, [&]( const std::string_view& s ){  output += s, ++nparts;  } );
+
+      REQUIRE( nparts > 1U );
+      REQUIRE( output == transcode::ToUtf8( widestr ) );
+
+      for ( auto i = 1; i < 0x3000; i += 3 )
+        charstr[i] = char(0xc0 + i % 0x40);
+
+      output.clear();
+      transcode::ToUtf8Chunks( codepages::codepage_1251, charstr, [&]( const std::string_view& s ){  output += s;  } );
+
+      REQUIRE( output == transcode::ToUtf8( codepages::codepage_1251, charstr ) );
+    }
+    SECTION( "json and tags escapes are found at any position" )
+    {
+      auto  nmatch = size_t(0);
+      auto  ncheck = size_t(0);
+
+      for ( size_t length = 1; length < 80; length += 7 )
+        for ( size_t offset = 0; offset <= length; ++offset )
+        {
+          auto  source = std::string( length, 'a' );
+
+        // the bytes out of ASCII and \v are not escaped
+          source[length / 2] = char(0xd0);
+          source[0] = '\v';
+
+        // offset == length means no escape
+          for ( auto chr: { '"', '\\', '/', '\b', '\t', '\n', '\f', '\r' } )
+          {
+            if ( offset != length )
+              source[offset] = chr;
+            nmatch += transcode::FindJsonEscape( source.data(), source.size() ) == offset;
+            ++ncheck;
+          }
+          for ( auto chr: { '<', '>', '&' } )
+          {
+            if ( offset != length )
+              source[offset] = chr;
+            nmatch += transcode::FindTagsEscape( source.data(), source.size() ) == offset;
+            ++ncheck;
+          }
+        }
+      REQUIRE( nmatch == ncheck );
+    }
+    SECTION( "json structural index has the quotes, escapes and the characters out of strings" )
+    {
+      auto  source = std::string( "[ \"a\\\"b\", {\"k\" :\"[v]\"} ]" );
+      auto  buffer = std::vector<const char*>( 0x80 );
+      auto  tokens = std::string();
+      auto  length = transcode::JsonIndex( source.data(), source.size() ).Fill( buffer.data(), buffer.size() );
+
+      for ( size_t i = 0; i != length; ++i )
+        tokens += *buffer[i];
+
+      REQUIRE( tokens == "[\"\\\",{\"\":\"\"}]" );
+
+    // the escapes are carried over the block border
+      source = std::string( 62, ' ' ) + "\"\\\\\\\"\"x";
+
+      if ( REQUIRE( transcode::JsonIndex( source.data(), source.size() ).Fill( buffer.data(), buffer.size() ) == 5U ) )
+      {
+        REQUIRE( buffer[0] - source.data() == 62 );
+        REQUIRE( buffer[1] - source.data() == 63 );
+        REQUIRE( buffer[2] - source.data() == 65 );
+        REQUIRE( buffer[3] - source.data() == 67 );
+        REQUIRE( buffer[4] - source.data() == 68 );
+      }
+    }
+    SECTION( "json structural index is filled by the blocks while the buffer has space" )
+    {
+      auto  source = std::string();
+      auto  buffer = std::vector<const char*>( 0x80 );
+      auto  offset = std::vector<size_t>();
+
+      while ( source.size() < 0x1000 )
+        source += "{ \"tag\": [ \"string\\n\" ] }, ";
+
+      for ( auto index = transcode::JsonIndex( source.data(), source.size() ); ; )
+      {
+        auto  length = index.Fill( buffer.data(), buffer.size() );
+
+        if ( length == 0 )
+          break;
+        for ( size_t i = 0; i != length; ++i )
+          offset.push_back( buffer[i] - source.data() );
+      }
+
+      if ( REQUIRE( offset.size() != 0U ) )
+      {
+        auto  nmatch = size_t(0);
+
+        for ( size_t i = 1; i != offset.size(); ++i )
+          nmatch += offset[i] > offset[i - 1];
+
+        REQUIRE( nmatch == offset.size() - 1 );
+        REQUIRE( offset.size() == size_t(std::count_if( source.begin(), source.end(), []( char c ){  return c > ' ' && !isalpha( c );  } )) );
+      }
+    }
+  }
+} );
@@ -0,0 +1,109 @@
+# include "../formats.hpp"
+# include "../DOM-text.hpp"
+# include "../DOM-dump.hpp"
+# include "mock-buff.hpp"
+# include <mtc/test-it-easy.hpp>
+
+using namespace DeliriX;
+
+auto  XmlToTags( const char* xml ) -> std::string
+{
+  auto  text = Text();
+  auto  tags = std::string();
+
+  ParseXML( &text, mtc::CreateByteBuffer( xml, strlen( xml ) ).ptr() );
+    text.Serialize( dump_as::Tags( dump_as::MakeOutput( &tags ) ) );
+  return tags;
+}
+
+TestItEasy::RegisterFunc  test_xml( []()
+{
+  TEST_CASE( "DeliriX/xml" )
+  {
+    SECTION( "XML parser streams the document to IText" )
+    {
+      SECTION( "with empty buffer, it throws std::invalid_argument" )
+      {
+        Text  text;
+
+        REQUIRE_EXCEPTION( ParseXML( &text, nullptr ), std::invalid_argument );
+      }
+      SECTION( "with empty or invalid document, it throws DeliriX::Error" )
+      {
+        REQUIRE_EXCEPTION( XmlToTags( "  \n" ), Error );
+        REQUIRE_EXCEPTION( XmlToTags( "<a><b></a>" ), Error );
+        REQUIRE_EXCEPTION( XmlToTags( "<a>text" ), Error );
+        REQUIRE_EXCEPTION( XmlToTags( "<a x=1></a>" ), Error );
+        REQUIRE_EXCEPTION( XmlToTags( "<a/><?xml version=\"1.0\"?>" ), Error );
+      }
+      SECTION( "text after the root element is reported as such" )
+      {
+        auto  Reason = []( const char* xml ) -> std::string
+        {
+          try
+          {
+            XmlToTags( xml );
+          }
+          catch ( const Error& xp )
+          {
+            return xp.what();
+          }
+          return "";
+        };
+
+        REQUIRE( Reason( "<a>text</a> trailer" ).find( "text outside the root element' at offset 12" ) != std::string::npos );
+        REQUIRE( Reason( "<a>text" ).find( "unexpected end of text" ) != std::string::npos );
+      }
+      SECTION( "elements are passed as markup tags and text nodes as blocks" )
+      {
+        REQUIRE( XmlToTags(
+          "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n"
+          "<!DOCTYPE body>\n"
+          "<!-- comment -->\n"
+          "<body>\n"
+          "  <p class=\"a\">first</p>\n"
+          "  <empty/>\n"
+          "  <p>second</p>\n"
+          "</body>\n" ) ==
+            "<body>\n"
+            "  <p>\n"
+            "    first\n"
+            "  </p>\n"
+            "  <p>\n"
+            "    second\n"
+            "  </p>\n"
+            "</body>\n" );
+      }
+      SECTION( "whitespace-only nodes are skipped, other text keeps spaces" )
+      {
+        REQUIRE( XmlToTags( "<p>\n  \n</p>" ) == "" );
+        REQUIRE( XmlToTags( "<p>  a b  </p>" ) ==
+          "<p>\n"
+          "    a b  \n"
+          "</p>\n" );
+      }
+      SECTION( "entities and cdata are decoded" )
+      {
+        REQUIRE( XmlToTags( "<p>&lt;&quot;&apos;&amp;&#1071;&#x42F;&unknown;</p>" ) ==
+          "<p>\n"
+          "  &lt;\"'&amp;ЯЯ&amp;unknown;\n"
+          "</p>\n" );
+        REQUIRE( XmlToTags( "<p>&#xD800;&#57343;&#xFFFD;</p>" ) ==
+          "<p>\n"
+          "  \xef\xbf\xbd\xef\xbf\xbd\xef\xbf\xbd\n"
+          "</p>\n" );
+        REQUIRE( XmlToTags( "<p><![CDATA[&amp;]]></p>" ) ==
+          "<p>\n"
+          "  &amp;amp;\n"
+          "</p>\n" );
+      }
+      SECTION( "newlines are normalized" )
+      {
+        REQUIRE( XmlToTags( "<p>a\r\nb\rc</p>" ) ==
+          "<p>\n"
+          "  a\nb\nc\n"
+          "</p>\n" );
+      }
+    }
+  }
+} );
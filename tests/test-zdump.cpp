@@ -0,0 +1,243 @@
+# include "../DOM-zdump.hpp"
+# include "../DOM-text.hpp"
+# include "../DOM-dump.hpp"
+# include "../formats.hpp"
+# include <mtc/byteBuffer.h>
+# include <mtc/test-it-easy.hpp>
+# include <moonycode/codes.h>
+
+using namespace DeliriX;
+
+extern unsigned char  sample_odtzip_buf[];
+extern unsigned       sample_odtzip_len;
+extern unsigned char  sample_docxDeliriX_buf[];
+extern unsigned       sample_docxDeliriX_len;
+extern unsigned char  sample_fb2Panov_buf[];
+extern unsigned       sample_fb2Panov_len;
+
+template <> inline
+auto  Serialize( std::string* to, const void* p, size_t l ) -> std::string*
+  {  return to->append( (const char*)p, l ), to;  }
+
+static  auto  GetTags( const ITextView& text ) -> std::string
+{
+  auto  output = std::string();
+
+  return text.Serialize( dump_as::Tags( dump_as::MakeOutput( &output ) ) ), output;
+}
+
+/*
+  SpliceText( blocks, chunks )
+
+  Makes the single text chunk dump with the head and the tail of the blocks
+  dump and the text chunk of the chunks dump, so the chunk does not match the
+  blocks declared.
+*/
+static  auto  SpliceText( const std::string& blocks, const std::string& chunks ) -> std::string
+{
+  struct Dump
+  {
+    uint32_t  dictid;
+    size_t    ntexts;
+    size_t    rawlen[3];
+    size_t    length[3];
+    size_t    nblock;
+    auto  Load( const std::string& s ) -> const char*
+    {
+      auto    srcptr = s.data();
+      size_t  zeroes, signature, cbdump;
+      unsigned  version;
+
+      srcptr = ::FetchFrom( ::FetchFrom( ::FetchFrom( ::FetchFrom( srcptr, zeroes ), signature ), version ), cbdump );
+      srcptr = ::FetchFrom( ::FetchFrom( srcptr, dictid ), ntexts );
+
+      for ( int i = 0; i != 3; ++i )
+        srcptr = ::FetchFrom( ::FetchFrom( srcptr, rawlen[i] ), length[i] );
+
+      return ::FetchFrom( srcptr, nblock );
+    }
+  };
+
+  auto  dumpOf = Dump();
+  auto  textOf = Dump();
+  auto  blkptr = dumpOf.Load( blocks );
+  auto  txtptr = textOf.Load( chunks ) + textOf.length[0] + textOf.length[1];
+  auto  header = std::string();
+  auto  output = std::string();
+
+  ::Serialize( ::Serialize( &header, dumpOf.dictid ), size_t(1) );
+  ::Serialize( ::Serialize( &header, dumpOf.rawlen[0] ), dumpOf.length[0] );
+  ::Serialize( ::Serialize( &header, dumpOf.rawlen[1] ), dumpOf.length[1] );
+  ::Serialize( ::Serialize( &header, textOf.rawlen[2] ), textOf.length[2] );
+  ::Serialize( &header, dumpOf.nblock );
+
+  header.append( blkptr, dumpOf.length[0] + dumpOf.length[1] );
+  header.append( txtptr, textOf.length[2] );
+
+  ::Serialize( ::Serialize( ::Serialize( ::Serialize( &output,
+    size_t(0) ),
+    ITextView::v2signature ),
+    unsigned(ITextView::dump_z) ),
+    header.size() );
+
+  return output += header;
+}
+
+TestItEasy::RegisterFunc  test_zdump( []()
+{
+  TEST_CASE( "DeliriX/zdump" )
+  {
+    auto  source = Text();
+    auto  zipped = std::string();
+    auto  loaded = Text();
+
+    ParseAny( &source, mtc::CreateByteBuffer( sample_fb2Panov_buf, sample_fb2Panov_len ).ptr() );
+    source.AddBlock( codepages::mbcstowide( codepages::codepage_utf8, "широкая строка" ) );
+
+    SECTION( "Text may be serialized compressed" )
+    {
+      if ( REQUIRE_NOTHROW( source.Serialize( &zipped, ITextView::dump_z ) ) )
+      {
+        REQUIRE( zipped.size() < source.GetBufLen( ITextView::dump_v2 ) / 2 );
+        REQUIRE( zipped.size() <= source.GetBufLen( ITextView::dump_z ) );
+        REQUIRE( source.GetBufLen( ITextView::dump_z ) < source.GetBufLen( ITextView::dump_v2 ) * 2 );
+
+        SECTION( "compressed dump is loaded to the same document" )
+        {
+          if ( REQUIRE( loaded.FetchFrom( mtc::sourcebuf( zipped ).ptr() ) != nullptr ) )
+          {
+            REQUIRE( loaded.GetLength() == source.GetLength() );
+            REQUIRE( GetTags( loaded ) == GetTags( source ) );
+          }
+        }
+        SECTION( "truncated dump is not loaded" )
+        {
+          REQUIRE( loaded.FetchFrom( mtc::sourcebuf( zipped.data(), zipped.size() - 1 ).ptr() ) == nullptr );
+        }
+      }
+    }
+    SECTION( "compressed dump blocks may be read by chunks" )
+    {
+      auto  options = zdump::Options();
+
+      options.chunkSize = 0x400;
+      zipped.clear();
+
+      if ( REQUIRE_NOTHROW( zdump::Serialize( &zipped, source, options ) ) )
+      {
+        REQUIRE( zipped.size() <= zdump::GetBufLen( source, options ) );
+
+        auto  reader = zdump::Reader( mtc::CreateByteBuffer( zipped.data(), zipped.size() ).ptr() );
+        auto  blocks = ((const Text&)source).GetBlocks();
+        auto  markup = ((const Text&)source).GetMarkup();
+
+        REQUIRE( reader.GetBlockCount() == blocks.size() );
+        REQUIRE( reader.GetLength() == source.GetLength() );
+
+        if ( REQUIRE( reader.GetMarkup().size() == markup.size() ) )
+          REQUIRE( std::equal( markup.begin(), markup.end(), reader.GetMarkup().begin() ) );
+
+        SECTION( "* the blocks range is read" )
+        {
+          auto  ranged = reader.GetBlocks( 10, 5 );
+
+          if ( REQUIRE( ranged.size() == 5U ) )
+            for ( size_t i = 0; i != ranged.size(); ++i )
+            {
+              REQUIRE( ranged[i].GetEncoding() == blocks[10 + i].GetEncoding() );
+              REQUIRE( ranged[i].GetCharStr() == blocks[10 + i].GetCharStr() );
+            }
+        }
+        SECTION( "* the range is cut by the blocks count" )
+        {
+          auto  ranged = reader.GetBlocks( blocks.size() - 1, 10 );
+
+          if ( REQUIRE( ranged.size() == 1U ) )
+            REQUIRE( ranged[0].GetWideStr() == blocks.back().GetWideStr() );
+
+          REQUIRE( reader.GetBlocks( blocks.size(), 1 ).empty() );
+        }
+        SECTION( "* all the blocks are read" )
+        {
+          auto  ranged = reader.GetBlocks( 0, size_t(-1) );
+          auto  nmatch = size_t(0);
+
+          if ( REQUIRE( ranged.size() == blocks.size() ) )
+            for ( size_t i = 0; i != ranged.size(); ++i )
+              if ( ranged[i].GetCharStr() == blocks[i].GetCharStr() && ranged[i].GetWideStr() == blocks[i].GetWideStr() )
+                ++nmatch;
+
+          REQUIRE( nmatch == blocks.size() );
+        }
+      }
+      SECTION( "* the other data is not read" )
+      {
+        zipped.clear();
+        source.Serialize( &zipped, ITextView::dump_v2 );
+
+        REQUIRE_EXCEPTION( zdump::Reader( nullptr ), std::invalid_argument );
+        REQUIRE_EXCEPTION( zdump::Reader( mtc::CreateByteBuffer( zipped.data(), zipped.size() ).ptr() ), std::invalid_argument );
+      }
+      SECTION( "* the text chunks not matching the blocks are rejected" )
+      {
+        auto  longer = std::string();
+        auto  shorter = std::string();
+        auto  broken = std::string();
+
+        zdump::Serialize( &longer, Text{ "abcdef" } );
+        zdump::Serialize( &shorter, Text{ "abc" } );
+
+        broken = SpliceText( longer, shorter );
+        REQUIRE_EXCEPTION( zdump::Reader( mtc::CreateByteBuffer( broken.data(), broken.size() ).ptr() ), Error );
+
+        broken = SpliceText( shorter, longer );
+        REQUIRE_EXCEPTION( zdump::Reader( mtc::CreateByteBuffer( broken.data(), broken.size() ).ptr() ), Error );
+
+        broken = SpliceText( longer, longer );
+        REQUIRE_NOTHROW( zdump::Reader( mtc::CreateByteBuffer( broken.data(), broken.size() ).ptr() ) );
+      }
+    }
+    SECTION( "preset dictionaries improve small documents compression" )
+    {
+      auto  samples = std::vector<mtc::api<const ITextView>>();
+      auto  options = zdump::Options();
+      auto  packed = std::string();
+
+      for ( auto& next: {
+        mtc::CreateByteBuffer( sample_odtzip_buf, sample_odtzip_len ),
+        mtc::CreateByteBuffer( sample_docxDeliriX_buf, sample_docxDeliriX_len ) } )
+      {
+        auto  sample = Text::Create();
+
+        ParseAny( sample.ptr(), next.ptr() );
+        samples.push_back( sample.ptr() );
+      }
+
+      if ( REQUIRE_NOTHROW( options.dictionary = zdump::Train( samples, 0x1000 ) )
+        && REQUIRE( options.dictionary != nullptr ) )
+      {
+        REQUIRE( options.dictionary->GetLen() > 0U );
+        REQUIRE( options.dictionary->GetLen() <= 0x1000U );
+
+        zipped.clear();
+        zdump::Serialize( &zipped, *samples[0] );
+        zdump::Serialize( &packed, *samples[0], options );
+
+        REQUIRE( packed.size() < zipped.size() );
+        REQUIRE( packed.size() <= zdump::GetBufLen( *samples[0], options ) );
+
+        SECTION( "* unknown dictionary is reported" )
+        {
+          REQUIRE_EXCEPTION( loaded.FetchFrom( mtc::sourcebuf( packed ).ptr() ), Error );
+        }
+        SECTION( "* registered dictionary is used" )
+        {
+          REQUIRE_NOTHROW( zdump::AddDictionary( options.dictionary ) );
+
+          if ( REQUIRE( loaded.FetchFrom( mtc::sourcebuf( packed ).ptr() ) != nullptr ) )
+            REQUIRE( GetTags( loaded ) == GetTags( *samples[0] ) );
+        }
+      }
+    }
+  }
+} );
@@ -5,13 +5,102 @@
 # include <mtc/span.hpp>
 # include <functional>
 # include <map>
+# include <vector>
+# include <memory>
+# include <stdexcept>
+# include <string>
+# include <string_view>
 
 namespace DeliriX
 {
 
+  /*
+    TagKey - interned markup tag name.
+
+    Documents use a few dozen distinct tag names, so the names are kept once
+    in the process-wide dictionary and a tag key is just a 32-bit id in it;
+    keys are compared and hashed by the id and cost no allocation to copy.
+
+    Dictionary entries are never released, so the dictionary is bounded by
+    the count and the length of the names: the names over the limits, fed by
+    untrusted documents, get the ids of the side table with the high bit set,
+    counted by the keys and released with the last one.
+  */
+  class TagKey
+  {
+    enum: uint32_t
+    {
+      counted = 0x80000000      // the id of the side table entry
+    };
+
+    uint32_t  keyid = 0;        // 0 for the empty name
+
+  public:
+    struct Hash
+    {
+      auto  operator()( const TagKey& k ) const -> size_t {  return k.keyid;  }
+    };
+
+  public:
+    TagKey() = default;
+    TagKey( TagKey&& k ): keyid( k.keyid )    {  k.keyid = 0;  }
+    TagKey( const TagKey& k ): keyid( k.keyid ) {  if ( keyid & counted ) Attach( keyid );  }
+   ~TagKey()                                  {  if ( keyid & counted ) Detach( keyid );  }
+    explicit TagKey( const std::string_view& );
+    explicit TagKey( const char* s ): TagKey( std::string_view( s ) ) {}
+
+    TagKey& operator = ( TagKey&& );
+    TagKey& operator = ( const TagKey& );
+
+  // returns the key if the name is already interned, or the empty key
+    static  auto  Find( const std::string_view& ) -> TagKey;
+
+    auto  str() const -> const std::string&;
+    auto  c_str() const -> const char*      {  return str().c_str();  }
+    auto  size() const -> size_t            {  return str().size();  }
+    bool  empty() const                     {  return keyid == 0;  }
+
+    operator std::string_view() const       {  return str();  }
+
+  // the names are never both in the dictionary and in the side table, so the ids are unique
+    bool  operator == ( const TagKey& k ) const           {  return keyid == k.keyid;  }
+    bool  operator != ( const TagKey& k ) const           {  return keyid != k.keyid;  }
+    bool  operator == ( const char* s ) const             {  return str() == s;  }
+    bool  operator != ( const char* s ) const             {  return str() != s;  }
+    bool  operator == ( const std::string_view& s ) const {  return str() == s;  }
+    bool  operator != ( const std::string_view& s ) const {  return str() != s;  }
+
+  private:
+    static  void  Attach( uint32_t );
+    static  void  Detach( uint32_t );
+  };
+
+  // TagKey implementation
+
+  inline  TagKey& TagKey::operator = ( TagKey&& k )
+  {
+    if ( this != &k )
+    {
+      if ( keyid & counted )
+        Detach( keyid );
+      keyid = k.keyid;
+      k.keyid = 0;
+    }
+    return *this;
+  }
+
+  inline  TagKey& TagKey::operator = ( const TagKey& k )
+  {
+    if ( k.keyid & counted )
+      Attach( k.keyid );
+    if ( keyid & counted )
+      Detach( keyid );
+    return keyid = k.keyid, *this;
+  }
+
   struct MarkupTag
   {
-    std::string tagKey;
+    TagKey      tagKey;
     uint32_t    uLower;
     uint32_t    uUpper;
 
@@ -21,15 +110,49 @@ namespace DeliriX
       {  return !(*this == r);  }
   };
 
+  struct ParagraphCtl;
+  class TextIndex;
+
+  /*
+    ParagraphArena - bump allocator for the paragraph bodies of a document.
+
+    Paragraphs are cut from large chunks instead of separate heap blocks;
+    each chunk counts the paragraphs living in it and is freed with the last
+    one, so the paragraphs copied out of the document stay valid after the
+    arena is reset or destroyed. Paragraphs longer than a chunk get blocks of
+    their own and do not interrupt the chunk being filled.
+  */
+  class ParagraphArena
+  {
+    friend struct ParagraphCtl;
+
+  public:
+    struct Chunk;
+
+    ParagraphArena( size_t chunkSize = 0x10000 );
+    ParagraphArena( const ParagraphArena& ) = delete;
+   ~ParagraphArena();
+
+  // releases the current chunk; next allocations start a new one
+    void  Reset();
+
+  protected:
+    auto  Allocate( size_t, Chunk*& ) -> void*;
+
+  protected:
+    Chunk*  chunk = nullptr;
+    size_t  csize;
+
+  };
+
   class Paragraph
   {
     friend class IText;
+    friend struct ParagraphCtl;
 
-    union
-    {
-      const char*     charstr;
-      const widechar* widestr;
-    };
+  // the refcounted header referencing the text, either following the header
+  // or external, e.g. in a serialized document buffer
+    ParagraphCtl* pctl;
 
   public:
     Paragraph();
@@ -47,7 +170,26 @@ namespace DeliriX
 
     size_t    GetBufLen() const;
     bool      Serialize( std::function<bool( const void*, size_t )> ) const;
-    bool      FetchFrom( std::function<bool( void*, size_t )> );
+    bool      FetchFrom( std::function<bool( void*, size_t )>, ParagraphArena* = nullptr );
+
+  // fetches the text only, the encoding and the length are known
+    bool      FetchFrom( uint32_t encoding, uint32_t length, std::function<bool( void*, size_t )>, ParagraphArena* = nullptr );
+  };
+
+  /*
+    TextChunk - a characters range of a paragraph referencing the paragraph
+    with no text copied.
+  */
+  struct TextChunk
+  {
+    const Paragraph*  block;
+    uint32_t          offset;
+    uint32_t          length;
+
+    auto  GetCharStr() const -> std::string_view
+      {  auto s = block->GetCharStr();  return s.empty() ? s : s.substr( offset, length );  }
+    auto  GetWideStr() const -> std::basic_string_view<widechar>
+      {  auto s = block->GetWideStr();  return s.empty() ? s : s.substr( offset, length );  }
   };
 
   struct IText: mtc::Iface
@@ -70,6 +212,13 @@ namespace DeliriX
     auto  AddBlock( const wide_string_view& str ) -> Paragraph
       {  return AddBlock( str.data(), str.size() );  }
     auto  AddBlock( const widechar* str, uint32_t len ) -> Paragraph;
+
+  protected:
+  // the arena to allocate the paragraphs added by AddBlock(), if any
+    virtual auto  GetArena() -> ParagraphArena*  {  return nullptr;  }
+  // the arena of the other output, for the wrappers forwarding to it
+    static  auto  GetArenaOf( IText* text ) -> ParagraphArena*
+      {  return text != nullptr ? text->GetArena() : nullptr;  }
   };
 
   struct ITextView: mtc::Iface
@@ -81,18 +230,85 @@ namespace DeliriX
     virtual auto    FindFirst( const char* tag ) const -> mtc::api<ITextView>;
     virtual auto    FindNext() const -> mtc::api<ITextView>;
 
-    auto    GetBufLen() const -> size_t;
+  /*
+    Offsets are in the markup coordinates, i.e. the document characters
+    offsets, for both the documents and the views of found tags.
+
+    GetBlockPos() returns the index in GetBlocks() of the block containing
+    the offset and the offset in this block; offsets out of the view get
+    the nearest view limit.
+
+    GetText() lists the block parts covering the characters range.
+  */
+    struct BlockPos
+    {
+      size_t    block;
+      uint32_t  offset;
+    };
+
+    virtual auto    GetBlockPos( uint32_t offset ) const -> BlockPos;
+    virtual auto    GetText( uint32_t offset, uint32_t length ) const -> std::vector<TextChunk>;
+
+  protected:
+  // the index used by FindFirst(); the default one is built on each call,
+  // documents may cache it while unchanged and then override GetBlockPos()
+  // and GetText() to use it
+    virtual auto    GetIndex() const -> std::shared_ptr<const TextIndex>;
+
+  public:
+  /*
+    Serialization formats.
+
+    The v1 dump is the list of the paragraph records followed by the list of
+    the tag records, each tag with its full name.
+
+    The v2 dump is columnar: the encodings and the lengths of the blocks go
+    in two columns followed by the text of all the blocks as one blob, then
+    the table of the tag names used, and the markup as the columns of the
+    name indices, the uLower deltas and the tag lengths. It starts with the
+    empty v1 blocks list followed by the v1 markup count no v1 dump may have,
+    so the readers tell one from another with no lookahead.
+
+    The dump_z dump is the v2 one deflated by independent chunks, see the
+    DOM-zdump.hpp; it has the same signature with the other version. It is
+    packed with the default zdump::Options, so zdump::Serialize() is to be
+    called for the preset dictionary or the other chunk size. GetBufLen()
+    returns the upper bound of its size, not the size itself.
+  */
+    enum: unsigned
+    {
+      dump_v1 = 1,
+      dump_v2 = 2,
+      dump_z = 3
+    };
+
+    static constexpr size_t v2signature = 0xffffffff;
+
+    auto    GetBufLen( unsigned version = dump_v1 ) const -> size_t;
   template <class O>
-    O*      Serialize( O* ) const;
+    O*      Serialize( O*, unsigned version = dump_v1 ) const;
     IText*  Serialize( IText* ) const;
+
+  protected:
+    bool    SerializeV2( std::function<bool( const void*, size_t )> ) const;
+    bool    SerializeZ( std::function<bool( const void*, size_t )> ) const;
+    auto    GetBufLenZ() const -> size_t;
   };
 
   bool  IsEncoded( const ITextView&, uint32_t encoding );
   auto  CopyUtf16( IText*, const ITextView&, uint32_t default_encoding = 0 ) -> IText*;
 
   template <class O>
-  O*    ITextView::Serialize( O* o ) const
+  O*    ITextView::Serialize( O* o, unsigned version ) const
   {
+    if ( version == dump_v2 )
+      return SerializeV2( [&]( const void* p, size_t l ){  return (o = ::Serialize( o, p, l )) != nullptr;  } ) ? o : nullptr;
+    if ( version == dump_z )
+      return SerializeZ( [&]( const void* p, size_t l ){  return (o = ::Serialize( o, p, l )) != nullptr;  } ) ? o : nullptr;
+
+    if ( version != dump_v1 )
+      throw std::invalid_argument( "ITextView::Serialize unknown dump version" );
+
     auto  blocks = GetBlocks();
     auto  markup = GetMarkup();
     auto  length = GetLength();
@@ -108,7 +324,7 @@ namespace DeliriX
     for ( auto& tag: markup )
     {
       o = ::Serialize( ::Serialize( ::Serialize( o,
-        tag.tagKey ),
+        tag.tagKey.str() ),
         tag.uLower ),
         tag.uUpper );
     }
@@ -0,0 +1,29 @@
+# if !defined( __DeliriX_trace_hpp__ )
+# define __DeliriX_trace_hpp__
+# include <string>
+
+namespace DeliriX {
+namespace trace {
+
+  /*
+    The parse pipeline trace: with the trace started, the pipeline stages
+    (archive open, member inflate, xml parse, format adapters, dumps and the
+    batch documents) record the timed events to the ring buffer of the thread
+    running them, with no locks; the ring keeps the last ringSize events of
+    the thread, the older ones are dropped.
+
+    Flush() collects the events recorded since the previous Flush() by all
+    the threads, the finished ones too, as the Chrome Trace Event JSON that
+    may be loaded to Perfetto or chrome://tracing; it may be called while the
+    threads are running.
+
+    With the trace stopped, the events cost one atomic flag check.
+  */
+  void  Start( size_t ringSize = 0x10000 );
+  void  Stop();
+  bool  Enabled();
+  auto  Flush() -> std::string;
+
+}}
+
+# endif   // !__DeliriX_trace_hpp__